@@ -91,8 +91,10 @@ function clink._diagnostics(rl_buffer)
     local arg = rl_buffer:getargument()
     clink._diag_coroutines()
     clink._diag_refilter()
+    clink._diag_completions()
     clink._diag_events(arg)
     if arg then
+        clink._diag_gc()
         clink._diag_prompts()
         clink._diag_generators()
         clink._diag_classifiers()
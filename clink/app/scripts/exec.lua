@@ -120,7 +120,6 @@ function exec_generator:generate(line_state, match_builder)
     end
 
     local add_files = function(pattern, rooted)
-        local any_added = false
         local root = nil
         if rooted then
             root = (path.getdirectory(pattern) or ""):gsub("/", "\\")
@@ -128,11 +127,7 @@ function exec_generator:generate(line_state, match_builder)
                 root = rl.collapsetilde(root)
             end
         end
-        for _, f in ipairs(os.globfiles(pattern, true)) do
-            local file = (root and path.join(root, f.name)) or f.name
-            any_added = match_builder:addmatch({ match = file, type = f.type }) or any_added
-        end
-        return any_added
+        return match_builder:addglob(pattern, root) > 0
     end
 
     -- Include files.
@@ -162,10 +157,7 @@ function exec_generator:generate(line_state, match_builder)
         if expanded then
             root = rl.collapsetilde(root)
         end
-        for _, d in ipairs(os.globdirs(text.."*", true)) do
-            local dir = path.join(root, d.name)
-            match_builder:addmatch({ match = dir, type = d.type })
-        end
+        match_builder:addglob(text.."*", root, true)
     end
 
     return true
@@ -5,6 +5,7 @@
 clink = clink or {}
 local prompt_filters = {}
 local prompt_filters_unsorted = false
+local prompt_filters_serial = 0
 
 if settings.get("lua.debug") or clink.DEBUG then
     clink.debug = clink.debug or {}
@@ -16,6 +17,7 @@ end
 --------------------------------------------------------------------------------
 local prompt_filter_current = nil       -- Current running prompt filter.
 local prompt_filter_coroutines = {}     -- Up to one coroutine per prompt filter, with cached return value.
+local prompt_filter_pending = false     -- True if a prompt coroutine hasn't finished yet.
 
 --------------------------------------------------------------------------------
 local function set_current_prompt_filter(filter)
@@ -26,14 +28,19 @@ end
 
 
 --------------------------------------------------------------------------------
-local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
-    -- Sort by priority if required.
+local function sort_prompt_filters()
     if prompt_filters_unsorted then
         local lambda = function(a, b) return a._priority < b._priority end
         table.sort(prompt_filters, lambda)
 
         prompt_filters_unsorted = false
     end
+end
+
+--------------------------------------------------------------------------------
+local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
+    -- Sort by priority if required.
+    sort_prompt_filters()
 
     local filter_func_name = type.."filter"
     local right_filter_func_name = type.."rightfilter"
@@ -41,6 +48,7 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
     -- Protected call to prompt filters.
     local impl = function(prompt, rprompt)
         local filtered, onwards
+        local tracing = clink._is_tracing()
         for _, filter in ipairs(prompt_filters) do
             set_current_prompt_filter(filter)
 
@@ -51,7 +59,9 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
             local func
             func = filter[filter_func_name]
             if func or #type == 0 then
+                local begin = tracing and clink._trace_begin()
                 filtered, onwards = func(filter, prompt)
+                if begin then clink._trace_end("prompt filter", func, begin) end
                 if filtered ~= nil then
                     prompt = filtered
                     if onwards == false then return prompt, rprompt end
@@ -60,7 +70,9 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
 
             func = filter[right_filter_func_name]
             if func then
+                local begin = tracing and clink._trace_begin()
                 filtered, onwards = func(filter, rprompt)
+                if begin then clink._trace_end("prompt filter", func, begin) end
                 if filtered ~= nil then
                     rprompt = filtered
                     if onwards == false then return prompt, rprompt end
@@ -80,6 +92,7 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
     end
 
     set_current_prompt_filter(nil)
+    prompt_filter_pending = false
     local ok, ret, rret = xpcall(impl, _error_handler_ret, prompt, rprompt)
     set_current_prompt_filter(nil)
 
@@ -92,7 +105,9 @@ local function _do_filter_prompt(type, prompt, rprompt, line, cursor, final)
         return false
     end
 
-    return ret, rret
+    -- The third return value tells the host whether it can reuse the result
+    -- (see clink._get_prompt_dependencies).
+    return ret, rret, not prompt_filter_pending
 end
 
 --------------------------------------------------------------------------------
@@ -105,6 +120,44 @@ function clink._filter_transient_prompt(prompt, rprompt, line, cursor, final)
     return _do_filter_prompt("transient", prompt, rprompt, line, cursor, final)
 end
 
+--------------------------------------------------------------------------------
+-- Returns the union of the dependencies declared by the prompt filters, or nil
+-- if any prompt filter hasn't declared its dependencies.  The host reuses the
+-- previous filtered prompt while none of the dependencies have changed.  The
+-- ids of the prompt filters are included, so that adding a prompt filter (or
+-- changing the order) doesn't reuse a prompt from before.
+function clink._get_prompt_dependencies()
+    sort_prompt_filters()
+
+    local cwd, exitcode
+    local filters, env, paths = {}, {}, {}
+    local seen_env, seen_paths = {}, {}
+    for _, filter in ipairs(prompt_filters) do
+        local deps = filter.dependencies
+        if type(deps) ~= "table" then
+            return
+        end
+        table.insert(filters, filter._id)
+        cwd = cwd or deps.cwd
+        exitcode = exitcode or deps.exitcode
+        for _, name in ipairs(deps.env or {}) do
+            local key = name:lower()
+            if not seen_env[key] then
+                seen_env[key] = true
+                table.insert(env, name)
+            end
+        end
+        for _, path in ipairs(deps.paths or {}) do
+            if not seen_paths[path] then
+                seen_paths[path] = true
+                table.insert(paths, path)
+            end
+        end
+    end
+
+    return { filters=filters, cwd=cwd, exitcode=exitcode, env=env, paths=paths }
+end
+
 --------------------------------------------------------------------------------
 function clink._diag_refilter()
     local refilter,redisplay = clink.get_refilter_redisplay_count()
@@ -128,6 +181,21 @@ end
 --- further prompt filtering by also returning false.  See
 --- <a href="#customisingtheprompt">Customizing the Prompt</a> for more
 --- information.
+---
+--- Starting in v1.3.13 a prompt filter can optionally declare what its output
+--- depends on, by setting a <code>dependencies</code> table on the object.  If
+--- every prompt filter declares its dependencies, then Clink reuses the
+--- previous filtered prompt until one of them changes, instead of running the
+--- prompt filters again.  The table can contain:
+--- <table>
+--- <tr><th>Field</th><th>Description</th></tr>
+--- <tr><td><code>cwd</code></td><td>True if the output depends on the current directory.</td></tr>
+--- <tr><td><code>exitcode</code></td><td>True if the output depends on the last command's exit code (see <a href="#os.geterrorlevel">os.geterrorlevel()</a>).</td></tr>
+--- <tr><td><code>env</code></td><td>A table of environment variable names the output depends on.</td></tr>
+--- <tr><td><code>paths</code></td><td>A table of files or directories whose size or modification time the output depends on; relative paths are relative to the current directory.</td></tr>
+--- </table>
+--- An empty table means the output depends only on the incoming prompt
+--- string.
 --- -show:  local foo_prompt = clink.promptfilter(80)
 --- -show:  function foo_prompt:filter(prompt)
 --- -show:  &nbsp;   -- Insert the date at the beginning of the prompt.
@@ -136,7 +204,9 @@ end
 function clink.promptfilter(priority)
     if priority == nil then priority = 999 end
 
-    local ret = { _priority = priority }
+    prompt_filters_serial = prompt_filters_serial + 1
+
+    local ret = { _priority = priority, _id = prompt_filters_serial }
     table.insert(prompt_filters, ret)
 
     prompt_filters_unsorted = true
@@ -332,5 +402,8 @@ function clink.promptcoroutine(func)
     end
 
     -- Return the result, if any.
+    if not entry.done then
+        prompt_filter_pending = true
+    end
     return entry.result
 end
@@ -15,6 +15,7 @@
 #include <core/auto_free_str.h>
 #include <core/path.h>
 #include <core/log.h>
+#include <core/trace.h>
 #include <assert.h>
 
 #include <new>
@@ -367,6 +368,7 @@ public:
 
     explicit                read_lock() = default;
     explicit                read_lock(const bank_handles& handles, bool exclusive=false);
+    unsigned int            get_file_size() const;
     line_id_impl            find(const char* line) const;
     template <class T> void find(const char* line, T&& callback) const;
     int                     apply_removals(write_lock& lock) const;
@@ -401,6 +403,16 @@ read_lock::read_lock(const bank_handles& handles, bool exclusive)
 {
 }
 
+//------------------------------------------------------------------------------
+unsigned int read_lock::get_file_size() const
+{
+    if (!m_handle_lines)
+        return 0;
+
+    const DWORD size = GetFileSize(m_handle_lines, nullptr);
+    return (size == INVALID_FILE_SIZE) ? 0 : size;
+}
+
 //------------------------------------------------------------------------------
 template <class T> void read_lock::find(const char* line, T&& callback) const
 {
@@ -1354,8 +1366,15 @@ void history_db::load_internal()
             extract_ctag(lock, m_master_ctag);
         }
 
+        // Size Readline's history list and an arena for the entries up front,
+        // rather than allocating several times per line.  The line count is
+        // only an estimate; the list grows as needed.
+        const unsigned int file_size = lock.get_file_size();
+        begin_history_bulk_load(file_size / 32, file_size);
+        m_index_map.reserve(m_index_map.size() + file_size / 32);
+
         // Subtract 1 from the size to accommodate the forced NUL termination
-        // prior to calling add_history.
+        // prior to calling add_history_bulk.
         read_lock::line_iter iter(lock, buffer.data(), buffer.size() - 1);
 
         dbg_snapshot_heap(snapshot);
@@ -1368,7 +1387,7 @@ void history_db::load_internal()
             const char* line = out.get_pointer();
             int buffer_offset = int(line - buffer.data());
             buffer.data()[buffer_offset + out.length()] = '\0';
-            add_history(line);
+            add_history_bulk(line, out.length());
 
             num_lines++;
 
@@ -1381,6 +1400,8 @@ void history_db::load_internal()
             }
         }
 
+        end_history_bulk_load();
+
         dbg_ignore_since_snapshot(snapshot, "History");
 
         if (bank_index == bank_master)
@@ -1397,6 +1418,8 @@ void history_db::load_internal()
 //------------------------------------------------------------------------------
 void history_db::load_rl_history(bool can_clean)
 {
+    TRACE_SCOPE("history load");
+
     load_internal();
 
     // The `clink history` command needs to be able to avoid cleaning the master
@@ -14,6 +14,7 @@
 #include <core/str_compare.h>
 #include <core/str_tokeniser.h>
 #include <core/str_transform.h>
+#include <core/trace.h>
 #include <core/log.h>
 #include <core/debugheap.h>
 #include <core/callstack.h>
@@ -134,6 +135,16 @@ static setting_bool g_get_errorlevel(
     "default.",
     true);
 
+static setting_bool g_debug_trace(
+    "debug.trace",
+    "Record timings of internal stages",
+    "When this is on, Clink records how long it spends loading history, running\n"
+    "prompt filters, match generators, and classifiers, selecting and sorting\n"
+    "matches, and redisplaying the input line.  The 'clink-dump-trace' command\n"
+    "writes the recent timings to a file that can be opened in chrome://tracing\n"
+    "or ui.perfetto.dev.",
+    false);
+
 #ifdef DEBUG
 static setting_bool g_debug_heap_stats(
     "debug.heap_stats",
@@ -461,6 +472,15 @@ bool host::suggest(line_state& line, matches* matches, int generation_id)
     return false;
 }
 
+//------------------------------------------------------------------------------
+bool host::generate_async(line_state& line, int generation_id)
+{
+    if (m_suggester)
+        return m_suggester->generate_async(line, generation_id);
+
+    return false;
+}
+
 //------------------------------------------------------------------------------
 void host::filter_matches(char** matches)
 {
@@ -569,6 +589,7 @@ bool host::edit_line(const char* prompt, const char* rprompt, str_base& out)
     app->get_state_dir(state_dir);
     settings::load(settings_file.c_str(), default_settings_file.c_str());
     reset_keyseq_to_name_map();
+    trace::enable(g_debug_trace.get());
 
     // Set up the string comparison mode.
     static_assert(str_compare_scope::exact == 0, "g_ignore_case values must match str_compare_scope values");
@@ -21,6 +21,7 @@
 #include <lib/doskey.h>
 #include <lib/line_buffer.h>
 #include <lib/line_editor.h>
+#include <lib/word_collector.h>
 #include <lua/lua_script_loader.h>
 #include <terminal/terminal_helpers.h>
 
@@ -259,6 +260,7 @@ void host_load_app_scripts(lua_state& lua)
 {
     s_deprecated_argmatchers.clear();
     s_deprecated_argmatchers_store.reset();
+    word_collector::notify_state_changed();
 
     lua_load_script(lua, app, cmd);
     lua_load_script(lua, app, commands);
@@ -280,6 +282,7 @@ void host_mark_deprecated_argmatcher(const char* command)
         dbg_ignore_scope(snapshot, "deprecated argmatcher lookup");
         const char* store = s_deprecated_argmatchers_store.store(command);
         s_deprecated_argmatchers.insert(store);
+        word_collector::notify_state_changed();
     }
 }
 
@@ -5,6 +5,8 @@
 #include "host_lua.h"
 #include "utils/app_context.h"
 
+#include <lua/lua_completions.h>
+
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -85,6 +87,7 @@ bool host_lua::load_scripts(const char* paths)
     os::high_resolution_clock clock;
     unsigned num_loaded = 0;
     unsigned num_failed = 0;
+    unsigned num_deferred = 0;
 
     bool first = true;
 
@@ -130,12 +133,15 @@ bool host_lua::load_scripts(const char* paths)
         seen_strings.emplace_back(std::move(out));
 
         load_script(token.c_str(), num_loaded, num_failed);
+        num_deferred += lua_completions_add_dir(m_state, token.c_str());
     }
 
     if (num_failed)
         LOG("Loaded %u Lua scripts in %u ms (%u failed)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed);
     else
         LOG("Loaded %u Lua scripts in %u ms", num_loaded, unsigned(clock.elapsed() * 1000));
+    if (num_deferred)
+        LOG("Deferred %u completion scripts until their commands are used", num_deferred);
 
     return true;
 }
@@ -5,10 +5,13 @@
 #include "utils/app_context.h"
 #include "version.h"
 
+#include <core/globber.h>
 #include <core/str.h>
+#include <core/str_tokeniser.h>
 #include <core/settings.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <lua/lua_completions.h>
 #include <getopt.h>
 
 //------------------------------------------------------------------------------
@@ -30,6 +33,36 @@ static void print_info_line(HANDLE h, const char* s)
     }
 }
 
+//------------------------------------------------------------------------------
+// Counts the scripts that are loaded when Lua is initialised, versus scripts in
+// completions directories that are deferred until their commands are used.
+static bool get_script_counts(const char* paths, unsigned int& loaded, unsigned int& deferred)
+{
+    loaded = 0;
+    deferred = 0;
+
+    str<280> token;
+    str_moveable buffer;
+    str_tokeniser tokens(paths, ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+        if (token.empty())
+            continue;
+
+        path::join(token.c_str(), "*.lua", buffer);
+        globber lua_globs(buffer.c_str());
+        lua_globs.directories(false);
+        while (lua_globs.next(buffer))
+            loaded++;
+
+        if (const auto manifest = completions_manifest::get(token.c_str()))
+            deferred += manifest->count();
+    }
+
+    return loaded || deferred;
+}
+
 //------------------------------------------------------------------------------
 int clink_info(int argc, char** argv)
 {
@@ -93,6 +126,15 @@ int clink_info(int argc, char** argv)
         print_info_line(h, s.c_str());
     }
 
+    // Script counts.
+    {
+        str<> script_path;
+        context->get_script_path(script_path);
+        unsigned int loaded, deferred;
+        if (get_script_counts(script_path.c_str(), loaded, deferred))
+            printf("%-*s : %u loaded at startup, %u deferred\n", spacing, "script counts", loaded, deferred);
+    }
+
     // Inputrc environment variables.
     static const char* const env_vars[] = {
         "clink_inputrc",
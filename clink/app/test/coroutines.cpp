@@ -99,6 +99,18 @@ TEST_CASE("Lua coroutines.")
             _refilter = true\
         end\
         \
+        local function make_fake_file(yieldguard)\
+            local meta = {}\
+            meta.__index = meta\
+            function meta:_ready()\
+                return not yieldguard or yieldguard:ready()\
+            end\
+            function meta:read()\
+                return nil\
+            end\
+            return setmetatable({}, meta)\
+        end\
+        \
         function io.popenyield_internal(command, mode)\
             local yieldguard = { _ready=false, _command=command }\
             function yieldguard:ready()\
@@ -113,12 +125,12 @@ TEST_CASE("Lua coroutines.")
             _yieldguard = yieldguard\
             _ran = _ran..'|'..command\
             _command = command\
-            return 'fake_file', yieldguard\
+            return make_fake_file(yieldguard), yieldguard\
         end\
         \
         function io.popen(command, mode)\
             _ran = _ran..'|'..command\
-            return 'fake_file'\
+            return make_fake_file()\
         end\
         \
         function verify_wait_duration_nil()\
@@ -227,8 +239,11 @@ TEST_CASE("Lua coroutines.")
             local gen = _gen\
             local f\
             f = io.popenyield(gen..'aaa')\
+            f:read('*a')\
             f = io.popenyield(gen..'bbb')\
+            f:read('*a')\
             f = io.popenyield(gen..'ccc')\
+            f:read('*a')\
             return gen..'zzz'\
         end\
         \
@@ -17,7 +17,11 @@
 #include <initializer_list>
 
 extern "C" {
+#include <compat/config.h>
+#include <readline/readline.h>
 #include <readline/history.h>
+#include <readline/rldefs.h>
+#include <readline/rlprivate.h>
 };
 
 //------------------------------------------------------------------------------
@@ -918,3 +922,87 @@ TEST_CASE("history removals ctag")
         }
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("history bulk load")
+{
+    clear_history();
+
+    // Underestimate the count so the list has to grow, and add enough text to
+    // need more than one arena block.
+    str<> line;
+    begin_history_bulk_load(10, 100);
+    for (int i = 0; i < 5000; ++i)
+    {
+        line.format("cmd%d arg1 arg2 arg3 arg4 arg5 arg6 arg7", i);
+        add_history_bulk(line.c_str(), line.length() - 5);
+    }
+    end_history_bulk_load();
+
+    REQUIRE(history_length == 5000);
+    REQUIRE(strcmp(history_get(1)->line, "cmd0 arg1 arg2 arg3 arg4 arg5 arg6") == 0);
+    REQUIRE(strcmp(history_get(5000)->line, "cmd4999 arg1 arg2 arg3 arg4 arg5 arg6") == 0);
+
+    // Entries from the arena can be replaced, removed, and retimed like any
+    // other entries.
+    HIST_ENTRY* old = replace_history_entry(10, "replaced", nullptr);
+    REQUIRE(old != nullptr);
+    REQUIRE(strcmp(old->line, "cmd10 arg1 arg2 arg3 arg4 arg5 arg6") == 0);
+    free_history_entry(old);
+    REQUIRE(strcmp(history_get(11)->line, "replaced") == 0);
+
+    free_history_entry(remove_history(0));
+    REQUIRE(history_length == 4999);
+    REQUIRE(strcmp(history_get(1)->line, "cmd1 arg1 arg2 arg3 arg4 arg5 arg6") == 0);
+
+    add_history_time("#12345");
+    REQUIRE(strcmp(history_get(history_length)->timestamp, "#12345") == 0);
+
+    // Regular entries can follow bulk loaded entries.
+    add_history("after");
+    REQUIRE(history_length == 5000);
+    REQUIRE(strcmp(history_get(5000)->line, "after") == 0);
+
+    clear_history();
+    REQUIRE(history_length == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("history bulk load revert")
+{
+    clear_history();
+
+    begin_history_bulk_load(2, 64);
+    add_history_bulk("first", -1);
+    add_history_bulk("second", -1);
+    end_history_bulk_load();
+
+    // Edit a bulk loaded entry; the edit is recorded in an undo list attached
+    // to the entry, like Readline does while browsing history.
+    UNDO_LIST* saved_undo_list = rl_undo_list;
+    rl_undo_list = nullptr;
+    rl_replace_line("second", 0);
+    rl_point = rl_end;
+    rl_insert_text(" edited");
+    REQUIRE(strcmp(rl_line_buffer, "second edited") == 0);
+
+    HIST_ENTRY* entry = history_get(2);
+    REQUIRE(entry != nullptr);
+    entry->data = histdata_t(rl_undo_list);
+    rl_undo_list = nullptr;
+
+    // Reverting (as revert-all-at-newline does) replaces the entry's line,
+    // which lives in the arena and must not be freed on its own.
+    _rl_revert_all_lines();
+
+    entry = history_get(2);
+    REQUIRE(strcmp(entry->line, "second") == 0);
+    REQUIRE(entry->data == nullptr);
+    REQUIRE(strcmp(history_get(1)->line, "first") == 0);
+
+    rl_undo_list = saved_undo_list;
+    rl_replace_line("", 0);
+
+    clear_history();
+    REQUIRE(history_length == 0);
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/str.h>
+#include <lua/lua_script_loader.h>
+#include <lua/lua_state.h>
+#include <lua/prompt.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static int get_filter_count(lua_state& lua)
+{
+    lua_State* state = lua.get_state();
+    lua_getglobal(state, "_count");
+    const int count = int(lua_tointeger(state, -1));
+    lua_pop(state, 1);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Prompt filter memoisation")
+{
+    fs_fixture fs;
+
+    lua_state lua;
+    prompt_filter prompt_filter(lua);
+    lua_load_script(lua, app, prompt);
+
+    os::set_env("clink_test_prompt", "abc");
+
+    const char* script = "\
+        _count = 0\
+        local pf = clink.promptfilter(1)\
+        function pf:filter(prompt)\
+            _count = _count + 1\
+            return prompt..os.getenv('clink_test_prompt')\
+        end\
+        pf.dependencies = { env={ 'clink_test_prompt' }, paths={ 'file1' } }\
+        ";
+
+    REQUIRE(lua.do_string(script));
+
+    str<> out;
+    prompt_filter.filter(">", out);
+    REQUIRE(out.equals(">abc"));
+    REQUIRE(get_filter_count(lua) == 1);
+
+    SECTION("Unchanged")
+    {
+        prompt_filter.filter(">", out);
+        REQUIRE(out.equals(">abc"));
+        REQUIRE(get_filter_count(lua) == 1);
+    }
+
+    SECTION("Different prompt")
+    {
+        prompt_filter.filter("$", out);
+        REQUIRE(out.equals("$abc"));
+        REQUIRE(get_filter_count(lua) == 2);
+    }
+
+    SECTION("Env var")
+    {
+        os::set_env("clink_test_prompt", "xyz");
+        prompt_filter.filter(">", out);
+        REQUIRE(out.equals(">xyz"));
+        REQUIRE(get_filter_count(lua) == 2);
+
+        // Switching back reuses the earlier result.
+        os::set_env("clink_test_prompt", "abc");
+        prompt_filter.filter(">", out);
+        REQUIRE(out.equals(">abc"));
+        REQUIRE(get_filter_count(lua) == 2);
+    }
+
+    SECTION("Path")
+    {
+        FILE* f = fopen("file1", "wt");
+        REQUIRE(f);
+        fputs("changed", f);
+        fclose(f);
+
+        prompt_filter.filter(">", out);
+        REQUIRE(get_filter_count(lua) == 2);
+    }
+
+    SECTION("Added filter")
+    {
+        // Adding a prompt filter must not reuse the prompt from before it.
+        REQUIRE(lua.do_string("\
+            local pf = clink.promptfilter(2)\
+            function pf:filter(prompt) return prompt..'!' end\
+            pf.dependencies = {}\
+            "));
+
+        prompt_filter.filter(">", out);
+        REQUIRE(out.equals(">abc!"));
+        REQUIRE(get_filter_count(lua) == 2);
+
+        prompt_filter.filter(">", out);
+        REQUIRE(out.equals(">abc!"));
+        REQUIRE(get_filter_count(lua) == 2);
+    }
+
+    SECTION("Undeclared")
+    {
+        // A filter without declared dependencies disables memoisation.
+        REQUIRE(lua.do_string("clink.promptfilter(2).filter = function() end"));
+
+        prompt_filter.filter(">", out);
+        prompt_filter.filter(">", out);
+        REQUIRE(get_filter_count(lua) == 3);
+    }
+
+    os::set_env("clink_test_prompt", nullptr);
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <lib/cmd_tokenisers.h>
+#include <lib/line_state.h>
+#include <lib/matches.h>
+#include <lib/word_classifications.h>
+#include <lib/word_collector.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+#include <lua/lua_word_classifier.h>
+
+#include "match_pipeline.h"
+#include "matches_impl.h"
+
+//------------------------------------------------------------------------------
+static const unsigned int c_depth = 40;
+static const unsigned int c_breadth = 50;
+static const unsigned int c_lines_per_pass = 20;
+
+//------------------------------------------------------------------------------
+// Registers a deep argmatcher tree, and parses a line that walks all the way
+// down it.
+struct argmatcher_workload
+{
+    argmatcher_workload()
+    : collector(&command_tokeniser, &word_tokeniser)
+    , generator(lua) // This loads the required lua scripts.
+    , classifier(lua)
+    {
+        std::string script;
+        workload::make_argmatcher_script(c_depth, c_breadth, script);
+        lua.do_string(script.c_str(), int(script.length()));
+
+        workload::make_argmatcher_line(c_depth, c_breadth, line);
+    }
+
+    void collect(collect_words_mode mode)
+    {
+        const unsigned int len = unsigned(line.length());
+        collector.collect_words(line.c_str(), len, len, words, mode);
+        line_commands.set(line.c_str(), len, len, words);
+    }
+
+    cmd_command_tokeniser   command_tokeniser;
+    cmd_word_tokeniser      word_tokeniser;
+    word_collector          collector;
+    lua_state               lua;
+    lua_match_generator     generator;
+    lua_word_classifier     classifier;
+    std::string             line;
+    std::vector<word>       words;
+    commands                line_commands;
+};
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("argmatcher/classify deep tree")
+{
+    argmatcher_workload w;
+    w.collect(collect_words_mode::whole_command);
+
+    word_classifications classifications;
+    runner.set_items(c_lines_per_pass);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_lines_per_pass; ++i)
+        {
+            classifications.init(w.line.length(), nullptr);
+            w.classifier.classify(w.line_commands.get_linestates(), classifications);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("argmatcher/generate deep tree")
+{
+    argmatcher_workload w;
+    w.collect(collect_words_mode::stop_at_cursor);
+
+    matches_impl matches;
+    match_pipeline pipeline(matches);
+    runner.set_items(c_lines_per_pass);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_lines_per_pass; ++i)
+        {
+            pipeline.reset();
+            pipeline.generate(w.line_commands.get_linestates().back(), &w.generator);
+        }
+    });
+}
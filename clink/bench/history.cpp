@@ -0,0 +1,80 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <core/settings.h>
+#include <history/history_db.h>
+#include <utils/app_context.h>
+
+extern "C" {
+#include <readline/history.h>
+};
+
+//------------------------------------------------------------------------------
+static const unsigned int c_history_lines = 1000000;
+
+//------------------------------------------------------------------------------
+// Writes a master history file with c_history_lines lines into a scratch
+// profile directory.  The history_db injects the concurrency tag itself the
+// first time it opens the file.
+struct history_workload
+{
+    history_workload()
+    {
+        settings::find("history.shared")->set("true");
+        settings::find("history.dupe_mode")->set("add");
+        settings::find("history.max_lines")->set("0");
+
+        std::string lines;
+        workload::make_history(c_history_lines, lines);
+        if (FILE* file = fopen("clink_history", "wb"))
+        {
+            fwrite(lines.c_str(), 1, lines.length(), file);
+            fclose(file);
+        }
+
+        context_desc.id = 1;
+        str_base(context_desc.state_dir).copy(scratch.get_root());
+    }
+
+    ~history_workload()
+    {
+        clear_history();
+    }
+
+    workload::scratch_dir   scratch;
+    app_context::desc       context_desc;
+};
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("history/load 1M lines")
+{
+    history_workload w;
+    app_context context(w.context_desc);
+    history_db history(true/*use_master_bank*/);
+    history.initialise();
+
+    runner.set_items(c_history_lines);
+    runner.measure([&] () {
+        history.load_rl_history(false/*can_clean*/);
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("history/find 1M lines")
+{
+    history_workload w;
+    app_context context(w.context_desc);
+    history_db history(true/*use_master_bank*/);
+    history.initialise();
+
+    // A line that isn't in the history forces a scan of the whole file.
+    runner.set_items(c_history_lines);
+    runner.measure([&] () {
+        history.find("not in the history");
+    });
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <core/base.h>
+#include <core/match_wild.h>
+#include <core/str_compare.h>
+
+//------------------------------------------------------------------------------
+static const unsigned int c_file_count = 100000;
+
+// A leading literal, a literal anywhere, a long literal run with an extension,
+// and several stars in a row; roughly what globbing and filtering ask for.
+static const char* const c_patterns[] = {
+    "build*", "*cache*", "*_000f*.lua", "ren*par*",
+};
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("match_wild/match_wild 100k files")
+{
+    std::vector<std::string> names;
+    workload::make_file_names(c_file_count, names);
+
+    str_compare_scope _(str_compare_scope::caseless, false);
+    unsigned int count = 0;
+
+    runner.set_items(c_file_count * unsigned(sizeof_array(c_patterns)));
+    runner.measure([&] () {
+        for (const char* pattern : c_patterns)
+            for (const auto& name : names)
+                count += path::match_wild(pattern, name.c_str(), path::yes);
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("match_wild/compiled 100k files")
+{
+    std::vector<std::string> names;
+    workload::make_file_names(c_file_count, names);
+
+    str_compare_scope _(str_compare_scope::caseless, false);
+    unsigned int count = 0;
+
+    runner.set_items(c_file_count * unsigned(sizeof_array(c_patterns)));
+    runner.measure([&] () {
+        for (const char* pattern : c_patterns)
+        {
+            const path::compiled_wild_pattern compiled(pattern);
+            for (const auto& name : names)
+                count += compiled.match(name.c_str(), int(name.length()), path::yes);
+        }
+    });
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <core/settings.h>
+#include <lib/line_state.h>
+#include <lib/match_generator.h>
+#include <lib/matches.h>
+
+#include "match_pipeline.h"
+#include "matches_impl.h"
+
+//------------------------------------------------------------------------------
+static const unsigned int c_file_count = 100000;
+
+//------------------------------------------------------------------------------
+// Adds the same names that a directory with c_file_count files would produce,
+// without touching the file system.
+class file_names_generator : public match_generator
+{
+public:
+    file_names_generator() { workload::make_file_names(c_file_count, m_names); }
+
+    bool generate(const line_state& line, match_builder& builder, bool old_filtering=false) override
+    {
+        builder.reserve(unsigned(m_names.size()));
+        for (const auto& name : m_names)
+            builder.add_match(name.c_str(), match_type::file);
+        return true;
+    }
+
+    void get_word_break_info(const line_state& line, word_break_info& info) const override
+    {
+        info.clear();
+    }
+
+private:
+    std::vector<std::string> m_names;
+};
+
+//------------------------------------------------------------------------------
+struct matches_workload
+{
+    matches_workload()
+    : line("", 0, 0, 0, words)
+    , pipeline(matches)
+    {
+    }
+
+    void generate()
+    {
+        pipeline.reset();
+        pipeline.generate(line, &generator);
+    }
+
+    file_names_generator    generator;
+    std::vector<word>       words;
+    line_state              line;
+    matches_impl            matches;
+    match_pipeline          pipeline;
+};
+
+//------------------------------------------------------------------------------
+static void set_fuzzy(bool fuzzy)
+{
+    settings::find("match.fuzzy")->set(fuzzy ? "true" : "false");
+}
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/generate 100k files")
+{
+    matches_workload w;
+
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/select prefix 100k files")
+{
+    matches_workload w;
+
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+    }, [&] () {
+        w.pipeline.select("render_");
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/select substring 100k files")
+{
+    matches_workload w;
+
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+    }, [&] () {
+        w.pipeline.select("ache_0");
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/select fuzzy 100k files")
+{
+    matches_workload w;
+
+    set_fuzzy(true);
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+    }, [&] () {
+        w.pipeline.select("rcach");
+    });
+    set_fuzzy(false);
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/sort 100k files")
+{
+    matches_workload w;
+
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+        w.pipeline.select("");
+    }, [&] () {
+        w.pipeline.sort();
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("matches/sort fuzzy 100k files")
+{
+    matches_workload w;
+
+    set_fuzzy(true);
+    runner.set_items(c_file_count);
+    runner.measure([&] () {
+        w.generate();
+        w.pipeline.select("e");
+    }, [&] () {
+        w.pipeline.sort();
+    });
+    set_fuzzy(false);
+}
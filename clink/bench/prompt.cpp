@@ -0,0 +1,67 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <core/str.h>
+#include <terminal/ecma48_iter.h>
+
+//------------------------------------------------------------------------------
+// A prompt this long is unrealistic on its own, but it's roughly what a fancy
+// prompt costs across the many redraws it gets while typing a line.  It stays
+// well under the 32K that a str<> can hold, even after bracketing.
+static const unsigned int c_prompt_segments = 200;
+static const unsigned int c_prompt_passes = 200;
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("prompt/ecma48 iterate")
+{
+    std::string prompt;
+    workload::make_ansi_prompt(c_prompt_segments, prompt);
+
+    unsigned int codes = 0;
+    runner.set_items(c_prompt_passes);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_prompt_passes; ++i)
+        {
+            ecma48_state state;
+            ecma48_iter iter(prompt.c_str(), state, int(prompt.length()));
+            while (iter.next())
+                ++codes;
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("prompt/ecma48 processor")
+{
+    std::string prompt;
+    workload::make_ansi_prompt(c_prompt_segments, prompt);
+
+    str_moveable out;
+    runner.set_items(c_prompt_passes);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_prompt_passes; ++i)
+        {
+            unsigned int cells;
+            out.clear();
+            ecma48_processor(prompt.c_str(), &out, &cells, ecma48_processor_flags::bracket);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+BENCHMARK("prompt/cell count")
+{
+    std::string prompt;
+    workload::make_ansi_prompt(c_prompt_segments, prompt);
+
+    runner.set_items(c_prompt_passes);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_prompt_passes; ++i)
+            cell_count(prompt.c_str());
+    });
+}
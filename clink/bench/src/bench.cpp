@@ -0,0 +1,318 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace bench {
+
+//------------------------------------------------------------------------------
+static const double c_min_delta_ms = 0.01;
+
+//------------------------------------------------------------------------------
+// Nearest-rank percentile of an ascending list of samples.
+static double percentile(const std::vector<double>& sorted, double pct)
+{
+    if (sorted.empty())
+        return 0;
+
+    size_t rank = size_t(ceil(pct / 100 * sorted.size()));
+    if (rank > 0)
+        --rank;
+    if (rank >= sorted.size())
+        rank = sorted.size() - 1;
+    return sorted[rank];
+}
+
+//------------------------------------------------------------------------------
+static void write_json_string(FILE* out, const char* s)
+{
+    fputc('"', out);
+    for (const char* p = s; *p; ++p)
+    {
+        const unsigned char c = *p;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+//------------------------------------------------------------------------------
+// Finds `"key":` in a line written by write_json() and returns a pointer to the
+// value that follows it.
+static const char* find_value(const char* line, const char* key)
+{
+    const size_t key_len = strlen(key);
+    for (const char* p = strchr(line, '"'); p; p = strchr(p + 1, '"'))
+    {
+        if (strncmp(p + 1, key, key_len) == 0 && p[1 + key_len] == '"' && p[2 + key_len] == ':')
+            return p + 3 + key_len;
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+static bool parse_json_string(const char* p, std::vector<char>& out)
+{
+    out.clear();
+    if (*p != '"')
+        return false;
+
+    for (++p; *p && *p != '"'; ++p)
+    {
+        if (*p == '\\')
+        {
+            ++p;
+            if (*p == 'u')
+            {
+                char hex[5] = {};
+                for (int i = 0; i < 4 && p[1]; ++i)
+                    hex[i] = *(++p);
+                out.push_back(char(strtoul(hex, nullptr, 16)));
+                continue;
+            }
+            if (!*p)
+                break;
+        }
+        out.push_back(*p);
+    }
+
+    out.push_back('\0');
+    return *p == '"';
+}
+
+
+
+//------------------------------------------------------------------------------
+runner::runner(const options& options)
+: m_warmup(options.warmup)
+, m_repetitions(std::max(options.repetitions, 1u))
+{
+}
+
+//------------------------------------------------------------------------------
+void runner::measure(const std::function<void()>& body)
+{
+    measure(nullptr, body);
+}
+
+//------------------------------------------------------------------------------
+void runner::measure(const std::function<void()>& setup, const std::function<void()>& body)
+{
+    using namespace std::chrono;
+
+    assert(m_samples.empty());
+
+    for (unsigned int i = 0; i < m_warmup; ++i)
+    {
+        if (setup)
+            setup();
+        body();
+    }
+
+    m_samples.reserve(m_repetitions);
+    for (unsigned int i = 0; i < m_repetitions; ++i)
+    {
+        if (setup)
+            setup();
+
+        const auto begin = steady_clock::now();
+        body();
+        const auto end = steady_clock::now();
+
+        m_samples.push_back(duration<double, std::milli>(end - begin).count());
+    }
+}
+
+//------------------------------------------------------------------------------
+bool runner::get_result(const char* name, result& out) const
+{
+    if (m_samples.empty())
+        return false;
+
+    std::vector<double> sorted(m_samples);
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0;
+    for (double sample : sorted)
+        total += sample;
+
+    out.name = name;
+    out.repetitions = unsigned(sorted.size());
+    out.items = m_items;
+    out.min_ms = sorted.front();
+    out.median_ms = percentile(sorted, 50);
+    out.p90_ms = percentile(sorted, 90);
+    out.max_ms = sorted.back();
+    out.mean_ms = total / sorted.size();
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+void run(const char* prefix, const options& options, std::vector<result>& results)
+{
+    const size_t prefix_len = strlen(prefix);
+
+    printf("%-40s%10s%11s%11s%11s\n", "Benchmark", "median", "p90", "min", "per item");
+
+    for (benchmark* bench = benchmark::get_head(); bench; bench = bench->m_next)
+    {
+        if (strncmp(bench->m_name, prefix, prefix_len) != 0)
+            continue;
+
+        printf("%-40s", bench->m_name);
+        fflush(stdout);
+
+        runner runner(options);
+        bench->m_func(runner);
+
+        result r;
+        if (!runner.get_result(bench->m_name, r))
+        {
+            puts("  (not measured)");
+            continue;
+        }
+
+        printf("%8.2fms %8.2fms %8.2fms", r.median_ms, r.p90_ms, r.min_ms);
+        if (r.items)
+            printf(" %8.3fus", r.median_ms * 1000 / r.items);
+        puts("");
+
+        results.push_back(r);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Writes one benchmark per line, so that load_baseline() can read the output
+// back without needing a general JSON parser.
+bool write_json(FILE* out, const std::vector<result>& results)
+{
+    fputs("{\"benchmarks\":[", out);
+
+    bool first = true;
+    for (const result& r : results)
+    {
+        fputs(first ? "\n{\"name\":" : ",\n{\"name\":", out);
+        first = false;
+
+        write_json_string(out, r.name);
+        fprintf(out, ",\"repetitions\":%u,\"items\":%u", r.repetitions, r.items);
+        fprintf(out, ",\"min_ms\":%.6f,\"median_ms\":%.6f,\"p90_ms\":%.6f,\"max_ms\":%.6f,\"mean_ms\":%.6f}",
+                r.min_ms, r.median_ms, r.p90_ms, r.max_ms, r.mean_ms);
+    }
+
+    fputs("\n]}\n", out);
+    return !ferror(out);
+}
+
+//------------------------------------------------------------------------------
+bool load_baseline(const char* filename, std::vector<baseline_entry>& baseline)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    baseline.clear();
+
+    std::vector<char> line;
+    char buffer[1024];
+    bool eof = false;
+    while (!eof)
+    {
+        line.clear();
+        while (true)
+        {
+            if (!fgets(buffer, int(sizeof(buffer)), file))
+            {
+                eof = true;
+                break;
+            }
+
+            const size_t len = strlen(buffer);
+            line.insert(line.end(), buffer, buffer + len);
+            if (len && buffer[len - 1] == '\n')
+                break;
+        }
+        line.push_back('\0');
+
+        const char* name = find_value(line.data(), "name");
+        const char* median = find_value(line.data(), "median_ms");
+        if (!name || !median)
+            continue;
+
+        baseline_entry entry;
+        if (!parse_json_string(name, entry.name))
+            continue;
+        entry.median_ms = strtod(median, nullptr);
+        baseline.push_back(std::move(entry));
+    }
+
+    const bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+// Compares medians against the baseline, and returns how many benchmarks are
+// slower than the baseline by more than `threshold` percent.  Medians are used
+// because they are much less sensitive than means to the odd descheduled run.
+// Differences smaller than the timer can reliably resolve are never flagged,
+// since a few ticks is a huge percentage of a tiny median.
+unsigned int compare(const std::vector<result>& results, const std::vector<baseline_entry>& baseline, double threshold)
+{
+    unsigned int regressions = 0;
+
+    printf("\n%-40s%10s%12s%10s\n", "Benchmark", "baseline", "current", "change");
+
+    for (const result& r : results)
+    {
+        const baseline_entry* base = nullptr;
+        for (const baseline_entry& entry : baseline)
+        {
+            if (strcmp(entry.name.data(), r.name) == 0)
+            {
+                base = &entry;
+                break;
+            }
+        }
+
+        printf("%-40s", r.name);
+        if (!base || base->median_ms <= 0)
+        {
+            printf("%10s  %8.2fms  (new)\n", "-", r.median_ms);
+            continue;
+        }
+
+        const double delta = r.median_ms - base->median_ms;
+        const double change = delta * 100 / base->median_ms;
+        const char* verdict = "";
+        if (change > threshold && delta > c_min_delta_ms)
+        {
+            verdict = "  REGRESSION";
+            ++regressions;
+        }
+        else if (change < -threshold && -delta > c_min_delta_ms)
+        {
+            verdict = "  improved";
+        }
+
+        printf("%8.2fms  %8.2fms  %+7.1f%%%s\n", base->median_ms, r.median_ms, change, verdict);
+    }
+
+    return regressions;
+}
+
+} // namespace bench
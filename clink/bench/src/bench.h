@@ -0,0 +1,100 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdio.h>
+#include <functional>
+#include <vector>
+
+namespace bench {
+
+//------------------------------------------------------------------------------
+struct options
+{
+    unsigned int        warmup = 2;             // Untimed runs before measuring.
+    unsigned int        repetitions = 15;       // Timed runs.
+    double              threshold = 10;         // Percent slower than baseline that counts as a regression.
+};
+
+//------------------------------------------------------------------------------
+struct result
+{
+    const char*         name;
+    unsigned int        repetitions;
+    unsigned int        items;                  // Units of work per repetition, for per-item times.
+    double              min_ms;
+    double              median_ms;
+    double              p90_ms;
+    double              max_ms;
+    double              mean_ms;
+};
+
+//------------------------------------------------------------------------------
+struct baseline_entry
+{
+    std::vector<char>   name;
+    double              median_ms;
+};
+
+//------------------------------------------------------------------------------
+// Passed to each benchmark.  A benchmark prepares its workload and then calls
+// measure() exactly once.  The setup function runs before every repetition but
+// is not timed, so that the body can consume or mutate its input.
+class runner
+{
+public:
+                        runner(const options& options);
+    void                set_items(unsigned int items) { m_items = items; }
+    void                set_repetitions(unsigned int repetitions) { m_repetitions = repetitions; }
+    void                measure(const std::function<void()>& body);
+    void                measure(const std::function<void()>& setup, const std::function<void()>& body);
+    bool                get_result(const char* name, result& out) const;
+
+private:
+    unsigned int        m_warmup;
+    unsigned int        m_repetitions;
+    unsigned int        m_items = 0;
+    std::vector<double> m_samples;
+};
+
+//------------------------------------------------------------------------------
+struct benchmark
+{
+    typedef void        (benchmark_func)(runner&);
+    static benchmark*&  get_head() { static benchmark* head; return head; }
+    static benchmark*&  get_tail() { static benchmark* tail; return tail; }
+    benchmark*          m_next = nullptr;
+    benchmark_func*     m_func;
+    const char*         m_name;
+
+    benchmark(const char* name, benchmark_func* func)
+    : m_func(func)
+    , m_name(name)
+    {
+        if (get_head() == nullptr)
+            get_head() = this;
+
+        if (benchmark* tail = get_tail())
+            tail->m_next = this;
+        get_tail() = this;
+    }
+};
+
+//------------------------------------------------------------------------------
+void run(const char* prefix, const options& options, std::vector<result>& results);
+bool write_json(FILE* out, const std::vector<result>& results);
+bool load_baseline(const char* filename, std::vector<baseline_entry>& baseline);
+unsigned int compare(const std::vector<result>& results, const std::vector<baseline_entry>& baseline, double threshold);
+
+} // namespace bench
+
+//------------------------------------------------------------------------------
+#define BENCH_IDENT__(d, b)     _bench_##d##_##b
+#define BENCH_IDENT_(d, b)      BENCH_IDENT__(d, b)
+#define BENCH_IDENT(d)          BENCH_IDENT_(d, __LINE__)
+
+#define BENCHMARK(name)\
+    static void BENCH_IDENT(bench_func)(bench::runner&);\
+    static bench::benchmark BENCH_IDENT(bench)(name, BENCH_IDENT(bench_func));\
+    static void BENCH_IDENT(bench_func)(bench::runner& runner)
@@ -0,0 +1,155 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "core/str.h"
+#include "core/settings.h"
+#include "core/os.h"
+
+extern "C" {
+#include <readline/readline.h>
+#include <readline/rldefs.h>
+#include <readline/rlprivate.h>
+}
+
+#include <list>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+void host_cmd_enqueue_lines(std::list<str_moveable>& lines)
+{
+    assert(false);
+}
+
+//------------------------------------------------------------------------------
+void host_mark_deprecated_argmatcher(const char* command)
+{
+}
+
+//------------------------------------------------------------------------------
+bool host_has_deprecated_argmatcher(const char* command)
+{
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void start_logger()
+{
+    assert(false);
+}
+
+//------------------------------------------------------------------------------
+static bool write_json(const char* filename, const std::vector<bench::result>& results)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    bool ok = bench::write_json(file, results);
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    argc--, argv++;
+
+    bench::options options;
+    const char* json = nullptr;
+    const char* baseline = nullptr;
+
+#ifdef DEBUG
+    settings::TEST_set_ever_loaded();
+#endif
+
+    os::set_shellname(L"clink_bench_harness");
+
+    _rl_bell_preference = VISIBLE_BELL;     // Because audible is annoying.
+
+    while (argc > 0)
+    {
+        const bool has_value = (argc > 1);
+
+        if (!strcmp(argv[0], "-?") || !strcmp(argv[0], "--help"))
+        {
+            puts("Usage: clink_bench [options] [prefix]\n"
+                 "\n"
+                 "Runs the benchmarks whose names start with prefix (default all).\n"
+                 "\n"
+                 "Options:\n"
+                 "  -?        Show this help.\n"
+                 "  -b file   Compare against a baseline written by -j; exits with 1\n"
+                 "            if any benchmark regressed.\n"
+                 "  -j file   Write the results to file as JSON.\n"
+                 "  -p pct    Percent slower than the baseline that counts as a\n"
+                 "            regression (default 10).\n"
+                 "  -r n      Number of timed repetitions (default 15).\n"
+                 "  -w n      Number of untimed warmup runs (default 2).");
+            return 1;
+        }
+        else if (!strcmp(argv[0], "-b") && has_value)
+        {
+            baseline = (++argv)[0], --argc;
+        }
+        else if (!strcmp(argv[0], "-j") && has_value)
+        {
+            json = (++argv)[0], --argc;
+        }
+        else if (!strcmp(argv[0], "-p") && has_value)
+        {
+            options.threshold = atof((++argv)[0]), --argc;
+        }
+        else if (!strcmp(argv[0], "-r") && has_value)
+        {
+            options.repetitions = atoi((++argv)[0]), --argc;
+        }
+        else if (!strcmp(argv[0], "-w") && has_value)
+        {
+            options.warmup = atoi((++argv)[0]), --argc;
+        }
+        else if (!strcmp(argv[0], "--"))
+        {
+        }
+        else
+        {
+            break;
+        }
+
+        argc--, argv++;
+    }
+
+    // Load the baseline first, so a bad path fails before spending minutes
+    // running benchmarks.
+    std::vector<bench::baseline_entry> baseline_entries;
+    if (baseline && !bench::load_baseline(baseline, baseline_entries))
+    {
+        fprintf(stderr, "Unable to read baseline '%s'.\n", baseline);
+        return 1;
+    }
+
+    const char* prefix = (argc > 0) ? argv[0] : "";
+    std::vector<bench::result> results;
+    bench::run(prefix, options, results);
+
+    int result = 0;
+
+    if (json && !write_json(json, results))
+    {
+        fprintf(stderr, "Unable to write '%s'.\n", json);
+        result = 1;
+    }
+
+    if (baseline)
+    {
+        const unsigned int regressions = bench::compare(results, baseline_entries, options.threshold);
+        if (regressions)
+        {
+            printf("\n%u benchmark%s regressed by more than %g%%.\n", regressions, regressions == 1 ? "" : "s", options.threshold);
+            result = 1;
+        }
+    }
+
+    return result;
+}
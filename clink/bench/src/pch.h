@@ -0,0 +1,10 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/bldopts.h>
+
+#include "bench.h"
+
+#include <Windows.h>
@@ -0,0 +1,273 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <core/base.h>
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/path.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace workload {
+
+//------------------------------------------------------------------------------
+static const char* const c_words[] = {
+    "alpha", "build", "cache", "debug", "engine", "filter", "graph", "handle",
+    "index", "json", "kernel", "layout", "module", "network", "object", "parser",
+    "query", "render", "stream", "token", "update", "vector", "widget", "xml",
+    "yield", "zone", "array", "buffer", "config", "driver", "event", "format",
+};
+
+static const char* const c_exts[] = {
+    ".cpp", ".h", ".lua", ".txt", ".md", ".json", ".exe", ".dll", "",
+};
+
+static const char* const c_commands[] = {
+    "git", "cd", "dir", "copy", "msbuild", "cmake", "python", "findstr", "set", "echo",
+};
+
+//------------------------------------------------------------------------------
+template <int N>
+static const char* pick(rng& r, const char* const (&list)[N])
+{
+    return list[r.below(N)];
+}
+
+//------------------------------------------------------------------------------
+static void append_format(std::string& out, const char* format, ...)
+{
+    char buffer[256];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (len > 0)
+        out.append(buffer, min<int>(len, sizeof(buffer) - 1));
+}
+
+
+
+//------------------------------------------------------------------------------
+unsigned int rng::next()
+{
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return (unsigned int)((m_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+
+
+//------------------------------------------------------------------------------
+// Names look like "render_cache_0a41f.cpp"; the hex suffix keeps every name
+// unique, and the leading words give selection something realistic to chew on.
+void make_file_names(unsigned int count, std::vector<std::string>& out)
+{
+    rng r;
+    std::string name;
+
+    out.clear();
+    out.reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const char* a = pick(r, c_words);
+        const char* b = pick(r, c_words);
+        const char* ext = pick(r, c_exts);
+
+        name.clear();
+        append_format(name, "%s_%s_%05x%s", a, b, i, ext);
+        out.push_back(name);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns `count` newline terminated lines, in the format of a history file.
+void make_history(unsigned int count, std::string& out)
+{
+    rng r;
+
+    out.clear();
+    out.reserve(size_t(count) * 48);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // Draw everything up front; the order in which function arguments are
+        // evaluated varies between compilers.
+        const unsigned int kind = r.below(5);
+        const char* cmd = pick(r, c_commands);
+        const char* a = pick(r, c_words);
+        const char* b = pick(r, c_words);
+        const char* c = pick(r, c_words);
+        const char* ext = pick(r, c_exts);
+        const unsigned int n = r.below(1000);
+
+        switch (kind)
+        {
+        case 0:     append_format(out, "git commit -m \"%s the %s %s\"", a, b, c); break;
+        case 1:     append_format(out, "cd c:\\src\\%s\\%s", a, b); break;
+        case 2:     append_format(out, "dir /s /b *%s | findstr %s", ext, a); break;
+        case 3:     append_format(out, "%s --%s=%u %s%s", cmd, a, n, b, ext); break;
+        default:    append_format(out, "set %s_%u=%s", a, i, b); break;
+        }
+        out.push_back('\n');
+    }
+}
+
+//------------------------------------------------------------------------------
+// Builds a powerline style prompt where every segment has 24 bit colors, and
+// some segments have hyperlinks, wide characters, and cursor save/restore.
+void make_ansi_prompt(unsigned int segments, std::string& out)
+{
+    rng r;
+
+    out.clear();
+    for (unsigned int i = 0; i < segments; ++i)
+    {
+        const unsigned int fg_r = r.below(256);
+        const unsigned int fg_g = r.below(256);
+        const unsigned int fg_b = r.below(256);
+        const unsigned int bg = r.below(256);
+        const unsigned int kind = r.below(4);
+        const char* a = pick(r, c_words);
+        const char* b = pick(r, c_words);
+        const unsigned int n = r.below(100000);
+
+        append_format(out, "\x1b[38;2;%u;%u;%um\x1b[48;5;%um ", fg_r, fg_g, fg_b, bg);
+
+        switch (kind)
+        {
+        case 0:     append_format(out, "\x1b]8;;file:///c:/src/%s\x1b\\%s\x1b]8;;\x1b\\", a, b); break;
+        case 1:     append_format(out, "\xe4\xb8\xad\xe6\x96\x87 %s", a); break;
+        case 2:     append_format(out, "\x1b[s%s\x1b[u\x1b[1;4m%s\x1b[22;24m", a, b); break;
+        default:    append_format(out, "%s %u", a, n); break;
+        }
+
+        // Powerline separator glyph (U+E0B0).
+        append_format(out, " \x1b[0;38;5;%um\xee\x82\xb0", bg);
+    }
+    out.append("\x1b[0m\r\n> ");
+}
+
+//------------------------------------------------------------------------------
+// Each variant is a different (but reproducible) line with the same shape.
+void make_command_line(unsigned int words, unsigned int variant, std::string& out)
+{
+    rng r(0x9e3779b97f4a7c15ull + variant);
+
+    out.clear();
+    out.append(pick(r, c_commands));
+    for (unsigned int i = 1; i < words; ++i)
+    {
+        const unsigned int kind = r.below(6);
+        const char* cmd = pick(r, c_commands);
+        const char* a = pick(r, c_words);
+        const char* b = pick(r, c_words);
+        const char* ext = pick(r, c_exts);
+        const char letter = char('a' + r.below(26));
+
+        if (i % 12 == 0)
+        {
+            append_format(out, " %s %s", (kind & 1) ? "&&" : "|", cmd);
+            continue;
+        }
+
+        switch (kind)
+        {
+        case 0:     append_format(out, " -%c", letter); break;
+        case 1:     append_format(out, " --%s=%s", a, b); break;
+        case 2:     append_format(out, " \"%s %s\"", a, b); break;
+        case 3:     append_format(out, " >%s.log", a); break;
+        case 4:     append_format(out, " %s^&%s", a, b); break;
+        default:    append_format(out, " c:\\src\\%s\\%s%s", a, b, ext); break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Defines a `deepcmd` argmatcher that is `depth` levels deep, where each level
+// has `breadth` args and `breadth` flags, and the arg `next` leads to the next
+// level down.
+void make_argmatcher_script(unsigned int depth, unsigned int breadth, std::string& out)
+{
+    out =
+        "local function build(depth, breadth)\n"
+        "    local args = {}\n"
+        "    local flags = {}\n"
+        "    for i = 1, breadth do\n"
+        "        table.insert(args, 'arg'..depth..'_'..i)\n"
+        "        table.insert(flags, '--flag'..depth..'_'..i)\n"
+        "    end\n"
+        "    if depth > 1 then\n"
+        "        table.insert(args, 1, 'next'..build(depth - 1, breadth))\n"
+        "    end\n"
+        "    return clink.argmatcher():addarg(args):addflags(flags)\n"
+        "end\n";
+
+    append_format(out, "clink.argmatcher('deepcmd'):addarg({ 'next'..build(%u, %u) })\n", depth, breadth);
+}
+
+//------------------------------------------------------------------------------
+// Walks all the way down the tree made by make_argmatcher_script(), using a
+// flag at each level, and ends with a partial word in the deepest level.
+void make_argmatcher_line(unsigned int depth, unsigned int breadth, std::string& out)
+{
+    out = "deepcmd next";
+    for (unsigned int d = depth; d > 0; --d)
+    {
+        append_format(out, " --flag%u_%u", d, 1 + (d % breadth));
+        out.append(d > 1 ? " next" : " arg1_");
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+scratch_dir::scratch_dir()
+{
+    os::get_temp_dir(m_root);
+
+    str<64> id;
+    id.format("clink_bench_%d", rand());
+    path::append(m_root, id.c_str());
+
+    if (!os::make_dir(m_root.c_str()))
+        clean(m_root.c_str());
+    os::make_dir(m_root.c_str());
+    os::set_current_dir(m_root.c_str());
+}
+
+//------------------------------------------------------------------------------
+scratch_dir::~scratch_dir()
+{
+    os::set_current_dir(m_root.c_str());
+    os::set_current_dir("..");
+
+    clean(m_root.c_str());
+}
+
+//------------------------------------------------------------------------------
+void scratch_dir::clean(const char* path)
+{
+    str<> file;
+    path::join(path, "*", file);
+
+    globber globber(file.c_str());
+    globber.hidden(true);
+    while (globber.next(file))
+    {
+        if (os::get_path_type(file.c_str()) == os::path_type_dir)
+            clean(file.c_str());
+        else
+            os::unlink(file.c_str());
+    }
+
+    os::remove_dir(path);
+}
+
+} // namespace workload
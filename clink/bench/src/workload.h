@@ -0,0 +1,51 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Synthetic workloads.  Everything is generated from a fixed seed, so every
+// run (and every machine) measures exactly the same data, and nothing depends
+// on the contents of the user's disk, history, or scripts.
+namespace workload {
+
+//------------------------------------------------------------------------------
+// xorshift64*; small, fast, and identical on every platform, unlike rand().
+class rng
+{
+public:
+                        rng(unsigned long long seed=0x2545f4914f6cdd1dull) : m_state(seed) {}
+    unsigned int        next();
+    unsigned int        below(unsigned int n) { return next() % n; }
+private:
+    unsigned long long  m_state;
+};
+
+//------------------------------------------------------------------------------
+void make_file_names(unsigned int count, std::vector<std::string>& out);
+void make_history(unsigned int count, std::string& out);
+void make_ansi_prompt(unsigned int segments, std::string& out);
+void make_command_line(unsigned int words, unsigned int variant, std::string& out);
+void make_argmatcher_script(unsigned int depth, unsigned int breadth, std::string& out);
+void make_argmatcher_line(unsigned int depth, unsigned int breadth, std::string& out);
+
+//------------------------------------------------------------------------------
+// Creates an empty temporary directory and makes it the current directory for
+// its lifetime, then deletes it and everything in it.
+class scratch_dir
+{
+public:
+                        scratch_dir();
+                        ~scratch_dir();
+    const char*         get_root() const { return m_root.c_str(); }
+private:
+    void                clean(const char* path);
+    str<>               m_root;
+};
+
+} // namespace workload
@@ -0,0 +1,43 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "workload.h"
+
+#include <lib/cmd_tokenisers.h>
+#include <lib/line_state.h>
+#include <lib/word_collector.h>
+
+//------------------------------------------------------------------------------
+// The word_collector remembers the last couple of lines it tokenised, so cycle
+// through more lines than that to measure tokenising rather than cache hits.
+static const unsigned int c_line_variants = 8;
+static const unsigned int c_line_words = 120;
+static const unsigned int c_lines_per_pass = 1000;
+
+
+
+//------------------------------------------------------------------------------
+BENCHMARK("words/collect long lines")
+{
+    std::vector<std::string> lines(c_line_variants);
+    for (unsigned int i = 0; i < c_line_variants; ++i)
+        workload::make_command_line(c_line_words, i, lines[i]);
+
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser);
+    std::vector<word> words;
+    commands commands;
+
+    runner.set_items(c_lines_per_pass);
+    runner.measure([&] () {
+        for (unsigned int i = 0; i < c_lines_per_pass; ++i)
+        {
+            const std::string& line = lines[i % c_line_variants];
+            const unsigned int len = unsigned(line.length());
+            collector.collect_words(line.c_str(), len, len, words, collect_words_mode::whole_command);
+            commands.set(line.c_str(), len, 0, words);
+        }
+    });
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "linear_allocator.h"
+#include "str.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// The file system operations dir_cache uses.  The default source calls Win32
+// directly; tests can substitute a fake to simulate slow directories.
+class dir_source
+{
+public:
+    virtual                 ~dir_source() {}
+    virtual bool            is_slow(const char* dir) = 0;
+    virtual bool            get_modified(const char* dir, FILETIME& out) = 0;
+    virtual HANDLE          find_first(const wchar_t* pattern, WIN32_FIND_DATAW& fd) = 0;
+    virtual bool            find_next(HANDLE h, WIN32_FIND_DATAW& fd) = 0;
+    virtual void            find_close(HANDLE h) = 0;
+};
+
+//------------------------------------------------------------------------------
+// Lets an enumeration be abandoned part way through, either on request or once
+// a deadline has passed.
+class dir_cancel_token : public no_copy
+{
+public:
+                            dir_cancel_token(unsigned int timeout_ms=INFINITE);
+    void                    cancel() { m_canceled = true; }
+    bool                    is_canceled() const;
+
+private:
+    std::atomic<bool>       m_canceled;
+    const DWORD             m_start;
+    const unsigned int      m_timeout;
+};
+
+//------------------------------------------------------------------------------
+// A snapshot of the entries in one directory.  Snapshots are immutable once
+// published by dir_cache, so they can be iterated without holding any lock.
+class dir_snapshot : public no_copy
+{
+public:
+    struct entry
+    {
+        const wchar_t*      name;
+        unsigned int        len;
+        unsigned int        attr;
+        unsigned int        reparse_tag;
+        unsigned long long  size;
+        FILETIME            accessed;
+        FILETIME            modified;
+        FILETIME            created;
+    };
+
+                            dir_snapshot(const char* dir);
+    const char*             get_dir() const { return m_dir.c_str(); }
+    unsigned int            count() const { return unsigned(m_entries.size()); }
+    const entry&            get(unsigned int index) const { return m_entries[index]; }
+    bool                    is_slow() const { return m_slow; }
+
+private:
+    friend class dir_cache;
+    bool                    enumerate(dir_source& source, const dir_cancel_token* token);
+    bool                    is_current(dir_source& source, DWORD now) const;
+    bool                    is_recent(DWORD now) const;
+
+    str_moveable            m_dir;
+    std::vector<entry>      m_entries;
+    linear_allocator        m_store;
+    FILETIME                m_dir_modified;
+    DWORD                   m_tick = 0;
+    mutable std::atomic<DWORD> m_validated;
+    unsigned int            m_last_used = 0;
+    bool                    m_slow = false;
+};
+
+//------------------------------------------------------------------------------
+struct dir_cache_stats
+{
+    unsigned int            hits;
+    unsigned int            misses;
+    unsigned int            stale;
+    unsigned int            evictions;
+    unsigned int            uncacheable;
+    unsigned int            background;
+    unsigned int            abandoned;
+    unsigned int            snapshots;
+    unsigned int            entries;
+};
+
+//------------------------------------------------------------------------------
+// LRU cache of directory snapshots, keyed by normalised directory path.  A
+// snapshot is reused while the directory's last write time is unchanged and
+// the snapshot is younger than a short TTL (the TTL bounds how stale the
+// size and time fields of the entries can get, since changing a file's
+// content does not update its parent directory's last write time).
+//
+// Slow directories (UNC paths and network drives) get a longer TTL, but their
+// last write time is still checked.  find() skips that check for a slow
+// snapshot validated within the last few seconds, and otherwise misses, so
+// that it never touches the network; dir_worker revalidates or reloads it.
+// A caller that queues that refresh itself can pass 'stale' to keep using the
+// snapshot in the meantime, for up to the slow TTL.
+class dir_cache
+{
+public:
+    typedef std::shared_ptr<const dir_snapshot> snapshot_ptr;
+
+    static snapshot_ptr     lookup(const char* dir);
+    static snapshot_ptr     find(const char* dir, bool* stale=nullptr);
+    static snapshot_ptr     load(const char* dir, const dir_cancel_token& token);
+    static bool             is_slow(const char* dir);
+    static void             clear();
+    static void             get_stats(dir_cache_stats& out);
+    static void             note_bypass();
+    static dir_source*      set_source(dir_source* source);
+
+private:
+    static snapshot_ptr     find_normalised(const str_base& dir, bool offline, bool* stale=nullptr);
+    static snapshot_ptr     enumerate(const str_base& dir, const dir_cancel_token* token);
+};
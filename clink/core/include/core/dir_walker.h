@@ -0,0 +1,67 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+#include "str.h"
+
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct dir_walk_options
+{
+    unsigned int            max_depth = 8;          // Levels of subdirectories to descend into.
+    unsigned int            max_entries = 10000;    // Stop after finding this many entries.
+    unsigned int            threads = 0;            // Zero picks a number based on the CPU count.
+    bool                    files = true;
+    bool                    directories = true;
+    bool                    hidden = false;
+    bool                    system = false;
+    str_moveable            pattern;                // Wildcard for names to report; empty reports all.
+    std::vector<str_moveable> ignore;               // Wildcards for directory names to skip entirely.
+};
+
+//------------------------------------------------------------------------------
+struct dir_walk_entry
+{
+    str_moveable            path;                   // Relative to the root; directories end with a separator.
+    unsigned int            depth;                  // Zero for entries directly in the root.
+    bool                    dir;
+};
+
+//------------------------------------------------------------------------------
+// Walks a directory tree recursively, enumerating subdirectories in parallel on
+// a small pool of threads.  Each thread prefers the directories it discovered
+// itself, and steals from other threads when it runs out.
+//
+// Entries are reported in a deterministic order regardless of timing:  each
+// directory's entries are sorted by name, and each subdirectory's entries
+// follow the subdirectory itself.  Symlinked and junctioned directories are
+// reported but not descended into, to avoid cycles.
+//
+// When max_entries is reached the walk stops early and the results are
+// truncated.  Which entries are found before stopping can vary from run to
+// run, since directories are enumerated concurrently.
+class dir_walker : public no_copy
+{
+    struct state;
+
+public:
+                            dir_walker(const char* root, const dir_walk_options& options);
+                            ~dir_walker();
+    bool                    start();
+    void                    cancel();
+    bool                    wait(unsigned int timeout_ms=~0u) const;
+    bool                    is_done() const { return wait(0); }
+    bool                    is_truncated() const;
+    bool                    is_canceled() const;
+    void                    get_entries(std::vector<dir_walk_entry>& out) const;
+
+    static bool             walk(const char* root, const dir_walk_options& options, std::vector<dir_walk_entry>& out);
+
+private:
+    void                    join();
+    std::unique_ptr<state>  m_state;
+};
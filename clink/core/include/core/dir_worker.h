@@ -0,0 +1,49 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "dir_cache.h"
+
+#include <memory>
+#include <mutex>
+
+//------------------------------------------------------------------------------
+// A request for dir_worker to load a directory into dir_cache.  The requester
+// may cancel it at any time, and the worker abandons it once its deadline has
+// passed; either way nothing partial is cached.
+class dir_request : public no_copy
+{
+    friend class worker_thread;
+
+public:
+                            dir_request(const char* dir, unsigned int timeout_ms);
+                            ~dir_request();
+    const char*             get_dir() const { return m_dir.c_str(); }
+    void                    cancel() { m_token.cancel(); }
+    bool                    is_done() const;
+    bool                    wait(unsigned int timeout_ms) const;
+    dir_cache::snapshot_ptr get_snapshot() const;
+
+private:
+    void                    complete(dir_cache::snapshot_ptr snapshot);
+
+    str_moveable            m_dir;
+    dir_cancel_token        m_token;
+    HANDLE                  m_done_event;
+    mutable std::mutex      m_mutex;
+    dir_cache::snapshot_ptr m_snapshot;
+};
+
+//------------------------------------------------------------------------------
+// Loads slow directories (UNC paths and network drives) into dir_cache on a
+// background thread, so that the main thread never blocks enumerating them.
+class dir_worker
+{
+public:
+    typedef std::shared_ptr<dir_request> request_ptr;
+
+    static request_ptr      enqueue(const char* dir, unsigned int timeout_ms);
+    static dir_cache::snapshot_ptr load(const char* dir, unsigned int wait_ms, unsigned int timeout_ms);
+    static void             shutdown();
+};
@@ -0,0 +1,44 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str.h"
+
+//------------------------------------------------------------------------------
+// Matches a needle as a subsequence of candidate strings, and scores each match
+// the way fzf does:  consecutive characters and characters at word boundaries,
+// after path separators, or at camelCase humps earn bonuses, and gaps between
+// matched characters cost a penalty.  Higher scores are better matches.
+//
+// The needle is folded once at construction according to the current
+// str_compare_scope, the same way as compiled_wild_pattern, so a single
+// fuzzy_matcher can score many candidates cheaply.  It is not thread safe.
+class fuzzy_matcher
+{
+public:
+                        fuzzy_matcher(const char* needle, int len=-1);
+    bool                empty() const { return !m_needle.length(); }
+    bool                match(const char* text, int len=-1) const;
+    bool                score(const char* text, int len, int& out) const;
+
+    static const int    score_match = 16;
+    static const int    score_gap_start = -3;
+    static const int    score_gap_extension = -1;
+    static const int    bonus_boundary = score_match / 2;
+    static const int    bonus_boundary_white = bonus_boundary + 2;
+    static const int    bonus_boundary_separator = bonus_boundary + 1;
+    static const int    bonus_non_word = score_match / 2;
+    static const int    bonus_camel123 = bonus_boundary + score_gap_extension;
+    static const int    bonus_consecutive = -(score_gap_start + score_gap_extension);
+    static const int    bonus_first_char_multiplier = 2;
+
+private:
+    bool                find(unsigned int& begin, unsigned int& end) const;
+    int                 calc_score(unsigned int begin, unsigned int end) const;
+    wstr_moveable       m_needle;
+    mutable wstr<280>   m_text;
+    mutable wstr<280>   m_folded;
+    const int           m_mode;
+    const bool          m_fuzzy_accents;
+};
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "dir_cache.h"
 #include "str.h"
 
 //------------------------------------------------------------------------------
@@ -19,6 +20,17 @@ public:
         FILETIME            created;
     };
 
+    // While in scope, globbing a slow directory on the current thread never
+    // blocks on the network; see use_cache().
+    class nonblocking_scope : public no_copy
+    {
+    public:
+                        nonblocking_scope();
+                        ~nonblocking_scope();
+    private:
+        const bool      m_prev;
+    };
+
                         globber(const char* pattern);
                         ~globber();
     void                files(bool state)       { m_files = state; }
@@ -34,9 +46,16 @@ public:
 private:
                         globber(const globber&) = delete;
     void                operator = (const globber&) = delete;
+    bool                use_cache(const char* pattern);
+    bool                get_entry(dir_snapshot::entry& out) const;
+    void                seek_snapshot();
     void                next_file();
     WIN32_FIND_DATAW    m_data;
     HANDLE              m_handle;
+    dir_cache::snapshot_ptr m_snapshot;
+    unsigned int        m_snapshot_index = 0;
+    wstr<32>            m_prefix;
+    bool                m_dos_dot = false;
     str<280>            m_root;
     bool                m_files;
     bool                m_directories;
@@ -0,0 +1,37 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Recognizes words from a fixed set of ASCII keywords, ignoring ASCII case.
+//
+// The constructor searches for a hash seed that gives every keyword its own
+// slot (a perfect hash), so a lookup hashes the word once, folding case as it
+// goes, and compares against at most one keyword.  Intended for small sets
+// that are tested very often, such as CMD's internal command names.
+//
+// The keyword set does not own the keyword strings.
+class keyword_set : public no_copy
+{
+public:
+                            keyword_set(const char* const* keywords, unsigned int count);
+    int                     find(const char* word, int len=-1) const;
+    bool                    contains(const char* word, int len=-1) const { return find(word, len) >= 0; }
+    unsigned int            size() const { return m_count; }
+
+private:
+    static unsigned int     hash(const char* word, unsigned int len, unsigned int seed);
+    bool                    build(unsigned int slots, unsigned int seed);
+    const char* const*      m_keywords;
+    const unsigned int      m_count;
+    std::vector<short>      m_slots;        // Keyword index, or -1.
+    unsigned int            m_mask = 0;
+    unsigned int            m_seed = 0;
+    unsigned int            m_min_len = 0;
+    unsigned int            m_max_len = 0;
+};
@@ -4,6 +4,24 @@
 #pragma once
 
 //------------------------------------------------------------------------------
+// Statistics for the calling thread's page pool.
+struct linear_allocator_stats
+{
+    unsigned int            allocs;         // Pages allocated from the heap.
+    unsigned int            reuses;         // Pages taken from the pool.
+    unsigned int            frees;          // Pages freed to the heap.
+    unsigned int            oversized;      // Oversized allocations.
+    unsigned int            pooled_pages;   // Pages currently in the pool.
+    size_t                  pooled_bytes;   // Bytes currently in the pool.
+};
+
+//------------------------------------------------------------------------------
+// Pages are recycled through a per-thread pool instead of going back to the
+// heap, so allocators that are reset or cleared repeatedly (e.g. once per
+// completion) stop making heap calls once they reach a steady state.  After
+// the first few pages, page sizes double periodically so large workloads
+// don't need huge numbers of pages.  Oversized allocations get their own
+// blocks on a side list, and are not pooled.
 class linear_allocator
 {
 public:
@@ -19,15 +37,23 @@ public:
     bool                    fits(unsigned int) const;
     bool                    oversized(unsigned int) const;
 
+    static void             get_pool_stats(linear_allocator_stats& out);
+    static void             trim_pool();
+
     bool                    unittest_at_end(void* ptr, unsigned int size) const;
     bool                    unittest_in_prev_page(void* ptr, unsigned int size) const;
 
 private:
     bool                    new_page();
     void                    free_chain(bool keep_one=false);
+    void                    free_oversized();
+    unsigned int            page_size(unsigned int index) const;
     char*                   m_ptr = nullptr;
+    char*                   m_oversized = nullptr;
     unsigned int            m_used;
     unsigned int            m_max;
+    unsigned int            m_page_size;
+    unsigned int            m_pages = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -75,8 +101,8 @@ inline bool linear_allocator::unittest_at_end(void* ptr, unsigned int size) cons
 inline bool linear_allocator::unittest_in_prev_page(void* _ptr, unsigned int size) const
 {
     char* ptr = (char*)_ptr;
-    char* prev_page = *reinterpret_cast<char**>(m_ptr);
     if (oversized(size))
-        return ptr == prev_page + sizeof(m_ptr);
+        return m_oversized && ptr == m_oversized + sizeof(m_ptr);
+    char* prev_page = *reinterpret_cast<char**>(m_ptr);
     return ptr >= prev_page + sizeof(m_ptr) && ptr + size <= prev_page + m_max;
 }
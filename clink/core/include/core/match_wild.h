@@ -4,9 +4,12 @@
 #pragma once
 
 #include <core/path.h>
+#include <core/str.h>
 #include <core/str_compare.h>
 #include <core/str_iter.h>
 
+#include <vector>
+
 class str_base;
 
 namespace path
@@ -155,7 +158,7 @@ back_track:
                 if (!final_file_component)
                 {
                     int x;
-                    for (str_iter tmp(_pattern); x = tmp.peek(); tmp.next())
+                    for (str_iter_impl<T> tmp(_pattern); x = tmp.peek(); tmp.next())
                         if (path::is_separator(x))
                         {
                             final_pattern_component = tmp.get_pointer() + 1;
@@ -165,7 +168,7 @@ back_track:
                         {
                             has_final_wildcard = true;
                         }
-                    for (str_iter tmp(_file); x = tmp.peek(); tmp.next())
+                    for (str_iter_impl<T> tmp(_file); x = tmp.peek(); tmp.next())
                         if (path::is_separator(x))
                             final_file_component = tmp.get_pointer() + 1;
                     if (!final_pattern_component)
@@ -244,4 +247,35 @@ bool match_wild(const str_impl<T>& pattern, const str_impl<T>& file, star_matche
     return match_wild(pattern_iter, file_iter, match_everything);
 }
 
+//------------------------------------------------------------------------------
+// A pattern prepared once for matching against many candidates, with the same
+// results as match_wild() under the str_compare_scope that was current when
+// it was constructed.  The pattern is case folded (etc) up front, and each
+// candidate is folded in one pass instead of per character comparison.  The
+// pattern's literal segments must all occur in order in a candidate, which
+// rejects most candidates before running the full matcher.
+//
+// Not thread safe; match() reuses an internal buffer.
+class compiled_wild_pattern
+{
+public:
+                        compiled_wild_pattern(const char* pattern, int len=-1);
+    bool                match(const char* file, int len=-1, star_matches_everything match_everything=no) const;
+    static void         fold(wstr_base& inout, int mode, bool fuzzy_accents);
+
+private:
+    struct segment
+    {
+        unsigned int    offset;
+        unsigned int    length;
+    };
+
+    bool                has_segments(const wchar_t* file, unsigned int len) const;
+    wstr_moveable       m_pattern;
+    std::vector<segment> m_segments;
+    mutable wstr<280>   m_file;
+    const int           m_mode;
+    const bool          m_fuzzy_accents;
+};
+
 }; // namespace path
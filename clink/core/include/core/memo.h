@@ -0,0 +1,55 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+#include "str.h"
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Accumulates a hash of the inputs that a computed result depends on, so the
+// result can be reused until one of the inputs changes.  Each input is hashed
+// along with its length, so adjacent inputs can't run together.
+class fingerprint
+{
+public:
+    void                    add(const char* value, int len=-1);
+    void                    add(long long value);
+    void                    add_cwd();
+    void                    add_env(const char* name);
+    void                    add_path_stamp(const char* path);
+    unsigned long long      get() const { return m_hash; }
+
+private:
+    void                    mix(const void* data, size_t len);
+    unsigned long long      m_hash = 0xcbf29ce484222325ull;
+};
+
+//------------------------------------------------------------------------------
+// Remembers the most recently used pairs of result strings, keyed by the
+// fingerprint of the inputs that produced them.
+class memo_cache : public no_copy
+{
+public:
+                            memo_cache(unsigned int capacity=4);
+    bool                    find(unsigned long long key, str_base& out, str_base& rout);
+    void                    store(unsigned long long key, const char* out, const char* rout);
+    void                    clear();
+    unsigned int            get_hits() const { return m_hits; }
+    unsigned int            get_misses() const { return m_misses; }
+
+private:
+    struct entry
+    {
+        unsigned long long  key;
+        str_moveable        out;
+        str_moveable        rout;
+    };
+
+    std::vector<entry>      m_entries;  // Most recently used first.
+    const unsigned int      m_capacity;
+    unsigned int            m_hits = 0;
+    unsigned int            m_misses = 0;
+};
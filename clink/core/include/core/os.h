@@ -59,6 +59,7 @@ private:
 int     get_path_type(const char* path);
 int     get_drive_type(const char* path, unsigned int len=-1);
 int     get_file_size(const char* path);
+bool    get_file_stamp(const char* path, DWORD& attr, unsigned long long& size, FILETIME& modified);
 bool    is_hidden(const char* path);
 void    get_current_dir(str_base& out);
 bool    set_current_dir(const char* dir);
@@ -4,7 +4,7 @@
 #pragma once
 
 #include "str.h"
-#include "str_map.h"
+#include "str_hashmap.h"
 
 #include <map>
 #include <vector>
@@ -12,17 +12,18 @@
 class setting;
 
 //------------------------------------------------------------------------------
-typedef str_map_caseless<setting*>::type setting_map;
+typedef str_hashmap_caseless<setting*> setting_map;
 
 //------------------------------------------------------------------------------
+// Iterates settings in sorted order.
 class setting_iter
 {
 public:
-                            setting_iter(setting_map& map);
+                            setting_iter(const setting_map& map);
     setting*                next();
 private:
-    setting_map&            m_map;
-    setting_map::iterator   m_iter;
+    std::vector<const setting_map::value_type*> m_sorted;
+    size_t                  m_index = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,243 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "str_hash.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Compares strings ignoring ASCII case, consistent with
+// str_hash_words_caseless().
+inline bool str_iequals_ascii(const char* a, const char* b)
+{
+    for (;; ++a, ++b)
+    {
+        int ca = (unsigned char)*a;
+        int cb = (unsigned char)*b;
+        if (ca != cb)
+        {
+            if (ca >= 'A' && ca <= 'Z') ca |= 0x20;
+            if (cb >= 'A' && cb <= 'Z') cb |= 0x20;
+            if (ca != cb)
+                return false;
+        }
+        if (!ca)
+            return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Hash map keyed by strings, ignoring ASCII case.  Like str_map_caseless, it
+// does not own the key strings.
+//
+// Entries are stored contiguously in insertion order, and an open addressing
+// table of indices (with linear probing) finds them; each entry's hash is
+// cached so probing and growing rarely touch the keys.  Erasing moves the last
+// entry into the erased entry's place, so iteration order is not stable and
+// erasing invalidates iterators.  Use get_sorted() where callers need sorted
+// order.
+template <typename V>
+class str_hashmap_caseless
+{
+public:
+    typedef std::pair<const char*, V> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    iterator                begin() { return m_entries.begin(); }
+    iterator                end() { return m_entries.end(); }
+    const_iterator          begin() const { return m_entries.begin(); }
+    const_iterator          end() const { return m_entries.end(); }
+    size_t                  size() const { return m_entries.size(); }
+    bool                    empty() const { return m_entries.empty(); }
+
+    void                    clear();
+    void                    reserve(size_t count);
+    iterator                find(const char* key);
+    const_iterator          find(const char* key) const;
+    std::pair<iterator, bool> emplace(const char* key, const V& value);
+    V&                      operator[](const char* key);
+    size_t                  erase(const char* key);
+    void                    get_sorted(std::vector<const value_type*>& out) const;
+
+private:
+    enum : unsigned int { c_empty = 0, c_min_slots = 16 };
+
+    bool                    find_slot(const char* key, unsigned int hash, unsigned int& slot) const;
+    void                    grow();
+    void                    rehash(size_t slots);
+    std::vector<value_type> m_entries;
+    std::vector<unsigned int> m_hashes;     // Parallel to m_entries.
+    std::vector<unsigned int> m_slots;      // Entry index + 1; c_empty means empty.
+};
+
+//------------------------------------------------------------------------------
+template <typename V>
+void str_hashmap_caseless<V>::clear()
+{
+    m_entries.clear();
+    m_hashes.clear();
+    std::fill(m_slots.begin(), m_slots.end(), c_empty);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+void str_hashmap_caseless<V>::reserve(size_t count)
+{
+    m_entries.reserve(count);
+    m_hashes.reserve(count);
+
+    size_t slots = m_slots.empty() ? c_min_slots : m_slots.size();
+    while (count * 4 > slots * 3)
+        slots *= 2;
+    if (slots > m_slots.size())
+        rehash(slots);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+typename str_hashmap_caseless<V>::iterator str_hashmap_caseless<V>::find(const char* key)
+{
+    unsigned int slot;
+    if (!find_slot(key, str_hash_words_caseless(key, strlen(key)), slot))
+        return end();
+    return begin() + (m_slots[slot] - 1);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+typename str_hashmap_caseless<V>::const_iterator str_hashmap_caseless<V>::find(const char* key) const
+{
+    unsigned int slot;
+    if (!find_slot(key, str_hash_words_caseless(key, strlen(key)), slot))
+        return end();
+    return begin() + (m_slots[slot] - 1);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+std::pair<typename str_hashmap_caseless<V>::iterator, bool> str_hashmap_caseless<V>::emplace(const char* key, const V& value)
+{
+    if ((m_entries.size() + 1) * 4 > m_slots.size() * 3)
+        grow();
+
+    const unsigned int hash = str_hash_words_caseless(key, strlen(key));
+    unsigned int slot;
+    if (find_slot(key, hash, slot))
+        return std::make_pair(begin() + (m_slots[slot] - 1), false);
+
+    m_entries.emplace_back(key, value);
+    m_hashes.push_back(hash);
+    m_slots[slot] = unsigned(m_entries.size());
+    return std::make_pair(end() - 1, true);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+V& str_hashmap_caseless<V>::operator[](const char* key)
+{
+    return emplace(key, V()).first->second;
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+size_t str_hashmap_caseless<V>::erase(const char* key)
+{
+    unsigned int slot;
+    if (!find_slot(key, str_hash_words_caseless(key, strlen(key)), slot))
+        return 0;
+
+    const unsigned int mask = unsigned(m_slots.size()) - 1;
+    const unsigned int index = m_slots[slot] - 1;
+
+    // Shift later slots in the probe sequence back, so that no tombstones are
+    // needed.
+    unsigned int hole = slot;
+    for (unsigned int i = (slot + 1) & mask; m_slots[i] != c_empty; i = (i + 1) & mask)
+    {
+        const unsigned int home = m_hashes[m_slots[i] - 1] & mask;
+        if (((hole - home) & mask) <= ((i - home) & mask))
+        {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole] = c_empty;
+
+    // Keep the entries contiguous by moving the last one into the gap.
+    const unsigned int last = unsigned(m_entries.size()) - 1;
+    if (index != last)
+    {
+        unsigned int i = m_hashes[last] & mask;
+        while (m_slots[i] != last + 1)
+            i = (i + 1) & mask;
+        m_slots[i] = index + 1;
+        m_entries[index] = std::move(m_entries[last]);
+        m_hashes[index] = m_hashes[last];
+    }
+
+    m_entries.pop_back();
+    m_hashes.pop_back();
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+void str_hashmap_caseless<V>::get_sorted(std::vector<const value_type*>& out) const
+{
+    out.clear();
+    out.reserve(m_entries.size());
+    for (const auto& entry : m_entries)
+        out.push_back(&entry);
+
+    std::sort(out.begin(), out.end(), [] (const value_type* a, const value_type* b) {
+        return stricmp(a->first, b->first) < 0;
+    });
+}
+
+//------------------------------------------------------------------------------
+// Returns whether key was found.  Either way, slot receives the slot where the
+// key is or belongs.
+template <typename V>
+bool str_hashmap_caseless<V>::find_slot(const char* key, unsigned int hash, unsigned int& slot) const
+{
+    if (m_slots.empty())
+        return false;
+
+    const unsigned int mask = unsigned(m_slots.size()) - 1;
+    for (slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        const unsigned int index = m_slots[slot];
+        if (index == c_empty)
+            return false;
+        if (m_hashes[index - 1] == hash && str_iequals_ascii(m_entries[index - 1].first, key))
+            return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+void str_hashmap_caseless<V>::grow()
+{
+    rehash(m_slots.empty() ? c_min_slots : m_slots.size() * 2);
+}
+
+//------------------------------------------------------------------------------
+template <typename V>
+void str_hashmap_caseless<V>::rehash(size_t slots)
+{
+    m_slots.assign(slots, c_empty);
+
+    const unsigned int mask = unsigned(slots) - 1;
+    for (unsigned int index = 0; index < m_hashes.size(); ++index)
+    {
+        unsigned int i = m_hashes[index] & mask;
+        while (m_slots[i] != c_empty)
+            i = (i + 1) & mask;
+        m_slots[i] = index + 1;
+    }
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct str_intern_stats
+{
+    unsigned int            hits;           // Acquires that found an existing string.
+    unsigned int            allocs;         // Acquires that allocated a new string.
+    unsigned int            reclaimed;      // Strings freed after going unused.
+    unsigned int            live;           // Strings currently in the pool.
+    unsigned int            idle;           // Strings with no references.
+    size_t                  bytes;          // Bytes allocated for live strings.
+};
+
+//------------------------------------------------------------------------------
+// Deduplicates identical strings, so that sets of strings generated over and
+// over again (e.g. completions for each keystroke) share one copy instead of
+// being copied again each time.
+//
+// Strings are reference counted.  When a string's last reference is released
+// it is not freed right away; it's reclaimed only after it has gone unused for
+// several generations, so that the next generation can reacquire it cheaply.
+// Callers advance the generation when they start producing a new set.
+//
+// Acquired strings are immutable and remain valid until released.  All methods
+// are thread safe.
+class str_intern_pool : public no_copy
+{
+public:
+                            str_intern_pool(unsigned int grace_generations=4);
+                            ~str_intern_pool();
+    const char*             acquire(const char* str, int len=-1);
+    void                    release(const char* str);
+    void                    release(const char* const* strs, unsigned int count);
+    void                    next_generation();
+    void                    get_stats(str_intern_stats& out) const;
+
+private:
+    struct entry;
+
+    entry*                  find(const char* str, unsigned int len, unsigned int hash) const;
+    void                    insert(entry* e);
+    void                    erase(entry* e);
+    void                    grow();
+    void                    release_locked(const char* str);
+    static entry*           from_str(const char* str);
+    mutable std::mutex      m_mutex;
+    std::vector<entry*>     m_slots;        // Open addressing; linear probing.
+    std::deque<entry*>      m_idle;         // Oldest idle entries first.
+    unsigned int            m_count = 0;
+    unsigned int            m_generation = 0;
+    const unsigned int      m_grace;
+    str_intern_stats        m_stats = {};
+};
@@ -0,0 +1,74 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+
+class str_base;
+
+//------------------------------------------------------------------------------
+// A byte queue between one producer thread and one consumer.  Data is stored
+// in a chain of fixed size segments, so it grows without copying; segments are
+// released as the consumer drains them.  The consumer can read whole lines as
+// soon as they arrive, before the producer has finished.
+//
+// Once more than spill_threshold bytes are waiting in memory, further data is
+// spilled to a temporary file and is loaded back one segment at a time as the
+// consumer catches up, so a producer that outpaces the consumer can't use up
+// unbounded memory.
+//
+// Only the wait_readable() method blocks.  After the consumer closes the
+// buffer, anything the producer writes is discarded.
+class stream_buffer : public no_copy
+{
+    struct segment;
+
+public:
+                            stream_buffer(unsigned int segment_size=4096, unsigned int spill_threshold=1024*1024);
+                            ~stream_buffer();
+
+    // Producer.
+    void                    write(const char* data, unsigned int len);
+    void                    finish();
+
+    // Consumer.
+    void                    close();
+    bool                    is_finished() const;
+    unsigned int            available() const;
+    bool                    can_read(unsigned int lines, unsigned int bytes, bool all=false) const;
+    bool                    wait_readable(unsigned int lines, unsigned int bytes, bool all=false, unsigned int timeout_ms=INFINITE);
+    bool                    read_line(str_base& out, bool keep_eol=false);
+    unsigned int            read(str_base& out, unsigned int max);
+    unsigned int            peek(char* out, unsigned int max);
+
+private:
+    bool                    can_read_locked(unsigned int lines, unsigned int bytes, bool all) const;
+    unsigned int            take_locked(str_base* out, unsigned int len);
+    segment*                new_segment();
+    void                    append_segment(segment* seg);
+    bool                    spill_locked(const char* data, unsigned int len);
+    bool                    load_locked();
+    void                    clear_locked();
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;
+    segment*                m_head = nullptr;
+    segment*                m_tail = nullptr;
+    segment*                m_spare = nullptr;
+    unsigned int            m_head_offset = 0;  // Read position in m_head.
+    unsigned int            m_available = 0;
+    unsigned int            m_newlines = 0;     // Newlines in the available data.
+    unsigned int            m_buffered = 0;     // Available data in memory.
+    FILE*                   m_file = nullptr;   // Spilled data follows the data in memory.
+    long long               m_file_read = 0;
+    long long               m_file_write = 0;
+    const unsigned int      m_segment_size;
+    const unsigned int      m_spill_threshold;
+    bool                    m_spill_failed = false;
+    bool                    m_finished = false;
+    bool                    m_closed = false;
+};
@@ -0,0 +1,67 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "base.h"
+
+#include <atomic>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+// Timing spans for finding where the time goes between a keystroke and a
+// redraw.  When tracing is off, a trace_scope costs one load and one branch.
+// When tracing is on, each thread records completed spans into its own fixed
+// size ring buffer without taking any locks, and trace::dump() writes them as
+// Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev can open.
+//
+// Span names and details must be string literals, or come from trace::intern().
+// Interning takes a lock, so callers that record the same strings repeatedly
+// should intern them once and reuse the result.
+namespace trace
+{
+
+extern std::atomic<bool> s_enabled;
+
+inline bool is_enabled() { return s_enabled.load(std::memory_order_relaxed); }
+void        enable(bool enable);
+long long   now();
+const char* intern(const char* s);
+void        record(const char* name, const char* detail, long long begin, long long end);
+bool        dump(FILE* out);
+bool        dump(const char* filename);
+
+}; // namespace trace
+
+//------------------------------------------------------------------------------
+class trace_scope : public no_copy
+{
+public:
+                trace_scope(const char* name, const char* detail=nullptr);
+                ~trace_scope();
+private:
+    void        begin(const char* name, const char* detail);
+    void        end();
+    const char* m_name = nullptr;
+    const char* m_detail;
+    long long   m_begin;
+};
+
+//------------------------------------------------------------------------------
+inline trace_scope::trace_scope(const char* name, const char* detail)
+{
+    if (trace::is_enabled())
+        begin(name, detail);
+}
+
+//------------------------------------------------------------------------------
+inline trace_scope::~trace_scope()
+{
+    if (m_name)
+        end();
+}
+
+//------------------------------------------------------------------------------
+#define TRACE_SCOPE_CONCAT_IMPL(a, b)   a##b
+#define TRACE_SCOPE_CONCAT(a, b)        TRACE_SCOPE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(...)                trace_scope TRACE_SCOPE_CONCAT(_trace_scope_, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,401 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_cache.h"
+#include "os.h"
+#include "path.h"
+#include "str.h"
+
+#include <mutex>
+
+//------------------------------------------------------------------------------
+static const unsigned int c_max_snapshots = 8;
+static const unsigned int c_max_entries = 200000;
+static const unsigned int c_ttl_ms = 3000;
+static const unsigned int c_slow_ttl_ms = 30000;
+
+//------------------------------------------------------------------------------
+static std::mutex s_mutex;
+static std::vector<std::shared_ptr<dir_snapshot>> s_snapshots;
+static unsigned int s_use_counter = 0;
+static dir_cache_stats s_stats = {};
+
+//------------------------------------------------------------------------------
+static bool normalise_dir(const char* dir, str_base& out)
+{
+    if (!dir || !*dir)
+        os::get_current_dir(out);
+    else if (!os::get_full_path_name(dir, out))
+        return false;
+
+    path::normalise(out);
+    path::maybe_strip_last_separator(out);
+    return !out.empty();
+}
+
+//------------------------------------------------------------------------------
+class win32_dir_source : public dir_source
+{
+public:
+    bool                    is_slow(const char* dir) override;
+    bool                    get_modified(const char* dir, FILETIME& out) override;
+    HANDLE                  find_first(const wchar_t* pattern, WIN32_FIND_DATAW& fd) override;
+    bool                    find_next(HANDLE h, WIN32_FIND_DATAW& fd) override;
+    void                    find_close(HANDLE h) override;
+};
+
+//------------------------------------------------------------------------------
+bool win32_dir_source::is_slow(const char* dir)
+{
+    // UNC paths are slow, and so are remote (or unknown or invalid) drives.
+    // Removable drives are accepted because typically these are thumb drives
+    // these days, which are fast.
+    if (path::is_separator(dir[0]) && path::is_separator(dir[1]))
+        return true;
+
+    str<280> drive;
+    if (!path::get_drive(dir, drive))
+        return false;
+
+    path::append(drive, ""); // Because get_drive_type() requires a trailing path separator.
+    return os::get_drive_type(drive.c_str()) < os::drive_type_removable;
+}
+
+//------------------------------------------------------------------------------
+bool win32_dir_source::get_modified(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    out = data.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+HANDLE win32_dir_source::find_first(const wchar_t* pattern, WIN32_FIND_DATAW& fd)
+{
+    return FindFirstFileW(pattern, &fd);
+}
+
+//------------------------------------------------------------------------------
+bool win32_dir_source::find_next(HANDLE h, WIN32_FIND_DATAW& fd)
+{
+    return !!FindNextFileW(h, &fd);
+}
+
+//------------------------------------------------------------------------------
+void win32_dir_source::find_close(HANDLE h)
+{
+    FindClose(h);
+}
+
+//------------------------------------------------------------------------------
+static win32_dir_source s_win32_source;
+static std::atomic<dir_source*> s_source(&s_win32_source);
+
+//------------------------------------------------------------------------------
+dir_cancel_token::dir_cancel_token(unsigned int timeout_ms)
+: m_canceled(false)
+, m_start(GetTickCount())
+, m_timeout(timeout_ms)
+{
+}
+
+//------------------------------------------------------------------------------
+bool dir_cancel_token::is_canceled() const
+{
+    if (m_canceled)
+        return true;
+    return m_timeout != INFINITE && GetTickCount() - m_start >= m_timeout;
+}
+
+//------------------------------------------------------------------------------
+dir_snapshot::dir_snapshot(const char* dir)
+: m_dir(dir)
+, m_store(64 * 1024)
+, m_validated(0)
+{
+    memset(&m_dir_modified, 0, sizeof(m_dir_modified));
+}
+
+//------------------------------------------------------------------------------
+bool dir_snapshot::enumerate(dir_source& source, const dir_cancel_token* token)
+{
+    // Capture the directory's modified time before enumerating, so that any
+    // change made during enumeration causes the next lookup to refresh.
+    if (!source.get_modified(m_dir.c_str(), m_dir_modified))
+        return false;
+
+    str<280> pattern(m_dir.c_str());
+    path::append(pattern, "*");
+    wstr<280> wpattern(pattern.c_str());
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = source.find_first(wpattern.c_str(), fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = true;
+    do
+    {
+        // A partial snapshot is never published.
+        if (m_entries.size() >= c_max_entries || (token && token->is_canceled()))
+        {
+            ok = false;
+            break;
+        }
+
+        const unsigned int len = unsigned(wcslen(fd.cFileName));
+        wchar_t* name = static_cast<wchar_t*>(m_store.alloc((len + 1) * sizeof(wchar_t)));
+        if (!name)
+        {
+            ok = false;
+            break;
+        }
+        memcpy(name, fd.cFileName, (len + 1) * sizeof(wchar_t));
+
+        entry e;
+        e.name = name;
+        e.len = len;
+        e.attr = fd.dwFileAttributes;
+        e.reparse_tag = fd.dwReserved0;
+        e.size = (unsigned long long)(fd.nFileSizeHigh) << 32 | fd.nFileSizeLow;
+        e.accessed = fd.ftLastAccessTime;
+        e.modified = fd.ftLastWriteTime;
+        e.created = fd.ftCreationTime;
+        m_entries.emplace_back(e);
+    }
+    while (source.find_next(h, fd));
+
+    source.find_close(h);
+
+    m_tick = GetTickCount();
+    m_validated = m_tick;
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+bool dir_snapshot::is_current(dir_source& source, DWORD now) const
+{
+    if (now - m_tick > (m_slow ? c_slow_ttl_ms : c_ttl_ms))
+        return false;
+
+    FILETIME modified;
+    if (!source.get_modified(m_dir.c_str(), modified))
+        return false;
+
+    if (CompareFileTime(&modified, &m_dir_modified) != 0)
+        return false;
+
+    m_validated = now;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Whether a slow snapshot was validated recently enough to be trusted without
+// checking the directory's modified time again.
+bool dir_snapshot::is_recent(DWORD now) const
+{
+    return now - m_tick <= c_slow_ttl_ms && now - m_validated <= c_ttl_ms;
+}
+
+//------------------------------------------------------------------------------
+dir_cache::snapshot_ptr dir_cache::find_normalised(const str_base& dir, bool offline, bool* stale)
+{
+    std::shared_ptr<dir_snapshot> snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (const auto& s : s_snapshots)
+        {
+            if (dir.iequals(s->get_dir()))
+            {
+                snapshot = s;
+                break;
+            }
+        }
+    }
+
+    if (!snapshot)
+        return nullptr;
+
+    // An offline caller can't afford a network round trip to validate a slow
+    // snapshot, so it only gets one that was validated recently, unless it
+    // will refresh the snapshot in the background.  Leave it in the cache
+    // either way; a blocking caller can still revalidate it.
+    const DWORD now = GetTickCount();
+    if (offline && snapshot->is_slow() && !snapshot->is_recent(now))
+    {
+        if (!stale || now - snapshot->m_tick > c_slow_ttl_ms)
+            return nullptr;
+        *stale = true;
+    }
+
+    // Validate outside the lock, since it touches the file system.
+    const bool current = (offline && snapshot->is_slow()) || snapshot->is_current(*s_source.load(), now);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!current)
+    {
+        s_stats.stale++;
+        for (auto iter = s_snapshots.begin(); iter != s_snapshots.end(); ++iter)
+        {
+            if (*iter == snapshot)
+            {
+                s_snapshots.erase(iter);
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    s_stats.hits++;
+    snapshot->m_last_used = ++s_use_counter;
+    return snapshot;
+}
+
+//------------------------------------------------------------------------------
+// Like lookup(), but never enumerates, and never touches the network to
+// validate a slow directory's snapshot.  If 'stale' is given, it is set to true
+// when the snapshot returned is due to be revalidated.
+dir_cache::snapshot_ptr dir_cache::find(const char* _dir, bool* stale)
+{
+    if (stale)
+        *stale = false;
+
+    str<280> dir;
+    if (!normalise_dir(_dir, dir))
+        return nullptr;
+
+    return find_normalised(dir, true, stale);
+}
+
+//------------------------------------------------------------------------------
+dir_cache::snapshot_ptr dir_cache::lookup(const char* _dir)
+{
+    str<280> dir;
+    if (!normalise_dir(_dir, dir))
+        return nullptr;
+
+    if (snapshot_ptr snapshot = find_normalised(dir, false))
+        return snapshot;
+
+    return enumerate(dir, nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Like lookup(), but the enumeration can be canceled.  This is meant for
+// background threads loading slow directories.
+dir_cache::snapshot_ptr dir_cache::load(const char* _dir, const dir_cancel_token& token)
+{
+    str<280> dir;
+    if (!normalise_dir(_dir, dir))
+        return nullptr;
+
+    if (snapshot_ptr snapshot = find_normalised(dir, false))
+        return snapshot;
+
+    return enumerate(dir, &token);
+}
+
+//------------------------------------------------------------------------------
+bool dir_cache::is_slow(const char* _dir)
+{
+    str<280> dir;
+    if (!normalise_dir(_dir, dir))
+        return false;
+
+    return s_source.load()->is_slow(dir.c_str());
+}
+
+//------------------------------------------------------------------------------
+dir_cache::snapshot_ptr dir_cache::enumerate(const str_base& dir, const dir_cancel_token* token)
+{
+    dir_source& source = *s_source.load();
+
+    // Enumerate outside the lock; the file system can be slow, and another
+    // thread racing to enumerate the same directory is harmless.
+    auto snapshot = std::make_shared<dir_snapshot>(dir.c_str());
+    snapshot->m_slow = source.is_slow(dir.c_str());
+    if (!snapshot->enumerate(source, token))
+    {
+        if (token && token->is_canceled())
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_stats.abandoned++;
+        }
+        else
+        {
+            note_bypass();
+        }
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    s_stats.misses++;
+    if (token)
+        s_stats.background++;
+
+    for (auto iter = s_snapshots.begin(); iter != s_snapshots.end(); ++iter)
+    {
+        if (dir.iequals((*iter)->get_dir()))
+        {
+            s_snapshots.erase(iter);
+            break;
+        }
+    }
+
+    if (s_snapshots.size() >= c_max_snapshots)
+    {
+        auto lru = s_snapshots.begin();
+        for (auto iter = s_snapshots.begin(); iter != s_snapshots.end(); ++iter)
+            if ((*iter)->m_last_used < (*lru)->m_last_used)
+                lru = iter;
+        s_snapshots.erase(lru);
+        s_stats.evictions++;
+    }
+
+    snapshot->m_last_used = ++s_use_counter;
+    s_snapshots.emplace_back(snapshot);
+    return snapshot;
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_snapshots.clear();
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::get_stats(dir_cache_stats& out)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    out = s_stats;
+    out.snapshots = unsigned(s_snapshots.size());
+    out.entries = 0;
+    for (const auto& snapshot : s_snapshots)
+        out.entries += snapshot->count();
+}
+
+//------------------------------------------------------------------------------
+void dir_cache::note_bypass()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_stats.uncacheable++;
+}
+
+//------------------------------------------------------------------------------
+// Substitutes the file system operations; nullptr restores the default.
+// Returns the previous source.
+dir_source* dir_cache::set_source(dir_source* source)
+{
+    dir_source* prev = s_source.exchange(source ? source : &s_win32_source);
+    return prev == &s_win32_source ? nullptr : prev;
+}
@@ -0,0 +1,455 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_walker.h"
+#include "match_wild.h"
+#include "str_compare.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//------------------------------------------------------------------------------
+static const unsigned int c_max_threads = 8;
+static const char c_sep = PATH_SEP[0];
+
+
+
+//------------------------------------------------------------------------------
+struct raw_entry
+{
+    str_moveable            name;
+    bool                    dir;
+    bool                    hidden;
+    bool                    system;
+    bool                    link;
+};
+
+//------------------------------------------------------------------------------
+// Enumerates one directory.  Checks for cancellation between entries.
+static void enum_dir(const char* dir, std::vector<raw_entry>& out, const std::atomic<bool>& canceled)
+{
+    wstr<280> pattern(dir);
+    if (pattern.length() && pattern.c_str()[pattern.length() - 1] != '\\')
+        pattern << L"\\";
+    pattern << L"*";
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (h == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        const wchar_t* name = fd.cFileName;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+            continue;
+
+        const DWORD attr = fd.dwFileAttributes;
+        raw_entry entry;
+        entry.name = name;
+        entry.dir = !!(attr & FILE_ATTRIBUTE_DIRECTORY);
+        entry.hidden = !!(attr & FILE_ATTRIBUTE_HIDDEN);
+        entry.system = !!(attr & FILE_ATTRIBUTE_SYSTEM);
+        entry.link = !!(attr & FILE_ATTRIBUTE_REPARSE_POINT);
+        out.emplace_back(std::move(entry));
+    }
+    while (!canceled && FindNextFileW(h, &fd));
+
+    FindClose(h);
+}
+
+//------------------------------------------------------------------------------
+// Sorts names ignoring ASCII case, with an ordinal tie breaker so the order is
+// fully deterministic.
+static bool name_less(const char* a, const char* b)
+{
+    const int cmp = _stricmp(a, b);
+    return cmp ? cmp < 0 : strcmp(a, b) < 0;
+}
+
+
+
+//------------------------------------------------------------------------------
+// Each directory is a node.  Workers fill in nodes independently; assembling
+// the results walks the tree in sorted order afterwards, which is what makes
+// the order deterministic.
+struct walk_node
+{
+    struct item
+    {
+        str_moveable        name;
+        bool                dir;
+        bool                report;
+        std::unique_ptr<walk_node> child;
+    };
+
+    str_moveable            rel;                    // Relative path, with trailing separator.
+    unsigned int            depth;
+    std::vector<item>       items;
+};
+
+//------------------------------------------------------------------------------
+struct walk_queue
+{
+    std::mutex              mutex;
+    std::deque<walk_node*>  nodes;
+};
+
+//------------------------------------------------------------------------------
+// compiled_wild_pattern::match() isn't reentrant, so each thread gets its own.
+struct walk_patterns
+{
+    std::unique_ptr<path::compiled_wild_pattern> pattern;
+    std::vector<std::unique_ptr<path::compiled_wild_pattern>> ignore;
+};
+
+//------------------------------------------------------------------------------
+struct dir_walker::state
+{
+    str_moveable            root;
+    unsigned int            max_depth;
+    unsigned int            max_entries;
+    unsigned int            num_threads;
+    bool                    files;
+    bool                    directories;
+    bool                    hidden;
+    bool                    system;
+    std::vector<walk_patterns> patterns;            // One per thread.
+
+    walk_node               tree;
+    std::vector<walk_queue> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<bool>       canceled { false };
+    std::atomic<bool>       truncated { false };
+    std::atomic<unsigned int> found { 0 };
+    std::atomic<unsigned int> pending { 0 };
+
+    mutable std::mutex      mutex;
+    std::condition_variable work_cv;                // Signaled when work is queued or the walk ends.
+    mutable std::condition_variable done_cv;
+    bool                    started = false;
+    bool                    done = false;
+
+                            state(unsigned int count) : queues(count) {}
+    void                    proc(unsigned int index);
+    walk_node*              take(unsigned int index);
+    bool                    has_work();
+    void                    push(unsigned int index, walk_node* node);
+    void                    visit(unsigned int index, walk_node* node);
+    void                    finish_one();
+    bool                    is_ignored(unsigned int index, const char* name) const;
+    void                    collect(const walk_node& node, std::vector<dir_walk_entry>& out) const;
+};
+
+//------------------------------------------------------------------------------
+void dir_walker::state::proc(unsigned int index)
+{
+    while (true)
+    {
+        walk_node* node = take(index);
+        if (node)
+        {
+            if (!canceled)
+                visit(index, node);
+            finish_one();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        work_cv.wait(lock, [this] () { return done || has_work(); });
+        if (done)
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Takes the most recently queued node from this thread's own queue, which
+// keeps its work local, or else steals the oldest node from another thread's
+// queue, which tends to be a large subtree.
+walk_node* dir_walker::state::take(unsigned int index)
+{
+    {
+        walk_queue& own = queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.nodes.empty())
+        {
+            walk_node* node = own.nodes.back();
+            own.nodes.pop_back();
+            return node;
+        }
+    }
+
+    for (unsigned int i = 1; i < num_threads; ++i)
+    {
+        walk_queue& other = queues[(index + i) % num_threads];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.nodes.empty())
+        {
+            walk_node* node = other.nodes.front();
+            other.nodes.pop_front();
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Called with the state's mutex held; that's what keeps push() from notifying
+// between an idle thread checking for work and starting to wait.
+bool dir_walker::state::has_work()
+{
+    for (auto& queue : queues)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.nodes.empty())
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::state::push(unsigned int index, walk_node* node)
+{
+    pending++;
+    {
+        walk_queue& own = queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.nodes.push_back(node);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    work_cv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::state::visit(unsigned int index, walk_node* node)
+{
+    str<280> dir;
+    dir.concat(root.c_str(), root.length());
+    dir.concat(node->rel.c_str(), node->rel.length());
+
+    std::vector<raw_entry> raw;
+    enum_dir(dir.c_str(), raw, canceled);
+    std::sort(raw.begin(), raw.end(), [] (const raw_entry& a, const raw_entry& b) {
+        return name_less(a.name.c_str(), b.name.c_str());
+    });
+
+    node->items.reserve(raw.size());
+    for (auto& entry : raw)
+    {
+        if ((entry.hidden && !hidden) || (entry.system && !system))
+            continue;
+        if (entry.dir && is_ignored(index, entry.name.c_str()))
+            continue;
+
+        const path::compiled_wild_pattern* pattern = patterns[index].pattern.get();
+        walk_node::item item;
+        item.dir = entry.dir;
+        item.report = ((entry.dir ? directories : files) &&
+                       (!pattern || pattern->match(entry.name.c_str(), entry.name.length())));
+
+        if (item.report && ++found > max_entries)
+        {
+            // Let the workers drain the queues without visiting anything else.
+            truncated = true;
+            canceled = true;
+            break;
+        }
+
+        if (entry.dir && !entry.link && node->depth < max_depth)
+        {
+            item.child = std::make_unique<walk_node>();
+            item.child->rel.concat(node->rel.c_str(), node->rel.length());
+            item.child->rel.concat(entry.name.c_str(), entry.name.length());
+            item.child->rel.concat(&c_sep, 1);
+            item.child->depth = node->depth + 1;
+        }
+        else if (!item.report)
+        {
+            continue;
+        }
+
+        item.name = std::move(entry.name);
+        node->items.emplace_back(std::move(item));
+    }
+
+    // Queue the subdirectories in reverse, so this thread visits them in
+    // order and other threads steal from the end.
+    for (auto iter = node->items.rbegin(); iter != node->items.rend(); ++iter)
+        if (iter->child)
+            push(index, iter->child.get());
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::state::finish_one()
+{
+    if (--pending)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    work_cv.notify_all();
+    done_cv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::state::is_ignored(unsigned int index, const char* name) const
+{
+    for (const auto& pat : patterns[index].ignore)
+        if (pat->match(name))
+            return true;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::state::collect(const walk_node& node, std::vector<dir_walk_entry>& out) const
+{
+    for (const auto& item : node.items)
+    {
+        if (out.size() >= max_entries)
+            return;
+
+        if (item.report)
+        {
+            dir_walk_entry entry;
+            entry.path.concat(node.rel.c_str(), node.rel.length());
+            entry.path.concat(item.name.c_str(), item.name.length());
+            if (item.dir)
+                entry.path.concat(&c_sep, 1);
+            entry.depth = node.depth;
+            entry.dir = item.dir;
+            out.emplace_back(std::move(entry));
+        }
+
+        if (item.child)
+            collect(*item.child, out);
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+dir_walker::dir_walker(const char* root, const dir_walk_options& options)
+{
+    unsigned int num_threads = options.threads;
+    if (!num_threads)
+        num_threads = min<unsigned int>(max<unsigned int>(std::thread::hardware_concurrency(), 2), c_max_threads);
+
+    m_state = std::make_unique<state>(num_threads);
+    state& s = *m_state;
+
+    s.root = (root && *root) ? root : ".";
+    if (s.root.c_str()[s.root.length() - 1] != c_sep && s.root.c_str()[s.root.length() - 1] != '/')
+        s.root.concat(&c_sep, 1);
+    s.max_depth = options.max_depth;
+    s.max_entries = options.max_entries;
+    s.num_threads = num_threads;
+    s.files = options.files;
+    s.directories = options.directories;
+    s.hidden = options.hidden;
+    s.system = options.system;
+    s.tree.depth = 0;
+
+    // Names match the way the file system does, regardless of the caller's
+    // str_compare_scope.
+    str_compare_scope _(str_compare_scope::caseless, false/*fuzzy_accent*/);
+    s.patterns.resize(num_threads);
+    for (auto& patterns : s.patterns)
+    {
+        if (!options.pattern.empty())
+            patterns.pattern = std::make_unique<path::compiled_wild_pattern>(options.pattern.c_str(), options.pattern.length());
+        for (const auto& pat : options.ignore)
+            patterns.ignore.emplace_back(std::make_unique<path::compiled_wild_pattern>(pat.c_str(), pat.length()));
+    }
+}
+
+//------------------------------------------------------------------------------
+dir_walker::~dir_walker()
+{
+    cancel();
+    join();
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::start()
+{
+    state& s = *m_state;
+    if (s.started)
+        return false;
+
+    s.started = true;
+    s.push(0, &s.tree);
+    for (unsigned int i = 0; i < s.num_threads; ++i)
+        s.threads.emplace_back(&state::proc, &s, i);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::cancel()
+{
+    m_state->canceled = true;
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::wait(unsigned int timeout_ms) const
+{
+    state& s = *m_state;
+    std::unique_lock<std::mutex> lock(s.mutex);
+    if (!s.started)
+        return false;
+    if (timeout_ms == ~0u)
+        s.done_cv.wait(lock, [&s] { return s.done; });
+    else
+        s.done_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&s] { return s.done; });
+    return s.done;
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::is_truncated() const
+{
+    return m_state->truncated;
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::is_canceled() const
+{
+    return m_state->canceled && !m_state->truncated;
+}
+
+//------------------------------------------------------------------------------
+// Only valid once the walk is done.
+void dir_walker::get_entries(std::vector<dir_walk_entry>& out) const
+{
+    out.clear();
+    if (is_done() && !is_canceled())
+        m_state->collect(m_state->tree, out);
+}
+
+//------------------------------------------------------------------------------
+bool dir_walker::walk(const char* root, const dir_walk_options& options, std::vector<dir_walk_entry>& out)
+{
+    dir_walker walker(root, options);
+    if (!walker.start())
+        return false;
+
+    walker.wait();
+    walker.join();
+    walker.get_entries(out);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void dir_walker::join()
+{
+    for (auto& thread : m_state->threads)
+        thread.join();
+    m_state->threads.clear();
+}
@@ -0,0 +1,249 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "dir_worker.h"
+#include "debugheap.h"
+#include "os.h"
+#include "path.h"
+
+#include <deque>
+#include <thread>
+
+//------------------------------------------------------------------------------
+static const unsigned int c_shutdown_wait_ms = 500;
+
+
+
+//------------------------------------------------------------------------------
+dir_request::dir_request(const char* dir, unsigned int timeout_ms)
+: m_dir(dir)
+, m_token(timeout_ms)
+{
+    m_done_event = CreateEvent(nullptr, true, false, nullptr);
+}
+
+//------------------------------------------------------------------------------
+dir_request::~dir_request()
+{
+    if (m_done_event)
+        CloseHandle(m_done_event);
+}
+
+//------------------------------------------------------------------------------
+bool dir_request::is_done() const
+{
+    return wait(0);
+}
+
+//------------------------------------------------------------------------------
+bool dir_request::wait(unsigned int timeout_ms) const
+{
+    return m_done_event && WaitForSingleObject(m_done_event, timeout_ms) == WAIT_OBJECT_0;
+}
+
+//------------------------------------------------------------------------------
+dir_cache::snapshot_ptr dir_request::get_snapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_snapshot;
+}
+
+//------------------------------------------------------------------------------
+void dir_request::complete(dir_cache::snapshot_ptr snapshot)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_snapshot = snapshot;
+    }
+
+    if (m_done_event)
+        SetEvent(m_done_event);
+}
+
+
+
+//------------------------------------------------------------------------------
+// The worker's state is shared with its thread, so that if shutdown gives up
+// waiting for a thread stuck in a network call, the thread can still finish
+// safely after the worker itself is gone.
+class worker_thread
+{
+    struct state
+    {
+                            ~state();
+        std::mutex          m_mutex;
+        std::deque<dir_worker::request_ptr> m_queue;
+        dir_worker::request_ptr m_current;
+        HANDLE              m_event = nullptr;
+        bool                m_zombie = false;
+    };
+
+public:
+                            worker_thread() : m_state(std::make_shared<state>()) {}
+                            ~worker_thread() { shutdown(); }
+    dir_worker::request_ptr enqueue(const char* dir, unsigned int timeout_ms);
+    void                    shutdown();
+
+private:
+    static void             proc(std::shared_ptr<state> s);
+    std::shared_ptr<state>  m_state;
+    std::unique_ptr<std::thread> m_thread;
+};
+
+//------------------------------------------------------------------------------
+static worker_thread s_worker;
+
+//------------------------------------------------------------------------------
+worker_thread::state::~state()
+{
+    if (m_event)
+        CloseHandle(m_event);
+}
+
+//------------------------------------------------------------------------------
+dir_worker::request_ptr worker_thread::enqueue(const char* dir, unsigned int timeout_ms)
+{
+    // The thread must not depend on the current directory, which can change
+    // before it gets around to the request.
+    str<280> full;
+    if (!dir || !*dir)
+        os::get_current_dir(full);
+    else if (!os::get_full_path_name(dir, full))
+        return nullptr;
+    path::maybe_strip_last_separator(full);
+    dir = full.c_str();
+
+    state& s = *m_state;
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+
+    if (s.m_zombie)
+        return nullptr;
+
+    if (!s.m_event)
+    {
+        s.m_event = CreateEvent(nullptr, false, false, nullptr);
+        if (!s.m_event)
+            return nullptr;
+    }
+
+    // Share a request for the same directory that's still in progress.
+    if (s.m_current && !s.m_current->m_token.is_canceled() && s.m_current->m_dir.iequals(dir))
+        return s.m_current;
+    for (const auto& queued : s.m_queue)
+        if (!queued->m_token.is_canceled() && queued->m_dir.iequals(dir))
+            return queued;
+
+    dbg_ignore_scope(snapshot, "Directory worker");
+
+    if (!m_thread)
+        m_thread = std::make_unique<std::thread>(&proc, m_state);
+
+    auto request = std::make_shared<dir_request>(dir, timeout_ms);
+    s.m_queue.emplace_back(request);
+
+    SetEvent(s.m_event);    // Signal thread there is work to do.
+    Sleep(0);               // Give up timeslice in case thread gets result quickly.
+    return request;
+}
+
+//------------------------------------------------------------------------------
+void worker_thread::shutdown()
+{
+    std::unique_ptr<std::thread> thread;
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_mutex);
+
+        m_state->m_zombie = true;
+        if (m_state->m_current)
+            m_state->m_current->cancel();
+        for (const auto& queued : m_state->m_queue)
+            queued->complete(nullptr);
+        m_state->m_queue.clear();
+
+        if (m_state->m_event)
+            SetEvent(m_state->m_event);
+
+        thread = std::move(m_thread);
+    }
+
+    if (!thread)
+        return;
+
+    // Enumeration is canceled between entries, but a single call into a
+    // network file system can stall for a long time.  Don't hold up exit for
+    // that; the thread owns a reference to the state it uses.
+    if (WaitForSingleObject(thread->native_handle(), c_shutdown_wait_ms) == WAIT_OBJECT_0)
+        thread->join();
+    else
+        thread->detach();
+}
+
+//------------------------------------------------------------------------------
+void worker_thread::proc(std::shared_ptr<state> s)
+{
+    while (true)
+    {
+        if (WaitForSingleObject(s->m_event, INFINITE) != WAIT_OBJECT_0)
+        {
+            // Uh oh.
+            Sleep(5000);
+        }
+
+        while (true)
+        {
+            dir_worker::request_ptr request;
+
+            {
+                std::lock_guard<std::mutex> lock(s->m_mutex);
+                s->m_current.reset();
+                if (s->m_zombie)
+                    return;
+                if (s->m_queue.empty())
+                    break;
+                request = s->m_queue.front();
+                s->m_queue.pop_front();
+                s->m_current = request;
+            }
+
+            // Requests that were canceled or expired while queued are skipped
+            // without touching the file system.
+            dir_cache::snapshot_ptr snapshot;
+            if (!request->m_token.is_canceled())
+                snapshot = dir_cache::load(request->get_dir(), request->m_token);
+
+            request->complete(snapshot);
+        }
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+dir_worker::request_ptr dir_worker::enqueue(const char* dir, unsigned int timeout_ms)
+{
+    return s_worker.enqueue(dir, timeout_ms);
+}
+
+//------------------------------------------------------------------------------
+// Returns the snapshot for dir if it's cached or can be loaded within wait_ms.
+// Otherwise returns nullptr, but the load continues in the background until
+// timeout_ms, so that a later call can find it in the cache.
+dir_cache::snapshot_ptr dir_worker::load(const char* dir, unsigned int wait_ms, unsigned int timeout_ms)
+{
+    if (dir_cache::snapshot_ptr snapshot = dir_cache::find(dir))
+        return snapshot;
+
+    request_ptr request = enqueue(dir, timeout_ms);
+    if (!request || !request->wait(wait_ms))
+        return nullptr;
+
+    return request->get_snapshot();
+}
+
+//------------------------------------------------------------------------------
+void dir_worker::shutdown()
+{
+    s_worker.shutdown();
+}
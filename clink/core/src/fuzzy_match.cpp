@@ -0,0 +1,217 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fuzzy_match.h"
+#include "match_wild.h"
+#include "str_compare.h"
+#include "str_iter.h"
+
+//------------------------------------------------------------------------------
+enum char_class : unsigned char
+{
+    class_white,
+    class_non_word,
+    class_separator,
+    // Word classes must follow class_separator.
+    class_lower,
+    class_upper,
+    class_letter,
+    class_number,
+};
+
+//------------------------------------------------------------------------------
+static char_class classify(wchar_t c)
+{
+    if (c < 128)
+    {
+        if (c >= 'a' && c <= 'z') return class_lower;
+        if (c >= 'A' && c <= 'Z') return class_upper;
+        if (c >= '0' && c <= '9') return class_number;
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+            return class_white;
+        case '/':
+        case '\\':
+        case ':':
+        case ';':
+        case ',':
+        case '|':
+            return class_separator;
+        }
+        return class_non_word;
+    }
+
+    if (IsCharUpperW(c)) return class_upper;
+    if (IsCharLowerW(c)) return class_lower;
+    if (IsCharAlphaNumericW(c)) return class_letter;
+    if (iswspace(c)) return class_white;
+    return class_non_word;
+}
+
+//------------------------------------------------------------------------------
+static int bonus_for(char_class prev, char_class cur)
+{
+    if (cur > class_separator)
+    {
+        switch (prev)
+        {
+        case class_white:       return fuzzy_matcher::bonus_boundary_white;
+        case class_separator:   return fuzzy_matcher::bonus_boundary_separator;
+        case class_non_word:    return fuzzy_matcher::bonus_boundary;
+        }
+    }
+
+    if ((prev == class_lower && cur == class_upper) ||
+        (prev != class_number && cur == class_number))
+        return fuzzy_matcher::bonus_camel123;
+
+    switch (cur)
+    {
+    case class_non_word:
+    case class_separator:
+        return fuzzy_matcher::bonus_non_word;
+    case class_white:
+        return fuzzy_matcher::bonus_boundary_white;
+    }
+
+    return 0;
+}
+
+
+
+//------------------------------------------------------------------------------
+fuzzy_matcher::fuzzy_matcher(const char* needle, int len)
+: m_mode(str_compare_scope::current())
+, m_fuzzy_accents(str_compare_scope::current_fuzzy_accents())
+{
+    str_iter iter(needle, len);
+    to_utf16(m_needle, iter);
+    path::compiled_wild_pattern::fold(m_needle, m_mode, m_fuzzy_accents);
+}
+
+//------------------------------------------------------------------------------
+bool fuzzy_matcher::match(const char* text, int len) const
+{
+    if (empty())
+        return true;
+
+    str_iter iter(text, len);
+    m_folded.clear();
+    to_utf16(m_folded, iter);
+    path::compiled_wild_pattern::fold(m_folded, m_mode, m_fuzzy_accents);
+
+    unsigned int begin, end;
+    return find(begin, end);
+}
+
+//------------------------------------------------------------------------------
+bool fuzzy_matcher::score(const char* text, int len, int& out) const
+{
+    out = 0;
+    if (empty())
+        return true;
+
+    str_iter iter(text, len);
+    m_text.clear();
+    to_utf16(m_text, iter);
+    m_folded = m_text.c_str();
+    path::compiled_wild_pattern::fold(m_folded, m_mode, m_fuzzy_accents);
+
+    unsigned int begin, end;
+    if (!find(begin, end))
+        return false;
+
+    out = calc_score(begin, end);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Finds the shortest window of m_folded that ends at the earliest possible
+// position and contains the needle as a subsequence.
+bool fuzzy_matcher::find(unsigned int& begin, unsigned int& end) const
+{
+    const wchar_t* const text = m_folded.c_str();
+    const wchar_t* const text_end = text + m_folded.length();
+    const wchar_t* const needle = m_needle.c_str();
+    const unsigned int needle_len = m_needle.length();
+
+    // Forward scan.  Most candidates are rejected here, so it jumps straight
+    // to each needle character with wmemchr rather than testing every text
+    // character.
+    const wchar_t* walk = text;
+    for (unsigned int n = 0; n < needle_len; ++n)
+    {
+        const wchar_t* hit = wmemchr(walk, needle[n], text_end - walk);
+        if (!hit)
+            return false;
+        walk = hit + 1;
+    }
+
+    // Backward scan from the end of the forward match to tighten the start.
+    end = unsigned(walk - text);
+    unsigned int n = needle_len;
+    unsigned int i = end;
+    while (n)
+    {
+        --i;
+        if (text[i] == needle[n - 1])
+            --n;
+    }
+    begin = i;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int fuzzy_matcher::calc_score(unsigned int begin, unsigned int end) const
+{
+    const wchar_t* const text = m_text.c_str();
+    const wchar_t* const folded = m_folded.c_str();
+    const wchar_t* const needle = m_needle.c_str();
+
+    int score = 0;
+    int first_bonus = 0;
+    unsigned int consecutive = 0;
+    unsigned int n = 0;
+    bool in_gap = false;
+    char_class prev = begin ? classify(text[begin - 1]) : class_white;
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const char_class cur = classify(text[i]);
+        if (folded[i] == needle[n])
+        {
+            int bonus = bonus_for(prev, cur);
+            if (!consecutive)
+            {
+                first_bonus = bonus;
+            }
+            else
+            {
+                // A run of consecutive matches keeps the bonus of the boundary
+                // where it started.
+                if (bonus >= bonus_boundary && bonus > first_bonus)
+                    first_bonus = bonus;
+                bonus = max(max(bonus, first_bonus), int(bonus_consecutive));
+            }
+
+            score += score_match;
+            score += n ? bonus : bonus * bonus_first_char_multiplier;
+            in_gap = false;
+            ++consecutive;
+            ++n;
+        }
+        else
+        {
+            score += in_gap ? score_gap_extension : score_gap_start;
+            in_gap = true;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        prev = cur;
+    }
+
+    return score;
+}
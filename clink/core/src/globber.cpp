@@ -3,12 +3,30 @@
 
 #include "pch.h"
 #include "globber.h"
+#include "dir_worker.h"
 #include "os.h"
 #include "path.h"
 #include "str.h"
 
 #include <sys/stat.h>
 
+//------------------------------------------------------------------------------
+static const unsigned int c_slow_timeout_ms = 10000;
+static threadlocal bool s_nonblocking = false;
+
+//------------------------------------------------------------------------------
+globber::nonblocking_scope::nonblocking_scope()
+: m_prev(s_nonblocking)
+{
+    s_nonblocking = true;
+}
+
+//------------------------------------------------------------------------------
+globber::nonblocking_scope::~nonblocking_scope()
+{
+    s_nonblocking = m_prev;
+}
+
 //------------------------------------------------------------------------------
 globber::globber(const char* pattern)
 : m_files(true)
@@ -62,13 +80,17 @@ globber::globber(const char* pattern)
         }
     }
 
+    path::get_directory(pattern, m_root);
+    path::normalise_separators(m_root.data());
+
+    m_handle = nullptr;
+    if (use_cache(pattern))
+        return;
+
     wstr<280> wglob(pattern);
     m_handle = FindFirstFileW(wglob.c_str(), &m_data);
     if (m_handle == INVALID_HANDLE_VALUE)
         m_handle = nullptr;
-
-    path::get_directory(pattern, m_root);
-    path::normalise_separators(m_root.data());
 }
 
 //------------------------------------------------------------------------------
@@ -104,49 +126,29 @@ bool globber::older_than(int seconds)
 //------------------------------------------------------------------------------
 bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 {
-    if (m_handle == nullptr)
-        return false;
-
     str<280> file_name;
-    int attr;
-    ULARGE_INTEGER size;
-    FILETIME accessed;
-    FILETIME modified;
-    FILETIME created;
-    bool symlink;
+    dir_snapshot::entry entry;
 
     while (true)
     {
-        if (m_handle == nullptr)
+        if (!get_entry(entry))
             return false;
 
-        file_name = m_data.cFileName;
-        attr = m_data.dwFileAttributes;
-        symlink = ((attr & FILE_ATTRIBUTE_REPARSE_POINT) &&
-                   !(attr & FILE_ATTRIBUTE_OFFLINE) &&
-                   (m_data.dwReserved0 == IO_REPARSE_TAG_SYMLINK));
-
-        if (extrainfo)
-        {
-            size.LowPart = m_data.nFileSizeLow;
-            size.HighPart = m_data.nFileSizeHigh;
-            accessed = m_data.ftLastAccessTime;
-            modified = m_data.ftLastWriteTime;
-            created = m_data.ftCreationTime;
-        }
+        file_name = entry.name;
 
         bool again = false;
 
-        const wchar_t* c = m_data.cFileName;
+        const wchar_t* c = entry.name;
         again |= (c[0] == '.' && (!c[1] || (c[1] == '.' && !c[2])) && !m_dots);
 
+        const int attr = entry.attr;
         again |= (attr & FILE_ATTRIBUTE_SYSTEM) && !m_system;
         again |= (attr & FILE_ATTRIBUTE_HIDDEN) && !m_hidden;
         again |= (attr & FILE_ATTRIBUTE_DIRECTORY) && !m_directories;
         again |= !(attr & FILE_ATTRIBUTE_DIRECTORY) && !m_files;
 
         if (m_onlyolder)
-            again |= !(CompareFileTime(&m_data.ftLastWriteTime, &m_olderthan) < 0);
+            again |= !(CompareFileTime(&entry.modified, &m_olderthan) < 0);
 
         next_file();
 
@@ -154,6 +156,11 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
             break;
     }
 
+    const int attr = entry.attr;
+    const bool symlink = ((attr & FILE_ATTRIBUTE_REPARSE_POINT) &&
+                          !(attr & FILE_ATTRIBUTE_OFFLINE) &&
+                          (entry.reparse_tag == IO_REPARSE_TAG_SYMLINK));
+
     out.clear();
     if (rooted)
         out << m_root;
@@ -175,11 +182,11 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 
         extrainfo->attr = attr;
 
-        extrainfo->size = size.QuadPart;
+        extrainfo->size = entry.size;
 
-        extrainfo->accessed = accessed;
-        extrainfo->modified = modified;
-        extrainfo->created = created;
+        extrainfo->accessed = entry.accessed;
+        extrainfo->modified = entry.modified;
+        extrainfo->created = entry.created;
     }
 
     return true;
@@ -193,11 +200,129 @@ void globber::close()
         FindClose(m_handle);
         m_handle = nullptr;
     }
+
+    m_snapshot.reset();
+}
+
+//------------------------------------------------------------------------------
+// Globbing "dir\prefix*" is served from a snapshot of the whole directory.
+// Other patterns (and "~" prefixes, which may be meant to match 8.3 short
+// names) go straight to FindFirstFileW.
+//
+// FindFirstFileW lets a "." right before the trailing "*" also match the end
+// of the name, so that "foo.*" matches "foo" as well as "foo.txt".  A single
+// trailing "." is emulated; anything fancier bypasses the cache.
+//
+// Inside a nonblocking_scope, slow directories are never enumerated or
+// validated inline.  Whatever dir_cache has is used, even if it's due to be
+// revalidated, and dir_worker refreshes it in the background; if nothing is
+// cached yet there are no results until the background load finishes.
+// Everywhere else they're enumerated synchronously, like any other directory.
+bool globber::use_cache(const char* pattern)
+{
+    const char* name = path::get_name(pattern);
+    const unsigned int len = name ? unsigned(strlen(name)) : 0;
+    if (!len || name[len - 1] != '*')
+    {
+        dir_cache::note_bypass();
+        return false;
+    }
+
+    str<280> prefix;
+    prefix.concat(name, len - 1);
+    if (strpbrk(prefix.c_str(), "*?<>\"~"))
+    {
+        dir_cache::note_bypass();
+        return false;
+    }
+
+    const unsigned int prefix_len = prefix.length();
+    m_dos_dot = (prefix_len && prefix.c_str()[prefix_len - 1] == '.');
+    if (m_dos_dot && (prefix_len < 2 || prefix.c_str()[prefix_len - 2] == '.'))
+    {
+        dir_cache::note_bypass();
+        return false;
+    }
+
+    if (s_nonblocking && dir_cache::is_slow(m_root.c_str()))
+    {
+        bool stale;
+        m_snapshot = dir_cache::find(m_root.c_str(), &stale);
+        if (!m_snapshot || stale)
+            dir_worker::enqueue(m_root.c_str(), c_slow_timeout_ms);
+        if (!m_snapshot)
+            return true;
+    }
+    else
+    {
+        m_snapshot = dir_cache::lookup(m_root.c_str());
+        if (!m_snapshot)
+            return false;
+    }
+
+    m_prefix = prefix.c_str();
+    m_snapshot_index = 0;
+    seek_snapshot();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool globber::get_entry(dir_snapshot::entry& out) const
+{
+    if (m_snapshot)
+    {
+        if (m_snapshot_index >= m_snapshot->count())
+            return false;
+        out = m_snapshot->get(m_snapshot_index);
+        return true;
+    }
+
+    if (m_handle == nullptr)
+        return false;
+
+    out.name = m_data.cFileName;
+    out.len = unsigned(wcslen(m_data.cFileName));
+    out.attr = m_data.dwFileAttributes;
+    out.reparse_tag = m_data.dwReserved0;
+    out.size = (unsigned long long)(m_data.nFileSizeHigh) << 32 | m_data.nFileSizeLow;
+    out.accessed = m_data.ftLastAccessTime;
+    out.modified = m_data.ftLastWriteTime;
+    out.created = m_data.ftCreationTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void globber::seek_snapshot()
+{
+    const unsigned int count = m_snapshot->count();
+    const int prefix_len = m_prefix.length();
+    if (!prefix_len)
+        return;
+
+    for (; m_snapshot_index < count; ++m_snapshot_index)
+    {
+        const dir_snapshot::entry& entry = m_snapshot->get(m_snapshot_index);
+        if (entry.len >= unsigned(prefix_len) &&
+            CompareStringOrdinal(entry.name, prefix_len, m_prefix.c_str(), prefix_len, true) == CSTR_EQUAL)
+            break;
+
+        // "foo.*" also matches "foo".
+        if (m_dos_dot && entry.len == unsigned(prefix_len - 1) &&
+            CompareStringOrdinal(entry.name, prefix_len - 1, m_prefix.c_str(), prefix_len - 1, true) == CSTR_EQUAL)
+            break;
+    }
 }
 
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
-    if (m_handle && !FindNextFileW(m_handle, &m_data))
+    if (m_snapshot)
+    {
+        m_snapshot_index++;
+        seek_snapshot();
+    }
+    else if (m_handle && !FindNextFileW(m_handle, &m_data))
+    {
         close();
+    }
 }
@@ -0,0 +1,102 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "keyword_set.h"
+
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+static inline unsigned char fold_ascii(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+}
+
+//------------------------------------------------------------------------------
+keyword_set::keyword_set(const char* const* keywords, unsigned int count)
+: m_keywords(keywords)
+, m_count(count)
+{
+    assert(count < 0x7fff);
+
+    m_min_len = count ? ~0u : 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const unsigned int len = unsigned(strlen(keywords[i]));
+        m_min_len = min(m_min_len, len);
+        m_max_len = max(m_max_len, len);
+    }
+
+    // Try seeds until one puts every keyword in its own slot.  With the table
+    // at least four times the number of keywords, a handful of tries usually
+    // suffices; if not, double the table and keep going.
+    unsigned int slots = 8;
+    while (slots < count * 4)
+        slots <<= 1;
+    for (unsigned int seed = 0;; ++seed)
+    {
+        if (build(slots, seed))
+            break;
+        if ((seed & 0xff) == 0xff)
+            slots <<= 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns the index of the matching keyword, or -1 if there is no match.
+int keyword_set::find(const char* word, int len) const
+{
+    if (!word)
+        return -1;
+    if (len < 0)
+        len = int(strlen(word));
+    if (unsigned(len) < m_min_len || unsigned(len) > m_max_len)
+        return -1;
+
+    const int index = m_slots[hash(word, len, m_seed) & m_mask];
+    if (index < 0)
+        return -1;
+
+    const char* keyword = m_keywords[index];
+    for (int i = 0; i < len; ++i)
+        if (fold_ascii(keyword[i]) != fold_ascii(word[i]))
+            return -1;
+    return keyword[len] ? -1 : index;
+}
+
+//------------------------------------------------------------------------------
+// FNV-1a over the case folded bytes.
+unsigned int keyword_set::hash(const char* word, unsigned int len, unsigned int seed)
+{
+    unsigned int h = 0x811c9dc5 ^ (seed * 0x9e3779b9);
+    for (unsigned int i = 0; i < len; ++i)
+    {
+        h ^= fold_ascii(word[i]);
+        h *= 0x01000193;
+    }
+    return h ^ (h >> 15);
+}
+
+//------------------------------------------------------------------------------
+bool keyword_set::build(unsigned int slots, unsigned int seed)
+{
+    m_slots.assign(slots, -1);
+    m_mask = slots - 1;
+    m_seed = seed;
+
+    for (unsigned int i = 0; i < m_count; ++i)
+    {
+        const char* keyword = m_keywords[i];
+        short& slot = m_slots[hash(keyword, unsigned(strlen(keyword)), seed) & m_mask];
+        if (slot >= 0)
+        {
+            // A duplicate keyword can never get its own slot; keep the first.
+            if (find(keyword) >= 0)
+                continue;
+            return false;
+        }
+        slot = short(i);
+    }
+
+    return true;
+}
@@ -4,14 +4,183 @@
 
 #include "pch.h"
 #include "linear_allocator.h"
+#include "base.h"
 
 #include <stdlib.h>
 #include <assert.h>
 
+//------------------------------------------------------------------------------
+static const unsigned int c_pages_per_doubling = 4;
+static const unsigned int c_max_doublings = 4;
+static const unsigned int c_max_grown_page_size = 1024 * 1024;
+
+
+
+//------------------------------------------------------------------------------
+// Keeps freed pages for reuse, bucketed by page size.  Each thread has its own
+// pool, so no locking is needed; a page may be freed by a different thread
+// than allocated it, which is fine since the pages come from malloc.
+class page_pool
+{
+    struct bucket
+    {
+        unsigned int        size;
+        unsigned int        count;
+        char*               head;
+    };
+
+    static const unsigned int c_buckets = 8;
+    static const size_t c_max_pooled_bytes = 4 * 1024 * 1024;
+
+public:
+    char*                   take(unsigned int size);
+    void                    give(char* page, unsigned int size);
+    void                    trim();
+    linear_allocator_stats  m_stats;
+
+private:
+    bucket                  m_buckets[c_buckets];
+};
+
+//------------------------------------------------------------------------------
+char* page_pool::take(unsigned int size)
+{
+    for (bucket& b : m_buckets)
+    {
+        if (b.size == size && b.head)
+        {
+            char* page = b.head;
+            b.head = *reinterpret_cast<char**>(page);
+            b.count--;
+            m_stats.reuses++;
+            m_stats.pooled_pages--;
+            m_stats.pooled_bytes -= size;
+            return page;
+        }
+    }
+
+    char* page = (char*)malloc(size);
+    if (page)
+        m_stats.allocs++;
+    return page;
+}
+
+//------------------------------------------------------------------------------
+void page_pool::give(char* page, unsigned int size)
+{
+    if (m_stats.pooled_bytes + size <= c_max_pooled_bytes)
+    {
+        bucket* target = nullptr;
+        for (bucket& b : m_buckets)
+        {
+            if (b.size == size)
+            {
+                target = &b;
+                break;
+            }
+            if (!b.count && !target)
+                target = &b;
+        }
+
+        if (target)
+        {
+            target->size = size;
+            *reinterpret_cast<char**>(page) = target->head;
+            target->head = page;
+            target->count++;
+            m_stats.pooled_pages++;
+            m_stats.pooled_bytes += size;
+            return;
+        }
+    }
+
+    free(page);
+    m_stats.frees++;
+}
+
+//------------------------------------------------------------------------------
+void page_pool::trim()
+{
+    for (bucket& b : m_buckets)
+    {
+        while (b.head)
+        {
+            char* page = b.head;
+            b.head = *reinterpret_cast<char**>(page);
+            free(page);
+            m_stats.frees++;
+        }
+        b.count = 0;
+    }
+
+    m_stats.pooled_pages = 0;
+    m_stats.pooled_bytes = 0;
+}
+
+
+
+//------------------------------------------------------------------------------
+// The pool pointer is plain data so it's safe to use from any thread at any
+// time, including while static objects are destroyed after the thread's pool
+// has been reaped; pages are simply freed once there's no pool.
+static threadlocal page_pool* ts_pool = nullptr;
+static threadlocal bool ts_pool_reaped = false;
+
+//------------------------------------------------------------------------------
+struct page_pool_reaper
+{
+    ~page_pool_reaper()
+    {
+        if (ts_pool)
+        {
+            ts_pool->trim();
+            free(ts_pool);
+            ts_pool = nullptr;
+        }
+        ts_pool_reaped = true;
+    }
+};
+// Not threadlocal:  __declspec(thread) can't have a destructor, and the reaper
+// only works if its destructor runs at thread exit.
+static thread_local page_pool_reaper ts_reaper;
+
+//------------------------------------------------------------------------------
+static page_pool* get_pool()
+{
+    if (!ts_pool && !ts_pool_reaped)
+    {
+        // Using the reaper makes sure it's constructed, so that it's destroyed
+        // when the thread exits.
+        (void)&ts_reaper;
+        ts_pool = static_cast<page_pool*>(calloc(1, sizeof(page_pool)));
+    }
+    return ts_pool;
+}
+
+//------------------------------------------------------------------------------
+static char* take_page(unsigned int size)
+{
+    if (page_pool* pool = get_pool())
+        return pool->take(size);
+    return (char*)malloc(size);
+}
+
+//------------------------------------------------------------------------------
+static void give_page(char* page, unsigned int size)
+{
+    if (page_pool* pool = get_pool())
+        pool->give(page, size);
+    else
+        free(page);
+}
+
+
+
 //------------------------------------------------------------------------------
 linear_allocator::linear_allocator(unsigned int size)
 : m_used(size)
 , m_max(size)
+, m_page_size(size)
 {
     assert(size > sizeof(m_ptr)); // Warn since allocations will never succeed.
 }
@@ -28,11 +197,17 @@ linear_allocator& linear_allocator::operator = (linear_allocator&& o)
     free_chain();
 
     m_ptr = o.m_ptr;
+    m_oversized = o.m_oversized;
     m_used = o.m_used;
     m_max = o.m_max;
+    m_page_size = o.m_page_size;
+    m_pages = o.m_pages;
 
     o.m_ptr = nullptr;
+    o.m_oversized = nullptr;
+    o.m_max = o.m_page_size;
     o.m_used = o.m_max;
+    o.m_pages = 0;
 
     return *this;
 }
@@ -47,13 +222,15 @@ void* linear_allocator::alloc(unsigned int size)
     {
         if (!m_ptr && !new_page())
             return nullptr;
-        // An over-sized allocation gets its own "page", which gets inserted
-        // into the chain without discarding the current page.
+        // An over-sized allocation gets its own block on the side list,
+        // without discarding the current page.
         char* oversized = (char*)malloc(size + sizeof(m_ptr));
         if (oversized == nullptr)
             return nullptr;
-        *reinterpret_cast<char**>(oversized) = *reinterpret_cast<char**>(m_ptr);
-        *reinterpret_cast<char**>(m_ptr) = oversized;
+        *reinterpret_cast<char**>(oversized) = m_oversized;
+        m_oversized = oversized;
+        if (page_pool* pool = get_pool())
+            pool->m_stats.oversized++;
         return oversized + sizeof(m_ptr);
     }
 
@@ -77,42 +254,97 @@ const char* linear_allocator::store(const char* str)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+void linear_allocator::get_pool_stats(linear_allocator_stats& out)
+{
+    if (page_pool* pool = get_pool())
+        out = pool->m_stats;
+    else
+        memset(&out, 0, sizeof(out));
+}
+
+//------------------------------------------------------------------------------
+void linear_allocator::trim_pool()
+{
+    if (page_pool* pool = get_pool())
+        pool->trim();
+}
+
 //------------------------------------------------------------------------------
 bool linear_allocator::new_page()
 {
-    if (m_max < sizeof(m_ptr))
+    if (m_page_size < sizeof(m_ptr))
         return false;
 
-    char* temp = (char*)malloc(m_max);
+    const unsigned int size = page_size(m_pages);
+    char* temp = take_page(size);
     if (temp == nullptr)
         return false;
 
     *reinterpret_cast<char**>(temp) = m_ptr;
     m_used = sizeof(m_ptr);
+    m_max = size;
     m_ptr = temp;
+    m_pages++;
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Page sizes only depend on the position in the chain, so free_chain() can
+// tell each page's size without storing it in the page.
+unsigned int linear_allocator::page_size(unsigned int index) const
+{
+    unsigned int size = m_page_size;
+    for (unsigned int doublings = min(index / c_pages_per_doubling, c_max_doublings); doublings--;)
+    {
+        if (size > c_max_grown_page_size / 2)
+            break;
+        size *= 2;
+    }
+    return size;
+}
+
 //------------------------------------------------------------------------------
 void linear_allocator::free_chain(bool keep_one)
 {
-    m_used = m_ptr && keep_one ? sizeof(m_ptr) : m_max;
+    free_oversized();
 
+    // The head of the chain is the newest page, and the tail is the oldest.
+    // Keep the tail, since it's the smallest; then the growth sequence starts
+    // over after a reset.
     char* ptr = m_ptr;
-
-    if (!keep_one)
-        m_ptr = nullptr;
-
+    unsigned int index = m_pages;
     while (ptr)
     {
-        char* tmp = ptr;
-        ptr = *reinterpret_cast<char**>(ptr);
-        if (keep_one)
+        char* next = *reinterpret_cast<char**>(ptr);
+        --index;
+        if (keep_one && !next)
         {
-            *reinterpret_cast<char**>(tmp) = nullptr;
-            tmp = nullptr;
-            keep_one = false;
+            assert(index == 0);
+            *reinterpret_cast<char**>(ptr) = nullptr;
+            m_ptr = ptr;
+            m_pages = 1;
+            m_max = page_size(0);
+            m_used = sizeof(m_ptr);
+            return;
         }
-        free(tmp);
+        give_page(ptr, page_size(index));
+        ptr = next;
+    }
+
+    m_ptr = nullptr;
+    m_pages = 0;
+    m_max = m_page_size;
+    m_used = m_max;
+}
+
+//------------------------------------------------------------------------------
+void linear_allocator::free_oversized()
+{
+    while (m_oversized)
+    {
+        char* next = *reinterpret_cast<char**>(m_oversized);
+        free(m_oversized);
+        m_oversized = next;
     }
 }
@@ -0,0 +1,104 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "match_wild.h"
+#include "str_iter.h"
+
+namespace path
+{
+
+//------------------------------------------------------------------------------
+compiled_wild_pattern::compiled_wild_pattern(const char* pattern, int len)
+: m_mode(str_compare_scope::current())
+, m_fuzzy_accents(str_compare_scope::current_fuzzy_accents())
+{
+    str_iter iter(pattern, len);
+    to_utf16(m_pattern, iter);
+    fold(m_pattern, m_mode, m_fuzzy_accents);
+
+    // Split the literal runs between wildcards and path separators.
+    const wchar_t* const start = m_pattern.c_str();
+    const wchar_t* segment_start = start;
+    for (const wchar_t* walk = start;; ++walk)
+    {
+        const wchar_t c = *walk;
+        if (!c || c == '*' || c == '?' || path::is_separator(c))
+        {
+            if (walk > segment_start)
+                m_segments.push_back({ unsigned(segment_start - start), unsigned(walk - segment_start) });
+            if (!c)
+                break;
+            segment_start = walk + 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool compiled_wild_pattern::match(const char* file, int len, star_matches_everything match_everything) const
+{
+    str_iter iter(file, len);
+    m_file.clear();
+    to_utf16(m_file, iter);
+    fold(m_file, m_mode, m_fuzzy_accents);
+
+    if (!has_segments(m_file.c_str(), m_file.length()))
+        return false;
+
+    // Everything is already folded, so an exact comparison is equivalent.
+    wstr_iter pattern_iter(m_pattern.c_str(), m_pattern.length());
+    wstr_iter file_iter(m_file.c_str(), m_file.length());
+    return match_wild_impl<wchar_t, 0, false>(pattern_iter, file_iter, match_everything);
+}
+
+//------------------------------------------------------------------------------
+// Applies the same transformations match_char_impl() applies per character,
+// for the given str_compare_scope mode.
+void compiled_wild_pattern::fold(wstr_base& inout, int mode, bool fuzzy_accents)
+{
+    wchar_t* s = inout.data();
+    const unsigned int len = inout.length();
+
+    if (mode > 0 && len)
+        CharLowerBuffW(s, len);
+
+    for (unsigned int i = 0; i < len; ++i)
+    {
+        int c = s[i];
+        if (mode > 1 && c == '-')
+            c = '_';
+        if (c == '\\')
+            c = '/';
+        if (fuzzy_accents)
+            c = normalize_accent(c);
+        s[i] = wchar_t(c);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool compiled_wild_pattern::has_segments(const wchar_t* file, unsigned int len) const
+{
+    const wchar_t* walk = file;
+    const wchar_t* const end = file + len;
+
+    for (const segment& segment : m_segments)
+    {
+        const wchar_t* literal = m_pattern.c_str() + segment.offset;
+        while (true)
+        {
+            const wchar_t* hit = wmemchr(walk, literal[0], end - walk);
+            if (!hit || unsigned(end - hit) < segment.length)
+                return false;
+            if (wmemcmp(hit, literal, segment.length) == 0)
+            {
+                walk = hit + segment.length;
+                break;
+            }
+            walk = hit + 1;
+        }
+    }
+
+    return true;
+}
+
+}; // namespace path
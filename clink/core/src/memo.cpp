@@ -0,0 +1,145 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "memo.h"
+#include "os.h"
+
+//------------------------------------------------------------------------------
+void fingerprint::add(const char* value, int len)
+{
+    if (!value)
+    {
+        add(-1ll);
+        return;
+    }
+
+    if (len < 0)
+        len = int(strlen(value));
+    add((long long)len);
+    mix(value, len);
+}
+
+//------------------------------------------------------------------------------
+void fingerprint::add(long long value)
+{
+    mix(&value, sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+void fingerprint::add_cwd()
+{
+    str<280> cwd;
+    os::get_current_dir(cwd);
+    add(cwd.c_str(), cwd.length());
+}
+
+//------------------------------------------------------------------------------
+void fingerprint::add_env(const char* name)
+{
+    add(name);
+
+    str<> value;
+    if (os::get_env(name, value))
+        add(value.c_str(), value.length());
+    else
+        add(-1ll);
+}
+
+//------------------------------------------------------------------------------
+// Adds the attributes, size, and last write time of a file or directory.  A
+// relative path is relative to the current directory.  Writing to a directory
+// changes its last write time only when entries are added, removed, or
+// renamed.
+void fingerprint::add_path_stamp(const char* path)
+{
+    str<280> full;
+    if (!os::get_full_path_name(path, full))
+        full = path;
+    add(full.c_str(), full.length());
+
+    DWORD attr;
+    unsigned long long size;
+    FILETIME modified;
+    if (!os::get_file_stamp(full.c_str(), attr, size, modified))
+    {
+        add(-1ll);
+        return;
+    }
+
+    add((long long)attr);
+    add((long long)size);
+    add((long long)(((unsigned long long)modified.dwHighDateTime << 32) | modified.dwLowDateTime));
+}
+
+//------------------------------------------------------------------------------
+// FNV-1a.
+void fingerprint::mix(const void* data, size_t len)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    while (len--)
+    {
+        m_hash ^= *(p++);
+        m_hash *= 0x100000001b3ull;
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+memo_cache::memo_cache(unsigned int capacity)
+: m_capacity(max<unsigned int>(capacity, 1))
+{
+}
+
+//------------------------------------------------------------------------------
+bool memo_cache::find(unsigned long long key, str_base& out, str_base& rout)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        if (iter->key == key)
+        {
+            out = iter->out.c_str();
+            rout = iter->rout.c_str();
+            if (iter != m_entries.begin())
+            {
+                entry e = std::move(*iter);
+                m_entries.erase(iter);
+                m_entries.insert(m_entries.begin(), std::move(e));
+            }
+            m_hits++;
+            return true;
+        }
+    }
+
+    m_misses++;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void memo_cache::store(unsigned long long key, const char* out, const char* rout)
+{
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter)
+    {
+        if (iter->key == key)
+        {
+            m_entries.erase(iter);
+            break;
+        }
+    }
+
+    if (m_entries.size() >= m_capacity)
+        m_entries.pop_back();
+
+    entry e;
+    e.key = key;
+    e.out = out ? out : "";
+    e.rout = rout ? rout : "";
+    m_entries.insert(m_entries.begin(), std::move(e));
+}
+
+//------------------------------------------------------------------------------
+void memo_cache::clear()
+{
+    m_entries.clear();
+}
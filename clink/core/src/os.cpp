@@ -239,6 +239,24 @@ int get_file_size(const char* path)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+// Gets the attributes, size, and last write time of a file or directory.
+bool get_file_stamp(const char* path, DWORD& attr, unsigned long long& size, FILETIME& modified)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data))
+    {
+        map_errno();
+        return false;
+    }
+
+    attr = data.dwFileAttributes;
+    size = (unsigned long long)(data.nFileSizeHigh) << 32 | data.nFileSizeLow;
+    modified = data.ftLastWriteTime;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void get_current_dir(str_base& out)
 {
@@ -63,21 +63,18 @@ static auto& get_custom_default_map()
 
 
 //------------------------------------------------------------------------------
-setting_iter::setting_iter(setting_map& map)
-: m_map(map)
-, m_iter(map.begin())
+setting_iter::setting_iter(const setting_map& map)
 {
+    map.get_sorted(m_sorted);
 }
 
 //------------------------------------------------------------------------------
 setting* setting_iter::next()
 {
-    if (m_iter == m_map.end())
+    if (m_index >= m_sorted.size())
         return nullptr;
 
-    auto* i = m_iter->second;
-    m_iter++;
-    return i;
+    return m_sorted[m_index++]->second;
 }
 
 
@@ -440,10 +437,11 @@ static bool save_internal(const char* file, bool migrating)
     for (auto iter : get_loaded_map())
         iter.second.saved = false;
 
-    // Iterate over each setting and write it out to the file.
-    for (auto i : get_map())
+    // Iterate over each setting and write it out to the file.  Sorted, so
+    // that the file doesn't reorder itself from one save to the next.
+    setting_iter sorted(get_map());
+    while (setting* iter = sorted.next())
     {
-        setting* iter = i.second;
         auto loaded = get_loaded_map().find(iter->get_name());
         if (loaded != get_loaded_map().end())
             loaded->second.saved = true;
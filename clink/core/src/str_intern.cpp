@@ -0,0 +1,233 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "str_intern.h"
+#include "str_hash.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+struct str_intern_pool::entry
+{
+    unsigned int            hash;
+    unsigned int            len;
+    unsigned int            refs;
+    unsigned int            idle_since;     // Generation when refs reached zero.
+    bool                    queued;         // Whether it's in m_idle.
+    char                    text[1];
+};
+
+//------------------------------------------------------------------------------
+static const unsigned int c_min_slots = 256;
+
+
+
+//------------------------------------------------------------------------------
+str_intern_pool::str_intern_pool(unsigned int grace_generations)
+: m_grace(max<unsigned int>(grace_generations, 1))
+{
+}
+
+//------------------------------------------------------------------------------
+str_intern_pool::~str_intern_pool()
+{
+    for (entry* e : m_slots)
+        free(e);
+}
+
+//------------------------------------------------------------------------------
+const char* str_intern_pool::acquire(const char* str, int len)
+{
+    if (!str)
+        return nullptr;
+    if (len < 0)
+        len = int(strlen(str));
+
+    const unsigned int hash = str_hash_words(str, len);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    entry* e = find(str, len, hash);
+    if (e)
+    {
+        e->refs++;
+        m_stats.hits++;
+        return e->text;
+    }
+
+    e = static_cast<entry*>(malloc(offsetof(entry, text) + len + 1));
+    if (!e)
+        return nullptr;
+
+    e->hash = hash;
+    e->len = len;
+    e->refs = 1;
+    e->idle_since = 0;
+    e->queued = false;
+    memcpy(e->text, str, len);
+    e->text[len] = '\0';
+
+    if ((m_count + 1) * 4 > m_slots.size() * 3)
+        grow();
+    insert(e);
+
+    m_stats.allocs++;
+    m_stats.bytes += len + 1;
+    return e->text;
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::release(const char* str)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    release_locked(str);
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::release(const char* const* strs, unsigned int count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (unsigned int i = 0; i < count; ++i)
+        release_locked(strs[i]);
+}
+
+//------------------------------------------------------------------------------
+// Reclaims strings that have had no references for the grace period.
+void str_intern_pool::next_generation()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_generation++;
+
+    while (!m_idle.empty())
+    {
+        entry* e = m_idle.front();
+        if (e->refs)
+        {
+            // It was reacquired.
+            e->queued = false;
+            m_idle.pop_front();
+            continue;
+        }
+
+        // Entries that were reacquired and released again can be out of
+        // order; they just delay reclaiming the ones behind them a little.
+        if (m_generation - e->idle_since < m_grace)
+            break;
+
+        m_idle.pop_front();
+        erase(e);
+        m_stats.reclaimed++;
+        m_stats.bytes -= e->len + 1;
+        free(e);
+    }
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::get_stats(str_intern_stats& out) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out = m_stats;
+    out.live = m_count;
+    out.idle = 0;
+    for (const entry* e : m_idle)
+        out.idle += !e->refs;
+}
+
+//------------------------------------------------------------------------------
+str_intern_pool::entry* str_intern_pool::find(const char* str, unsigned int len, unsigned int hash) const
+{
+    if (m_slots.empty())
+        return nullptr;
+
+    const unsigned int mask = unsigned(m_slots.size() - 1);
+    for (unsigned int i = hash & mask;; i = (i + 1) & mask)
+    {
+        entry* e = m_slots[i];
+        if (!e)
+            return nullptr;
+        if (e->hash == hash && e->len == len && memcmp(e->text, str, len) == 0)
+            return e;
+    }
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::insert(entry* e)
+{
+    const unsigned int mask = unsigned(m_slots.size() - 1);
+    unsigned int i = e->hash & mask;
+    while (m_slots[i])
+        i = (i + 1) & mask;
+    m_slots[i] = e;
+    m_count++;
+}
+
+//------------------------------------------------------------------------------
+// Removes the entry, shifting later entries in the same cluster back so that
+// lookups don't need tombstones.
+void str_intern_pool::erase(entry* e)
+{
+    const unsigned int mask = unsigned(m_slots.size() - 1);
+    unsigned int i = e->hash & mask;
+    while (m_slots[i] != e)
+    {
+        assert(m_slots[i]);
+        i = (i + 1) & mask;
+    }
+
+    m_slots[i] = nullptr;
+    m_count--;
+
+    for (unsigned int j = (i + 1) & mask; m_slots[j]; j = (j + 1) & mask)
+    {
+        const unsigned int home = m_slots[j]->hash & mask;
+        // Move it into the hole unless its home slot lies cyclically in (i, j].
+        const bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!stays)
+        {
+            m_slots[i] = m_slots[j];
+            m_slots[j] = nullptr;
+            i = j;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::grow()
+{
+    std::vector<entry*> old;
+    old.swap(m_slots);
+    m_slots.resize(max<size_t>(c_min_slots, old.size() * 2), nullptr);
+    m_count = 0;
+    for (entry* e : old)
+        if (e)
+            insert(e);
+}
+
+//------------------------------------------------------------------------------
+void str_intern_pool::release_locked(const char* str)
+{
+    if (!str)
+        return;
+
+    entry* e = from_str(str);
+    assert(e->refs);
+    if (--e->refs)
+        return;
+
+    e->idle_since = m_generation;
+    if (!e->queued)
+    {
+        e->queued = true;
+        m_idle.push_back(e);
+    }
+}
+
+//------------------------------------------------------------------------------
+str_intern_pool::entry* str_intern_pool::from_str(const char* str)
+{
+    return reinterpret_cast<entry*>(const_cast<char*>(str) - offsetof(entry, text));
+}
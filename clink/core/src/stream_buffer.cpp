@@ -0,0 +1,395 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "stream_buffer.h"
+#include "os.h"
+#include "str.h"
+
+#include <chrono>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+struct stream_buffer::segment
+{
+    segment*                next;
+    unsigned int            used;
+    char                    data[1];
+};
+
+//------------------------------------------------------------------------------
+static unsigned int count_newlines(const char* data, unsigned int len)
+{
+    unsigned int count = 0;
+    const char* end = data + len;
+    while (const char* nl = static_cast<const char*>(memchr(data, '\n', end - data)))
+    {
+        count++;
+        data = nl + 1;
+    }
+    return count;
+}
+
+
+
+//------------------------------------------------------------------------------
+stream_buffer::stream_buffer(unsigned int segment_size, unsigned int spill_threshold)
+: m_segment_size(max<unsigned int>(segment_size, 16))
+, m_spill_threshold(spill_threshold)
+{
+}
+
+//------------------------------------------------------------------------------
+stream_buffer::~stream_buffer()
+{
+    clear_locked();
+    free(m_spare);
+}
+
+//------------------------------------------------------------------------------
+void stream_buffer::write(const char* data, unsigned int len)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed || m_finished)
+            return;
+
+        while (len)
+        {
+            // Once anything has spilled, everything after it must spill too,
+            // to keep the data in order.
+            if (m_file_write > m_file_read || m_buffered >= m_spill_threshold)
+            {
+                if (spill_locked(data, len))
+                {
+                    m_available += len;
+                    m_newlines += count_newlines(data, len);
+                    break;
+                }
+                // The rest can only go to memory if nothing is waiting in the
+                // file; otherwise it's lost, the same as a failed read.
+                if (m_file_write > m_file_read)
+                    break;
+            }
+
+            if (!m_tail || m_tail->used >= m_segment_size)
+            {
+                segment* seg = new_segment();
+                if (!seg)
+                    break;
+                append_segment(seg);
+            }
+
+            const unsigned int n = min(len, m_segment_size - m_tail->used);
+            memcpy(m_tail->data + m_tail->used, data, n);
+            m_tail->used += n;
+            m_available += n;
+            m_buffered += n;
+            m_newlines += count_newlines(data, n);
+            data += n;
+            len -= n;
+        }
+    }
+
+    m_cv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+void stream_buffer::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+
+    m_cv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+void stream_buffer::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    clear_locked();
+}
+
+//------------------------------------------------------------------------------
+bool stream_buffer::is_finished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished;
+}
+
+//------------------------------------------------------------------------------
+unsigned int stream_buffer::available() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_available;
+}
+
+//------------------------------------------------------------------------------
+// Returns whether reading the specified number of lines and bytes (or all the
+// data, if all is true) can complete without waiting for the producer.
+bool stream_buffer::can_read(unsigned int lines, unsigned int bytes, bool all) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return can_read_locked(lines, bytes, all);
+}
+
+//------------------------------------------------------------------------------
+bool stream_buffer::wait_readable(unsigned int lines, unsigned int bytes, bool all, unsigned int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto pred = [&] () { return m_closed || can_read_locked(lines, bytes, all); };
+
+    if (timeout_ms == INFINITE)
+    {
+        m_cv.wait(lock, pred);
+        return true;
+    }
+
+    return m_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), pred);
+}
+
+//------------------------------------------------------------------------------
+// Reads the next line.  Returns false if there's no complete line yet, or if
+// there's no more data.  Once the producer has finished, a partial last line
+// counts as a line.
+bool stream_buffer::read_line(str_base& out, bool keep_eol)
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_available)
+        return false;
+
+    unsigned int len = 0;
+    if (m_newlines)
+    {
+        unsigned int offset = m_head_offset;
+        for (const segment* seg = m_head;; seg = seg->next, offset = 0)
+        {
+            if (!seg)
+            {
+                if (!load_locked())
+                    break;
+                seg = m_tail;
+            }
+
+            const char* start = seg->data + offset;
+            const char* nl = static_cast<const char*>(memchr(start, '\n', seg->used - offset));
+            if (nl)
+            {
+                len += unsigned(nl - start) + 1;
+                break;
+            }
+            len += seg->used - offset;
+        }
+    }
+    else if (m_finished)
+    {
+        len = m_available;
+    }
+    else
+    {
+        return false;
+    }
+
+    take_locked(&out, len);
+
+    if (!keep_eol && out.length() && out.c_str()[out.length() - 1] == '\n')
+        out.truncate(out.length() - 1);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+unsigned int stream_buffer::read(str_base& out, unsigned int max)
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return take_locked(&out, min(max, m_available));
+}
+
+//------------------------------------------------------------------------------
+unsigned int stream_buffer::peek(char* out, unsigned int max)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    unsigned int copied = 0;
+    unsigned int offset = m_head_offset;
+    for (const segment* seg = m_head; copied < max; seg = seg->next, offset = 0)
+    {
+        if (!seg)
+        {
+            if (!load_locked())
+                break;
+            seg = m_tail;
+        }
+
+        const unsigned int n = min(max - copied, seg->used - offset);
+        memcpy(out + copied, seg->data + offset, n);
+        copied += n;
+    }
+    return copied;
+}
+
+//------------------------------------------------------------------------------
+bool stream_buffer::can_read_locked(unsigned int lines, unsigned int bytes, bool all) const
+{
+    if (m_finished)
+        return true;
+    if (all)
+        return false;
+    return m_newlines >= lines && m_available >= bytes;
+}
+
+//------------------------------------------------------------------------------
+// Removes up to len bytes from the front of the buffer, appending them to out
+// if out isn't null.  Drained segments are freed, except one is kept to be
+// reused.  Spilled data is loaded as the data in memory runs out.
+unsigned int stream_buffer::take_locked(str_base* out, unsigned int len)
+{
+    unsigned int taken = 0;
+    while (taken < len)
+    {
+        if ((!m_head || (m_head == m_tail && m_head_offset >= m_head->used)) && !load_locked())
+            break;
+
+        const char* start = m_head->data + m_head_offset;
+        const unsigned int n = min(len - taken, m_head->used - m_head_offset);
+        if (out)
+            out->concat_no_truncate(start, n);
+        m_newlines -= count_newlines(start, n);
+        m_available -= n;
+        m_buffered -= n;
+        m_head_offset += n;
+        taken += n;
+
+        if (m_head_offset >= m_head->used && (m_head != m_tail || m_head->used >= m_segment_size || m_closed))
+        {
+            segment* drained = m_head;
+            m_head = m_head->next;
+            m_head_offset = 0;
+            if (!m_head)
+                m_tail = nullptr;
+
+            if (!m_spare)
+                m_spare = drained;
+            else
+                free(drained);
+        }
+    }
+
+    assert(m_available || !m_newlines);
+    return taken;
+}
+
+//------------------------------------------------------------------------------
+stream_buffer::segment* stream_buffer::new_segment()
+{
+    segment* seg = m_spare;
+    if (seg)
+        m_spare = nullptr;
+    else
+        seg = static_cast<segment*>(malloc(sizeof(segment) - 1 + m_segment_size));
+
+    if (seg)
+    {
+        seg->next = nullptr;
+        seg->used = 0;
+    }
+    return seg;
+}
+
+//------------------------------------------------------------------------------
+void stream_buffer::append_segment(segment* seg)
+{
+    if (m_tail)
+        m_tail->next = seg;
+    else
+        m_head = seg;
+    m_tail = seg;
+}
+
+//------------------------------------------------------------------------------
+// Appends data to the spill file, creating it the first time.  If the file
+// can't be created, the data stays in memory instead.
+bool stream_buffer::spill_locked(const char* data, unsigned int len)
+{
+    if (!m_file)
+    {
+        if (m_spill_failed)
+            return false;
+        m_file = os::create_temp_file(nullptr, "clk", ".tmp", os::binary|os::delete_on_close);
+        if (!m_file)
+        {
+            m_spill_failed = true;
+            return false;
+        }
+    }
+
+    if (_fseeki64(m_file, m_file_write, SEEK_SET) != 0 ||
+        fwrite(data, 1, len, m_file) != len)
+        return false;
+
+    m_file_write += len;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Loads the next segment's worth of spilled data into memory.  The data in
+// memory always precedes the spilled data, so it goes at the tail.
+bool stream_buffer::load_locked()
+{
+    if (m_file_read >= m_file_write)
+        return false;
+
+    segment* seg = new_segment();
+    if (!seg)
+        return false;
+
+    const unsigned int want = unsigned(min<long long>(m_segment_size, m_file_write - m_file_read));
+    if (_fseeki64(m_file, m_file_read, SEEK_SET) != 0 ||
+        fread(seg->data, 1, want, m_file) != want)
+    {
+        free(seg);
+        return false;
+    }
+
+    seg->used = want;
+    append_segment(seg);
+    m_buffered += want;
+    m_file_read += want;
+
+    // Once everything spilled has been loaded, the file can be reused from
+    // the beginning.
+    if (m_file_read >= m_file_write)
+        m_file_read = m_file_write = 0;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void stream_buffer::clear_locked()
+{
+    while (m_head)
+    {
+        segment* next = m_head->next;
+        free(m_head);
+        m_head = next;
+    }
+    m_tail = nullptr;
+    m_head_offset = 0;
+
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_file_read = 0;
+    m_file_write = 0;
+
+    m_available = 0;
+    m_newlines = 0;
+    m_buffered = 0;
+}
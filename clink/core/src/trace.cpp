@@ -0,0 +1,258 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "trace.h"
+#include "debugheap.h"
+#include "str_intern.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Each thread gets its own ring buffer the first time it records a span, and
+// the buffers are never freed, so that spans from threads that have exited can
+// still be dumped.  Only the owning thread writes to a buffer.
+//
+// A reader may copy a slot while the owner is overwriting it.  To detect that,
+// the owner publishes the index it is about to write (m_pending) before writing
+// the slot, and publishes the new count (m_count) after.  Any slot the reader
+// copied that is older than the newest pending index minus the capacity may be
+// torn, and is discarded.
+static const unsigned int c_events_per_thread = 8192;
+
+//------------------------------------------------------------------------------
+struct trace_event
+{
+    std::atomic<const char*>    name;
+    std::atomic<const char*>    detail;
+    std::atomic<long long>      begin;
+    std::atomic<long long>      end;
+};
+
+//------------------------------------------------------------------------------
+struct trace_buffer
+{
+    std::atomic<unsigned int>   m_count;
+    std::atomic<unsigned int>   m_pending;
+    unsigned int                m_tid;
+    trace_buffer*               m_next;
+    trace_event                 m_events[c_events_per_thread];
+};
+
+//------------------------------------------------------------------------------
+struct trace_event_copy
+{
+    const char*                 name;
+    const char*                 detail;
+    long long                   begin;
+    long long                   end;
+};
+
+//------------------------------------------------------------------------------
+static std::atomic<trace_buffer*> s_buffers;
+static std::atomic<long long> s_start;
+static threadlocal trace_buffer* ts_buffer = nullptr;
+
+//------------------------------------------------------------------------------
+static unsigned int get_thread_id()
+{
+    return GetCurrentThreadId();
+}
+
+//------------------------------------------------------------------------------
+static unsigned int get_process_id()
+{
+    return GetCurrentProcessId();
+}
+
+//------------------------------------------------------------------------------
+static trace_buffer* get_buffer()
+{
+    if (!ts_buffer)
+    {
+        dbg_ignore_scope(snapshot, "Trace buffer");
+
+        trace_buffer* buffer = new trace_buffer;
+        buffer->m_count = 0;
+        buffer->m_pending = 0;
+        buffer->m_tid = get_thread_id();
+        buffer->m_next = s_buffers.load();
+        while (!s_buffers.compare_exchange_weak(buffer->m_next, buffer))
+        {
+        }
+
+        ts_buffer = buffer;
+    }
+
+    return ts_buffer;
+}
+
+//------------------------------------------------------------------------------
+static void write_json_string(FILE* out, const char* s)
+{
+    fputc('"', out);
+    for (const char* p = s; *p; ++p)
+    {
+        const unsigned char c = *p;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+
+
+namespace trace
+{
+
+//------------------------------------------------------------------------------
+std::atomic<bool> s_enabled;
+
+//------------------------------------------------------------------------------
+// Spans that begin before tracing is enabled are not included in dumps, so
+// turning tracing off and on again starts a fresh trace.
+void enable(bool enable)
+{
+    if (enable && !is_enabled())
+        s_start = now();
+    s_enabled = enable;
+}
+
+//------------------------------------------------------------------------------
+// Returns a timestamp in nanoseconds, for use with record().
+long long now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Returns a copy of the string that lives as long as the process.  The copies
+// are never released, so identical strings only cost one copy.
+const char* intern(const char* s)
+{
+    if (!s || !*s)
+        return nullptr;
+
+    dbg_ignore_scope(snapshot, "Trace strings");
+    static str_intern_pool s_strings;
+    return s_strings.acquire(s);
+}
+
+//------------------------------------------------------------------------------
+void record(const char* name, const char* detail, long long begin, long long end)
+{
+    trace_buffer* buffer = get_buffer();
+    const unsigned int index = buffer->m_count.load(std::memory_order_relaxed);
+
+    buffer->m_pending.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    trace_event& event = buffer->m_events[index % c_events_per_thread];
+    event.name.store(name, std::memory_order_relaxed);
+    event.detail.store(detail, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+
+    buffer->m_count.store(index + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Writes the recorded spans in the Chrome trace event format.  Each thread's
+// spans are in the order they ended, which is the order viewers expect for
+// complete ("X") events.
+bool dump(FILE* out)
+{
+    fputs("{\"traceEvents\":[", out);
+
+    const long long start = s_start.load();
+    const unsigned int pid = get_process_id();
+
+    bool first = true;
+    std::vector<trace_event_copy> events;
+    for (trace_buffer* buffer = s_buffers.load(); buffer; buffer = buffer->m_next)
+    {
+        const unsigned int count = buffer->m_count.load(std::memory_order_acquire);
+        const unsigned int oldest = (count > c_events_per_thread) ? count - c_events_per_thread : 0;
+
+        events.clear();
+        for (unsigned int index = oldest; index < count; ++index)
+        {
+            const trace_event& event = buffer->m_events[index % c_events_per_thread];
+            events.push_back({
+                event.name.load(std::memory_order_relaxed),
+                event.detail.load(std::memory_order_relaxed),
+                event.begin.load(std::memory_order_relaxed),
+                event.end.load(std::memory_order_relaxed),
+            });
+        }
+
+        // Discard any slots that may have been overwritten while copying.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const unsigned int pending = buffer->m_pending.load(std::memory_order_relaxed);
+        const unsigned int torn = (pending > c_events_per_thread) ? pending - c_events_per_thread : 0;
+        const unsigned int skip = (torn > oldest) ? min(torn - oldest, unsigned(events.size())) : 0;
+
+        for (unsigned int i = skip; i < events.size(); ++i)
+        {
+            const trace_event_copy& event = events[i];
+            if (event.begin < start)
+                continue;
+
+            fputs(first ? "\n{\"name\":" : ",\n{\"name\":", out);
+            first = false;
+
+            write_json_string(out, event.name);
+            fprintf(out, ",\"cat\":\"clink\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u",
+                    double(event.begin - start) / 1000,
+                    double(event.end - event.begin) / 1000,
+                    pid, buffer->m_tid);
+            if (event.detail)
+            {
+                fputs(",\"args\":{\"detail\":", out);
+                write_json_string(out, event.detail);
+                fputc('}', out);
+            }
+            fputc('}', out);
+        }
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+    return !ferror(out);
+}
+
+//------------------------------------------------------------------------------
+bool dump(const char* filename)
+{
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    bool ok = dump(file);
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+}; // namespace trace
+
+
+
+//------------------------------------------------------------------------------
+void trace_scope::begin(const char* name, const char* detail)
+{
+    m_name = name;
+    m_detail = detail;
+    m_begin = trace::now();
+}
+
+//------------------------------------------------------------------------------
+void trace_scope::end()
+{
+    trace::record(m_name, m_detail, m_begin, trace::now());
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/dir_cache.h>
+#include <core/globber.h>
+#include <core/os.h>
+#include <core/str.h>
+
+#include <set>
+#include <string>
+
+//------------------------------------------------------------------------------
+static std::set<std::string> glob(const char* pattern)
+{
+    std::set<std::string> out;
+    globber globber(pattern);
+    str<> file;
+    while (globber.next(file, false))
+        out.emplace(file.c_str());
+    return out;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("dir_cache")
+{
+    fs_fixture fs;
+    dir_cache::clear();
+
+    SECTION("Prefix")
+    {
+        auto files = glob("f*");
+        REQUIRE(files.size() == 2);
+        REQUIRE(files.count("file1") == 1);
+        REQUIRE(files.count("file2") == 1);
+
+        files = glob("FILE1*");
+        REQUIRE(files.size() == 1);
+        REQUIRE(files.count("file1") == 1);
+
+        files = glob("dir1\\*");
+        REQUIRE(files.size() == 3);
+    }
+
+    SECTION("Hits")
+    {
+        dir_cache_stats before;
+        dir_cache::get_stats(before);
+
+        glob("*");
+        glob("c*");
+        glob("d*");
+
+        dir_cache_stats after;
+        dir_cache::get_stats(after);
+        REQUIRE(after.misses == before.misses + 1);
+        REQUIRE(after.hits == before.hits + 2);
+        REQUIRE(after.snapshots == 1);
+    }
+
+    SECTION("Change detection")
+    {
+        REQUIRE(glob("new*").empty());
+
+        if (FILE* f = fopen("new_file", "wt"))
+            fclose(f);
+
+        auto files = glob("new*");
+        REQUIRE(files.size() == 1);
+        REQUIRE(files.count("new_file") == 1);
+
+        REQUIRE(os::unlink("new_file"));
+        REQUIRE(glob("new*").empty());
+    }
+
+    SECTION("Trailing dot")
+    {
+        for (const char* name : { "foo", "foo.txt", "foobar" })
+            if (FILE* f = fopen(name, "wt"))
+                fclose(f);
+
+        // Same as FindFirstFileW:  "foo.*" matches "foo" too.
+        auto files = glob("foo.*");
+        REQUIRE(files.size() == 2);
+        REQUIRE(files.count("foo") == 1);
+        REQUIRE(files.count("foo.txt") == 1);
+
+        files = glob("FOO.t*");
+        REQUIRE(files.size() == 1);
+        REQUIRE(files.count("foo.txt") == 1);
+
+        for (const char* name : { "foo", "foo.txt", "foobar" })
+            REQUIRE(os::unlink(name));
+    }
+
+    SECTION("Bypass")
+    {
+        dir_cache_stats before;
+        dir_cache::get_stats(before);
+
+        auto files = glob("file?");
+        REQUIRE(files.size() == 2);
+
+        dir_cache_stats after;
+        dir_cache::get_stats(after);
+        REQUIRE(after.uncacheable == before.uncacheable + 1);
+        REQUIRE(after.snapshots == before.snapshots);
+    }
+
+    dir_cache::clear();
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/dir_walker.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static const char* walk_fs[] = {
+    "a1",
+    "B/x",
+    "B/y/z",
+    "c/.",
+    "node_modules/n1",
+    "node_modules/m/n",
+    nullptr,
+};
+
+//------------------------------------------------------------------------------
+static bool walk_equals(const dir_walk_options& options, const char* const* expected)
+{
+    std::vector<dir_walk_entry> entries;
+    if (!dir_walker::walk("", options, entries))
+        return false;
+
+    str<> tmp;
+    for (const auto& entry : entries)
+    {
+        if (!*expected)
+            return false;
+        tmp = *(expected++);
+        for (char* p = tmp.data(); *p; ++p)
+            if (*p == '/')
+                *p = PATH_SEP[0];
+        if (!entry.path.equals(tmp.c_str()))
+            return false;
+    }
+    return !*expected;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("dir_walker")
+{
+    fs_fixture fs(walk_fs);
+
+    dir_walk_options options;
+
+    SECTION("All")
+    {
+        static const char* const expected[] = {
+            "a1", "B/", "B/x", "B/y/", "B/y/z", "c/",
+            "node_modules/", "node_modules/m/", "node_modules/m/n", "node_modules/n1",
+            nullptr,
+        };
+
+        // The order doesn't depend on the number of threads.
+        options.threads = 1;
+        REQUIRE(walk_equals(options, expected));
+        options.threads = 4;
+        REQUIRE(walk_equals(options, expected));
+    }
+
+    SECTION("Ignore")
+    {
+        static const char* const expected[] = { "a1", "B/", "B/x", "B/y/", "B/y/z", "c/", nullptr };
+        options.ignore.emplace_back("NODE_*");
+        REQUIRE(walk_equals(options, expected));
+    }
+
+    SECTION("Depth")
+    {
+        static const char* const expected[] = { "a1", "B/", "c/", "node_modules/", nullptr };
+        options.max_depth = 0;
+        REQUIRE(walk_equals(options, expected));
+
+        std::vector<dir_walk_entry> entries;
+        options.max_depth = 1;
+        REQUIRE(dir_walker::walk("", options, entries));
+        REQUIRE(entries.size() == 8);
+        REQUIRE(entries[3].path.equals("B" PATH_SEP "y" PATH_SEP));
+        REQUIRE(entries[3].depth == 1);
+        REQUIRE(entries[3].dir);
+    }
+
+    SECTION("Pattern")
+    {
+        static const char* const expected[] = { "a1", "node_modules/n1", nullptr };
+        options.directories = false;
+        options.pattern = "?1";
+        REQUIRE(walk_equals(options, expected));
+    }
+
+    SECTION("Subdirectory")
+    {
+        std::vector<dir_walk_entry> entries;
+        REQUIRE(dir_walker::walk("B", options, entries));
+        REQUIRE(entries.size() == 3);
+        REQUIRE(entries[0].path.equals("x"));
+        REQUIRE(entries[0].depth == 0);
+        REQUIRE(entries[2].path.equals("y" PATH_SEP "z"));
+    }
+
+    SECTION("Limit")
+    {
+        options.max_entries = 3;
+        dir_walker limited("", options);
+        REQUIRE(limited.start());
+        REQUIRE(limited.wait());
+        REQUIRE(limited.is_truncated());
+        REQUIRE(!limited.is_canceled());
+
+        std::vector<dir_walk_entry> entries;
+        limited.get_entries(entries);
+        REQUIRE(entries.size() == 3);
+    }
+
+    SECTION("Cancel")
+    {
+        dir_walker walker("", options);
+        walker.cancel();
+        REQUIRE(walker.start());
+        REQUIRE(walker.wait());
+        REQUIRE(walker.is_canceled());
+
+        std::vector<dir_walk_entry> entries;
+        walker.get_entries(entries);
+        REQUIRE(entries.empty());
+    }
+}
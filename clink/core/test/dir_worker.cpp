@@ -0,0 +1,189 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/dir_cache.h>
+#include <core/dir_worker.h>
+#include <core/globber.h>
+#include <core/str.h>
+
+#include <atomic>
+#include <set>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Simulates a slow network share; every file system call takes a while.
+class slow_source : public dir_source
+{
+public:
+                            slow_source(unsigned int delay_ms) : m_delay(delay_ms), m_enumerations(0), m_modified(0) {}
+    void                    set_delay(unsigned int delay_ms) { m_delay = delay_ms; }
+    void                    touch() { m_modified++; }
+    unsigned int            get_enumerations() const { return m_enumerations; }
+
+    bool                    is_slow(const char* dir) override { return true; }
+    bool                    get_modified(const char* dir, FILETIME& out) override;
+    HANDLE                  find_first(const wchar_t* pattern, WIN32_FIND_DATAW& fd) override;
+    bool                    find_next(HANDLE h, WIN32_FIND_DATAW& fd) override;
+    void                    find_close(HANDLE h) override;
+
+private:
+    bool                    fill(unsigned int index, WIN32_FIND_DATAW& fd) const;
+    std::atomic<unsigned int> m_delay;
+    std::atomic<unsigned int> m_enumerations;
+    std::atomic<unsigned int> m_modified;
+};
+
+//------------------------------------------------------------------------------
+bool slow_source::get_modified(const char* dir, FILETIME& out)
+{
+    memset(&out, 0, sizeof(out));
+    out.dwLowDateTime = m_modified;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+HANDLE slow_source::find_first(const wchar_t* pattern, WIN32_FIND_DATAW& fd)
+{
+    m_enumerations++;
+    Sleep(m_delay);
+    fill(0, fd);
+    return HANDLE(new unsigned int(0));
+}
+
+//------------------------------------------------------------------------------
+bool slow_source::find_next(HANDLE h, WIN32_FIND_DATAW& fd)
+{
+    Sleep(m_delay);
+    unsigned int* index = static_cast<unsigned int*>(h);
+    return fill(++(*index), fd);
+}
+
+//------------------------------------------------------------------------------
+void slow_source::find_close(HANDLE h)
+{
+    delete static_cast<unsigned int*>(h);
+}
+
+//------------------------------------------------------------------------------
+bool slow_source::fill(unsigned int index, WIN32_FIND_DATAW& fd) const
+{
+    static const wchar_t* const c_names[] = { L"file1", L"file2", L"other" };
+    if (index >= sizeof_array(c_names))
+        return false;
+
+    memset(&fd, 0, sizeof(fd));
+    wcscpy_s(fd.cFileName, c_names[index]);
+    fd.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static std::set<std::string> glob(const char* pattern)
+{
+    std::set<std::string> out;
+    globber globber(pattern);
+    str<> file;
+    while (globber.next(file, false))
+        out.emplace(file.c_str());
+    return out;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("dir_worker")
+{
+    static const char* const dir = "\\\\fake\\share";
+    static const char* const pattern = "\\\\fake\\share\\f*";
+
+    slow_source source(50);
+    dir_cache::set_source(&source);
+    dir_cache::clear();
+
+    SECTION("Background load")
+    {
+        REQUIRE(!dir_cache::find(dir));
+
+        auto request = dir_worker::enqueue(dir, 5000);
+        REQUIRE(request);
+        REQUIRE(request->wait(5000));
+        REQUIRE(request->get_snapshot());
+        REQUIRE(request->get_snapshot()->count() == 3);
+        REQUIRE(dir_cache::find(dir));
+
+        // Globbing is served from the cache without enumerating again.
+        const unsigned int enumerations = source.get_enumerations();
+        auto files = glob(pattern);
+        REQUIRE(files.size() == 2);
+        REQUIRE(files.count("file1") == 1);
+        REQUIRE(files.count("file2") == 1);
+        REQUIRE(source.get_enumerations() == enumerations);
+    }
+
+    SECTION("Cancel")
+    {
+        auto request = dir_worker::enqueue(dir, 5000);
+        REQUIRE(request);
+        request->cancel();
+        REQUIRE(request->wait(5000));
+        REQUIRE(!request->get_snapshot());
+        REQUIRE(!dir_cache::find(dir));
+    }
+
+    SECTION("Deadline")
+    {
+        source.set_delay(100);
+
+        auto request = dir_worker::enqueue(dir, 150);
+        REQUIRE(request);
+        REQUIRE(request->wait(5000));
+        REQUIRE(!request->get_snapshot());
+        REQUIRE(!dir_cache::find(dir));
+    }
+
+    SECTION("Globber")
+    {
+        source.set_delay(600);
+
+        // Ordinarily the globber enumerates a slow directory synchronously.
+        REQUIRE(glob(pattern).size() == 2);
+        REQUIRE(source.get_enumerations() == 1);
+        dir_cache::clear();
+
+        {
+            globber::nonblocking_scope nonblocking;
+
+            // In a nonblocking scope it never waits on the slow directory.
+            const DWORD start = GetTickCount();
+            REQUIRE(glob(pattern).empty());
+            REQUIRE(GetTickCount() - start < 500);
+
+            // But it queues a load in the background (enqueue shares the
+            // request in progress), and later globbing is served from the
+            // cache.
+            auto request = dir_worker::enqueue(dir, 5000);
+            REQUIRE(request);
+            REQUIRE(request->wait(5000));
+            REQUIRE(request->get_snapshot());
+            REQUIRE(glob(pattern).size() == 2);
+        }
+    }
+
+    SECTION("Modified")
+    {
+        REQUIRE(glob(pattern).size() == 2);
+        REQUIRE(source.get_enumerations() == 1);
+
+        // A slow directory is revalidated by its modified time, not just by
+        // its TTL.
+        REQUIRE(glob(pattern).size() == 2);
+        REQUIRE(source.get_enumerations() == 1);
+
+        source.touch();
+        REQUIRE(glob(pattern).size() == 2);
+        REQUIRE(source.get_enumerations() == 2);
+    }
+
+    dir_cache::set_source(nullptr);
+    dir_cache::clear();
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/fuzzy_match.h>
+#include <core/str.h>
+#include <core/str_compare.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static int score(const char* needle, const char* text)
+{
+    const fuzzy_matcher matcher(needle);
+    int out;
+    REQUIRE(matcher.score(text, -1, out));
+    return out;
+}
+
+//------------------------------------------------------------------------------
+static bool matches(const char* needle, const char* text)
+{
+    const fuzzy_matcher matcher(needle);
+    int out;
+    const bool scored = matcher.score(text, -1, out);
+    REQUIRE(matcher.match(text) == scored);
+    return scored;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Fuzzy match")
+{
+    SECTION("Subsequence")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+
+        REQUIRE(matches("", "anything"));
+        REQUIRE(matches("abc", "abc"));
+        REQUIRE(matches("abc", "a_b_c"));
+        REQUIRE(matches("abc", "xxaxxbxxcxx"));
+        REQUIRE(!matches("abc", "acb"));
+        REQUIRE(!matches("abc", "ab"));
+        REQUIRE(!matches("abc", ""));
+        REQUIRE(score("", "anything") == 0);
+    }
+
+    SECTION("Case")
+    {
+        {
+            str_compare_scope _(str_compare_scope::exact, false);
+            REQUIRE(!matches("FB", "foo_bar"));
+            REQUIRE(matches("fB", "fooBar"));
+            REQUIRE(!matches("a-b", "a_b"));
+        }
+
+        {
+            str_compare_scope _(str_compare_scope::caseless, false);
+            REQUIRE(matches("FB", "foo_bar"));
+            REQUIRE(!matches("a-b", "a_b"));
+        }
+
+        {
+            str_compare_scope _(str_compare_scope::relaxed, false);
+            REQUIRE(matches("a-b", "A_B"));
+        }
+    }
+
+    SECTION("Separators")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+
+        REQUIRE(matches("a/b", "a\\b"));
+        REQUIRE(matches("a\\b", "a/b"));
+    }
+
+    SECTION("Ranking")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+
+        // Word boundaries beat the middle of words.
+        REQUIRE(score("fb", "foo_bar") > score("fb", "xfxxbx"));
+
+        // camelCase humps beat the middle of words.
+        REQUIRE(score("fb", "fooBar") > score("fb", "foobar"));
+
+        // Path components beat the middle of words.
+        REQUIRE(score("b", "a/b") > score("b", "ab"));
+        REQUIRE(score("b", "a\\b") == score("b", "a/b"));
+
+        // Consecutive characters beat scattered characters.
+        REQUIRE(score("abc", "abcxx") > score("abc", "axbxc"));
+
+        // Shorter gaps beat longer gaps.
+        REQUIRE(score("ab", "axb") > score("ab", "axxxb"));
+
+        // Prefixes beat substrings.
+        REQUIRE(score("bar", "barfoo") > score("bar", "foobar"));
+
+        // The tightest window is scored, not the first occurrence.
+        REQUIRE(score("ab", "axxxxab") == score("ab", "xab"));
+    }
+
+    SECTION("Large")
+    {
+        str_compare_scope _(str_compare_scope::caseless, false);
+
+        std::vector<str_moveable> files;
+        files.reserve(100000);
+        for (unsigned int i = 0; i < 100000; ++i)
+        {
+            str_moveable file;
+            file.format("%s_%05u_%s.%s",
+                        (i % 3) ? "Report" : "build",
+                        i,
+                        (i % 7) ? "final-Draft" : "foo",
+                        (i % 2) ? "txt" : "log");
+            files.emplace_back(std::move(file));
+        }
+
+        const fuzzy_matcher matcher("rfdtxt");
+
+        const DWORD start = GetTickCount();
+        unsigned int count = 0;
+        for (const auto& file : files)
+        {
+            int out;
+            if (matcher.score(file.c_str(), file.length(), out))
+                ++count;
+        }
+        const DWORD elapsed = GetTickCount() - start;
+
+        // Odd entries that are neither build nor foo.
+        unsigned int expected = 0;
+        for (unsigned int i = 0; i < 100000; ++i)
+            if ((i % 3) && (i % 7) && (i % 2))
+                ++expected;
+        REQUIRE(count == expected);
+
+        if (getenv("CLINK_TEST_BENCHMARK"))
+            printf("fuzzy_matcher: %u of %u matched in %.3fs\n",
+                   count, unsigned(files.size()), elapsed / 1000.0);
+    }
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/keyword_set.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+static const char* const c_keywords[] =
+{
+    "rem", "assoc", "color", "ftype", "if", "set", "ver", "verify", "break",
+    "call", "cd", "chdir", "cls", "copy", "date", "del", "dir", "dpath", "echo",
+    "endlocal", "erase", "exit", "for", "goto", "md", "mkdir", "mklink", "move",
+    "path", "pause", "popd", "prompt", "pushd", "rd", "ren", "rename", "rmdir",
+    "setlocal", "shift", "start", "time", "title", "type", "vol",
+};
+
+//------------------------------------------------------------------------------
+static int find_slow(const char* word, int len)
+{
+    for (unsigned int i = 0; i < sizeof_array(c_keywords); ++i)
+        if (int(strlen(c_keywords[i])) == len && _strnicmp(c_keywords[i], word, len) == 0)
+            return i;
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("keyword_set")
+{
+    keyword_set set(c_keywords, sizeof_array(c_keywords));
+    REQUIRE(set.size() == sizeof_array(c_keywords));
+
+    SECTION("Keywords")
+    {
+        for (unsigned int i = 0; i < sizeof_array(c_keywords); ++i)
+            REQUIRE(set.find(c_keywords[i]) == int(i));
+
+        REQUIRE(set.find("REM") == 0);
+        REQUIRE(set.find("SetLocal") == set.find("setlocal"));
+        REQUIRE(set.contains("rename"));
+        REQUIRE(set.contains("renamed", 6));
+    }
+
+    SECTION("Not keywords")
+    {
+        REQUIRE(!set.contains(""));
+        REQUIRE(!set.contains(nullptr));
+        REQUIRE(!set.contains("r"));
+        REQUIRE(!set.contains("re"));
+        REQUIRE(!set.contains("renamed"));
+        REQUIRE(!set.contains("set "));
+        REQUIRE(!set.contains("c\xc4"));
+        REQUIRE(!set.contains("cd", 1));
+        REQUIRE(!set.contains("[rem"));
+    }
+
+    SECTION("Fuzz")
+    {
+        // Compare against a linear search, for prefixes of the keywords and
+        // for random strings from a small alphabet.
+        for (const char* keyword : c_keywords)
+        {
+            for (int len = 0; len <= int(strlen(keyword)); ++len)
+                REQUIRE(set.find(keyword, len) == find_slow(keyword, len));
+        }
+
+        static const char c_alphabet[] = "acdeilmnoprstvACDEIRST@[ ";
+        unsigned int seed = 1;
+        str<16> word;
+        for (unsigned int i = 0; i < 20000; ++i)
+        {
+            word.clear();
+            seed = seed * 1103515245 + 12345;
+            const unsigned int len = (seed >> 16) % 9;
+            for (unsigned int j = 0; j < len; ++j)
+            {
+                seed = seed * 1103515245 + 12345;
+                const char c = c_alphabet[(seed >> 16) % (sizeof(c_alphabet) - 1)];
+                word.concat(&c, 1);
+            }
+            REQUIRE(set.find(word.c_str()) == find_slow(word.c_str(), word.length()));
+        }
+    }
+
+    SECTION("Duplicates")
+    {
+        static const char* const c_dups[] = { "abc", "ABC", "def" };
+        keyword_set dups(c_dups, sizeof_array(c_dups));
+        REQUIRE(dups.find("abc") == 0);
+        REQUIRE(dups.find("Abc") == 0);
+        REQUIRE(dups.find("def") == 2);
+    }
+}
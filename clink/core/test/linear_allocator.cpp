@@ -62,3 +62,86 @@ TEST_CASE("linear_allocator: calloc")
     REQUIRE(allocator.fits(sizeof(int) * 7));
     REQUIRE(!allocator.fits(sizeof(int) * 7 + 1));
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("linear_allocator: pool")
+{
+    linear_allocator::trim_pool();
+
+    linear_allocator_stats before;
+    linear_allocator_stats after;
+
+    SECTION("Reuse")
+    {
+        linear_allocator allocator(64 + sizeof(void*));
+
+        // The first generation allocates pages from the heap.
+        for (int i = 0; i < 10; ++i)
+            REQUIRE(allocator.alloc(64) != nullptr);
+        allocator.reset();
+
+        // Later generations reuse the same pages from the pool.
+        linear_allocator::get_pool_stats(before);
+        for (int generation = 0; generation < 5; ++generation)
+        {
+            for (int i = 0; i < 10; ++i)
+                REQUIRE(allocator.alloc(64) != nullptr);
+            allocator.reset();
+        }
+        linear_allocator::get_pool_stats(after);
+
+        REQUIRE(after.allocs == before.allocs);
+        REQUIRE(after.frees == before.frees);
+        REQUIRE(after.reuses > before.reuses);
+
+        // Clearing returns all pages to the pool, and another allocator with
+        // the same page size can use them.
+        allocator.clear();
+        linear_allocator::get_pool_stats(before);
+        linear_allocator other(64 + sizeof(void*));
+        REQUIRE(other.alloc(8) != nullptr);
+        linear_allocator::get_pool_stats(after);
+        REQUIRE(after.allocs == before.allocs);
+        REQUIRE(after.reuses == before.reuses + 1);
+    }
+
+    SECTION("Growth")
+    {
+        linear_allocator allocator(64 + sizeof(void*));
+
+        // Page sizes double every few pages, so later pages fit allocations
+        // that would have been oversized for the first page.
+        for (int i = 0; i < 20; ++i)
+            REQUIRE(allocator.alloc(64) != nullptr);
+        REQUIRE(!allocator.oversized(64 * 2));
+
+        // Reset starts the sequence over.
+        allocator.reset();
+        REQUIRE(allocator.oversized(65));
+        REQUIRE(allocator.fits(64));
+        REQUIRE(!allocator.fits(65));
+    }
+
+    SECTION("Oversized")
+    {
+        linear_allocator allocator(8 + sizeof(void*));
+
+        linear_allocator::get_pool_stats(before);
+        void* o = allocator.alloc(100);
+        REQUIRE(o != nullptr);
+        REQUIRE(allocator.unittest_in_prev_page(o, 100));
+        linear_allocator::get_pool_stats(after);
+        REQUIRE(after.oversized == before.oversized + 1);
+
+        // Oversized blocks go back to the heap, not the pool.
+        allocator.clear();
+        linear_allocator::get_pool_stats(before);
+        REQUIRE(before.pooled_pages == after.pooled_pages + 1);
+        REQUIRE(before.pooled_bytes == after.pooled_bytes + 8 + sizeof(void*));
+    }
+
+    linear_allocator::trim_pool();
+    linear_allocator::get_pool_stats(after);
+    REQUIRE(after.pooled_pages == 0);
+    REQUIRE(after.pooled_bytes == 0);
+}
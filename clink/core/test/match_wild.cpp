@@ -4,6 +4,7 @@
 #include "pch.h"
 
 #include <core/match_wild.h>
+#include <core/str_compare.h>
 
 //------------------------------------------------------------------------------
 TEST_CASE("path::match_wild()")
@@ -86,3 +87,37 @@ TEST_CASE("path::match_wild()")
         REQUIRE(!path::match_wild("*st*", "origin/master", path::star_matches_everything::at_end));
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("path::compiled_wild_pattern")
+{
+    static const char* const c_patterns[] = {
+        "", "*", "a*", "bu*", ".bu*", "*foo*", "*foo*bar", "build*.log", "*r*p",
+        "abc/bu*", "a*/d?f/*i", "abc/def/??i*", "abc\\def", "ori*", "or*st*",
+        "*st*", "FOO*", "foo_b*", "foo-b*", "?",
+    };
+    static const char* const c_files[] = {
+        "", "a", "build", ".build", "..build", "food", "qfoo", "foobar",
+        "foodbard", "build.foo123bar", "build.foo.bar.log", "wmbuild.foo.bar.log",
+        "error.cpp", "abc/build", "abc/.build", "abc/def/ghi", "abc\\\\def\\ghi",
+        "abc/def/build", "origin/master", "Foo-Bar", "foo_bar", "FOOD",
+    };
+    static const path::star_matches_everything c_flags[] = { path::no, path::yes, path::at_end };
+
+    for (int mode = str_compare_scope::exact; mode < str_compare_scope::num_scope_values; ++mode)
+    {
+        str_compare_scope _(mode, false);
+        for (const char* pattern : c_patterns)
+        {
+            const path::compiled_wild_pattern compiled(pattern);
+            for (const char* file : c_files)
+            {
+                for (auto flag : c_flags)
+                {
+                    const bool expected = path::match_wild(pattern, file, flag);
+                    REQUIRE(compiled.match(file, -1, flag) == expected);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/memo.h>
+#include <core/os.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+static unsigned long long env_fingerprint(const char* name)
+{
+    fingerprint fp;
+    fp.add_env(name);
+    return fp.get();
+}
+
+//------------------------------------------------------------------------------
+static unsigned long long path_fingerprint(const char* path)
+{
+    fingerprint fp;
+    fp.add_path_stamp(path);
+    return fp.get();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("fingerprint: values")
+{
+    fingerprint a, b, c;
+
+    a.add("ab");
+    a.add("c");
+    b.add("a");
+    b.add("bc");
+    REQUIRE(a.get() != b.get());
+
+    c.add("ab");
+    c.add("c");
+    REQUIRE(a.get() == c.get());
+
+    c.add(0ll);
+    REQUIRE(a.get() != c.get());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("fingerprint: env")
+{
+    const char* name = "clink_test_fingerprint";
+
+    os::set_env(name, nullptr);
+    const unsigned long long unset = env_fingerprint(name);
+
+    os::set_env(name, "abc");
+    const unsigned long long abc = env_fingerprint(name);
+    REQUIRE(abc != unset);
+    REQUIRE(abc == env_fingerprint(name));
+
+    os::set_env(name, "abd");
+    REQUIRE(env_fingerprint(name) != abc);
+
+    os::set_env(name, nullptr);
+    REQUIRE(env_fingerprint(name) == unset);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("fingerprint: paths")
+{
+    fs_fixture fs;
+
+    const unsigned long long file1 = path_fingerprint("file1");
+    REQUIRE(file1 == path_fingerprint("file1"));
+    REQUIRE(file1 != path_fingerprint("file2"));
+
+    // Changing the size changes the stamp.
+    FILE* f = fopen("file1", "wt");
+    REQUIRE(f);
+    fputs("changed", f);
+    fclose(f);
+    REQUIRE(path_fingerprint("file1") != file1);
+
+    // Adding a file to a directory changes the directory's stamp.
+    const unsigned long long missing = path_fingerprint("dir1/new");
+    REQUIRE(missing == path_fingerprint("dir1/new"));
+    f = fopen("dir1/new", "wt");
+    REQUIRE(f);
+    fclose(f);
+    REQUIRE(path_fingerprint("dir1/new") != missing);
+    REQUIRE(os::unlink("dir1/new"));
+    REQUIRE(path_fingerprint("dir1/new") == missing);
+
+    // Relative paths are relative to the current directory.
+    str<> full(fs.get_root());
+    full << "\\file2";
+    REQUIRE(path_fingerprint(full.c_str()) == path_fingerprint("file2"));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("memo_cache")
+{
+    memo_cache cache(2);
+    str<> out, rout;
+
+    REQUIRE(!cache.find(1, out, rout));
+
+    cache.store(1, "one", "r1");
+    cache.store(2, "two", nullptr);
+    REQUIRE(cache.find(1, out, rout));
+    REQUIRE(out.equals("one"));
+    REQUIRE(rout.equals("r1"));
+    REQUIRE(cache.find(2, out, rout));
+    REQUIRE(out.equals("two"));
+    REQUIRE(rout.empty());
+
+    // The least recently used entry is evicted.
+    REQUIRE(cache.find(1, out, rout));
+    cache.store(3, "three", "");
+    REQUIRE(!cache.find(2, out, rout));
+    REQUIRE(cache.find(1, out, rout));
+    REQUIRE(cache.find(3, out, rout));
+
+    // Storing an existing key replaces it.
+    cache.store(3, "new", "");
+    REQUIRE(cache.find(3, out, rout));
+    REQUIRE(out.equals("new"));
+
+    REQUIRE(cache.get_hits() == 6);
+    REQUIRE(cache.get_misses() == 2);
+
+    cache.clear();
+    REQUIRE(!cache.find(1, out, rout));
+}
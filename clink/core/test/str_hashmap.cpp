@@ -0,0 +1,153 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <core/str_hashmap.h>
+#include <core/str_map.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_hashmap_caseless")
+{
+    SECTION("Fold")
+    {
+        unsigned long long word;
+        memcpy(&word, "AbZ@[az\xc4", 8);
+        word = fold_ascii_word(word);
+        REQUIRE(memcmp(&word, "abz@[az\xc4", 8) == 0);
+
+        REQUIRE(str_hash_words_caseless("Hello World, ABC", 16) == str_hash_words_caseless("hello world, abc", 16));
+        REQUIRE(str_hash_words_caseless("a", 1) != str_hash_words_caseless("b", 1));
+        REQUIRE(str_iequals_ascii("Hello", "hELLO"));
+        REQUIRE(!str_iequals_ascii("Hello", "Hell"));
+        REQUIRE(!str_iequals_ascii("@", "`"));
+    }
+
+    SECTION("Basic")
+    {
+        str_hashmap_caseless<int> map;
+        REQUIRE(map.empty());
+        REQUIRE(map.find("abc") == map.end());
+
+        REQUIRE(map.emplace("abc", 1).second);
+        REQUIRE(map.emplace("Def", 2).second);
+        REQUIRE(!map.emplace("ABC", 3).second);
+        REQUIRE(map.size() == 2);
+
+        REQUIRE(map.find("aBc") != map.end());
+        REQUIRE(map.find("aBc")->second == 1);
+        REQUIRE(map.find("DEF")->second == 2);
+
+        map["ghi"] = 4;
+        REQUIRE(map.find("GHI")->second == 4);
+        map["abc"] = 5;
+        REQUIRE(map.find("abc")->second == 5);
+
+        REQUIRE(map.erase("ABC") == 1);
+        REQUIRE(map.erase("abc") == 0);
+        REQUIRE(map.find("abc") == map.end());
+        REQUIRE(map.find("def")->second == 2);
+        REQUIRE(map.find("ghi")->second == 4);
+
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(map.find("def") == map.end());
+    }
+
+    SECTION("Many")
+    {
+        std::vector<str_moveable> keys;
+        str<> tmp;
+        for (unsigned int i = 0; i < 2000; ++i)
+        {
+            tmp.format("Key_%u", i);
+            keys.emplace_back(tmp.c_str());
+        }
+
+        str_hashmap_caseless<unsigned int> map;
+        for (unsigned int i = 0; i < 2000; ++i)
+            REQUIRE(map.emplace(keys[i].c_str(), i).second);
+
+        // Erase every third key, exercising the backward shift and moving the
+        // last entry into the gap.
+        for (unsigned int i = 0; i < 2000; i += 3)
+            REQUIRE(map.erase(keys[i].c_str()) == 1);
+
+        for (unsigned int i = 0; i < 2000; ++i)
+        {
+            tmp.format("KEY_%u", i);
+            auto iter = map.find(tmp.c_str());
+            if (i % 3)
+            {
+                REQUIRE(iter != map.end());
+                REQUIRE(iter->second == i);
+            }
+            else
+            {
+                REQUIRE(iter == map.end());
+            }
+        }
+
+        // The sorted view matches std::map order.
+        str_map_caseless<unsigned int>::type reference;
+        for (const auto& entry : map)
+            reference.emplace(entry.first, entry.second);
+
+        std::vector<const str_hashmap_caseless<unsigned int>::value_type*> sorted;
+        map.get_sorted(sorted);
+        REQUIRE(sorted.size() == reference.size());
+
+        auto ref = reference.begin();
+        for (const auto* entry : sorted)
+        {
+            REQUIRE(strcmp(entry->first, ref->first) == 0);
+            ++ref;
+        }
+    }
+
+    SECTION("Benchmark")
+    {
+        // Compares lookups against std::map.  Set the CLINK_TEST_BENCHMARK
+        // environment variable to report the timings.
+        std::vector<str_moveable> keys;
+        str<> tmp;
+        for (unsigned int i = 0; i < 400; ++i)
+        {
+            tmp.format("%s.setting_%03u", (i & 1) ? "match" : "color", i);
+            keys.emplace_back(tmp.c_str());
+        }
+
+        str_map_caseless<unsigned int>::type old_map;
+        str_hashmap_caseless<unsigned int> new_map;
+        for (unsigned int i = 0; i < keys.size(); ++i)
+        {
+            old_map.emplace(keys[i].c_str(), i);
+            new_map.emplace(keys[i].c_str(), i);
+        }
+
+        const unsigned int c_rounds = 500;
+        unsigned int old_sum = 0;
+        unsigned int new_sum = 0;
+
+        const DWORD start_old = GetTickCount();
+        for (unsigned int round = 0; round < c_rounds; ++round)
+            for (const auto& key : keys)
+                old_sum += old_map.find(key.c_str())->second;
+        const DWORD elapsed_old = GetTickCount() - start_old;
+
+        const DWORD start_new = GetTickCount();
+        for (unsigned int round = 0; round < c_rounds; ++round)
+            for (const auto& key : keys)
+                new_sum += new_map.find(key.c_str())->second;
+        const DWORD elapsed_new = GetTickCount() - start_new;
+
+        REQUIRE(old_sum == new_sum);
+
+        if (getenv("CLINK_TEST_BENCHMARK"))
+            printf("%u lookups: std::map %.3fs, str_hashmap_caseless %.3fs\n",
+                   unsigned(c_rounds * keys.size()), elapsed_old / 1000.0, elapsed_new / 1000.0);
+    }
+}
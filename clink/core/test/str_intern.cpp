@@ -0,0 +1,124 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <core/str_intern.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_intern_pool: dedup")
+{
+    str_intern_pool pool;
+    str_intern_stats stats;
+
+    const char* a = pool.acquire("abc");
+    const char* b = pool.acquire("abcd", 3);
+    const char* c = pool.acquire("abd");
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+    REQUIRE(strcmp(a, "abc") == 0);
+    REQUIRE(strcmp(c, "abd") == 0);
+    REQUIRE(pool.acquire("") != nullptr);
+    REQUIRE(pool.acquire(nullptr) == nullptr);
+
+    pool.get_stats(stats);
+    REQUIRE(stats.allocs == 3);
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.live == 3);
+    REQUIRE(stats.bytes == 4 + 4 + 1);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_intern_pool: reclaim")
+{
+    str_intern_pool pool(2);
+    str_intern_stats stats;
+
+    const char* a = pool.acquire("abc");
+    pool.acquire("abc");
+    const char* b = pool.acquire("xyz");
+
+    // Still referenced.
+    pool.release(a);
+    pool.next_generation();
+    pool.next_generation();
+    pool.next_generation();
+    pool.get_stats(stats);
+    REQUIRE(stats.live == 2);
+    REQUIRE(stats.idle == 0);
+
+    // Unreferenced strings survive the grace period.
+    pool.release(a);
+    pool.release(b);
+    pool.next_generation();
+    pool.get_stats(stats);
+    REQUIRE(stats.live == 2);
+    REQUIRE(stats.idle == 2);
+
+    // Reacquiring revives an idle string without allocating.
+    REQUIRE(pool.acquire("xyz") == b);
+    pool.next_generation();
+    pool.get_stats(stats);
+    REQUIRE(stats.live == 1);
+    REQUIRE(stats.idle == 0);
+    REQUIRE(stats.reclaimed == 1);
+    REQUIRE(stats.allocs == 2);
+
+    pool.release(b);
+    pool.next_generation();
+    pool.next_generation();
+    pool.get_stats(stats);
+    REQUIRE(stats.live == 0);
+    REQUIRE(stats.reclaimed == 2);
+    REQUIRE(stats.bytes == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_intern_pool: generations")
+{
+    str_intern_pool pool(2);
+    str_intern_stats stats;
+
+    str<> tmp;
+    std::vector<const char*> held;
+
+    // Simulate repeated completion passes that produce the same strings.
+    for (unsigned int pass = 0; pass < 10; ++pass)
+    {
+        pool.release(held.data(), unsigned(held.size()));
+        held.clear();
+        pool.next_generation();
+
+        for (unsigned int i = 0; i < 2000; ++i)
+        {
+            tmp.format("c:\\some\\long\\common\\prefix\\file%u", i);
+            held.push_back(pool.acquire(tmp.c_str(), tmp.length()));
+        }
+    }
+
+    pool.get_stats(stats);
+    REQUIRE(stats.allocs == 2000);
+    REQUIRE(stats.hits == 2000 * 9);
+    REQUIRE(stats.live == 2000);
+    REQUIRE(stats.reclaimed == 0);
+
+    // Everything is still findable after erasing half the strings.
+    for (unsigned int i = 0; i < 2000; i += 2)
+        pool.release(held[i]);
+    pool.next_generation();
+    pool.next_generation();
+    pool.get_stats(stats);
+    REQUIRE(stats.live == 1000);
+    REQUIRE(stats.reclaimed == 1000);
+
+    for (unsigned int i = 1; i < 2000; i += 2)
+    {
+        tmp.format("c:\\some\\long\\common\\prefix\\file%u", i);
+        REQUIRE(pool.acquire(tmp.c_str()) == held[i]);
+    }
+    pool.get_stats(stats);
+    REQUIRE(stats.allocs == 2000);
+}
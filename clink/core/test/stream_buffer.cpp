@@ -0,0 +1,201 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <core/stream_buffer.h>
+
+#include <thread>
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: lines")
+{
+    stream_buffer buffer;
+    str<> line;
+
+    REQUIRE(!buffer.read_line(line));
+    REQUIRE(buffer.can_read(0, 0));
+    REQUIRE(!buffer.can_read(1, 0));
+
+    buffer.write("abc\ndef\n", 8);
+    REQUIRE(buffer.available() == 8);
+    REQUIRE(buffer.can_read(2, 0));
+    REQUIRE(!buffer.can_read(3, 0));
+
+    REQUIRE(buffer.read_line(line));
+    REQUIRE(line.equals("abc"));
+    REQUIRE(buffer.read_line(line, true/*keep_eol*/));
+    REQUIRE(line.equals("def\n"));
+    REQUIRE(!buffer.read_line(line));
+    REQUIRE(buffer.available() == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: partial line")
+{
+    stream_buffer buffer;
+    str<> line;
+
+    buffer.write("par", 3);
+    REQUIRE(!buffer.can_read(1, 0));
+    REQUIRE(!buffer.read_line(line));
+
+    buffer.write("tial\nlast", 9);
+    REQUIRE(buffer.read_line(line));
+    REQUIRE(line.equals("partial"));
+    REQUIRE(!buffer.read_line(line));
+    REQUIRE(!buffer.can_read(0, 0, true/*all*/));
+
+    // Once finished, the partial last line counts as a line.
+    buffer.finish();
+    REQUIRE(buffer.is_finished());
+    REQUIRE(buffer.can_read(1, 0));
+    REQUIRE(buffer.can_read(0, 0, true/*all*/));
+    REQUIRE(buffer.read_line(line));
+    REQUIRE(line.equals("last"));
+    REQUIRE(!buffer.read_line(line));
+
+    // Writes after finishing are ignored.
+    buffer.write("more\n", 5);
+    REQUIRE(buffer.available() == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: segments")
+{
+    stream_buffer buffer(16);
+    str<> line;
+
+    const char* text = "the quick brown fox\njumps over\nthe lazy dog\n";
+    buffer.write(text, unsigned(strlen(text)));
+
+    char peeked[8];
+    REQUIRE(buffer.peek(peeked, sizeof(peeked)) == sizeof(peeked));
+    REQUIRE(memcmp(peeked, "the quic", sizeof(peeked)) == 0);
+
+    REQUIRE(buffer.read_line(line));
+    REQUIRE(line.equals("the quick brown fox"));
+    REQUIRE(buffer.read_line(line));
+    REQUIRE(line.equals("jumps over"));
+
+    buffer.write("and so on", 9);
+    buffer.finish();
+
+    REQUIRE(buffer.read(line, 4) == 4);
+    REQUIRE(line.equals("the "));
+    REQUIRE(buffer.read(line, 100) == 18);
+    REQUIRE(line.equals("lazy dog\nand so on"));
+    REQUIRE(buffer.available() == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: binary")
+{
+    stream_buffer buffer(16);
+    str<> out;
+
+    const char data[] = "a\0b\0\0c\nd";
+    buffer.write(data, sizeof(data) - 1);
+    buffer.finish();
+
+    REQUIRE(buffer.read(out, 100) == sizeof(data) - 1);
+    REQUIRE(out.length() == sizeof(data) - 1);
+    REQUIRE(memcmp(out.c_str(), data, sizeof(data) - 1) == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: close")
+{
+    stream_buffer buffer;
+    str<> line;
+
+    buffer.write("abc\n", 4);
+    buffer.close();
+    REQUIRE(buffer.available() == 0);
+
+    buffer.write("def\n", 4);
+    REQUIRE(buffer.available() == 0);
+    REQUIRE(!buffer.read_line(line));
+
+    // A closed buffer never blocks.
+    REQUIRE(buffer.wait_readable(1, 0, false, 0));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: spill")
+{
+    stream_buffer buffer(16, 32);
+    str<> line;
+    str<> expected;
+
+    // Everything past the first 32 bytes goes to the spill file.
+    for (int i = 0; i < 100; ++i)
+    {
+        line.format("spilled line %d\n", i);
+        buffer.write(line.c_str(), line.length());
+    }
+    REQUIRE(buffer.can_read(100, 0));
+    REQUIRE(!buffer.can_read(101, 0));
+
+    char peeked[40];
+    REQUIRE(buffer.peek(peeked, sizeof(peeked)) == sizeof(peeked));
+    REQUIRE(memcmp(peeked, "spilled line 0\nspilled line 1\nspilled li", sizeof(peeked)) == 0);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        REQUIRE(buffer.read_line(line));
+        expected.format("spilled line %d", i);
+        REQUIRE(line.equals(expected.c_str()));
+    }
+
+    // Writes keep going to the file while spilled data remains, so the order
+    // is preserved.
+    buffer.write("tail", 4);
+    buffer.finish();
+
+    for (int i = 50; i < 100; ++i)
+    {
+        REQUIRE(buffer.read_line(line));
+        expected.format("spilled line %d", i);
+        REQUIRE(line.equals(expected.c_str()));
+    }
+    REQUIRE(buffer.read(line, 100) == 4);
+    REQUIRE(line.equals("tail"));
+    REQUIRE(buffer.available() == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("stream_buffer: producer thread")
+{
+    stream_buffer buffer(32, 256);
+
+    std::thread producer([&buffer] () {
+        str<> line;
+        for (int i = 0; i < 500; ++i)
+        {
+            line.format("line %d\n", i);
+            // Split each line across two writes.
+            const unsigned int half = line.length() / 2;
+            buffer.write(line.c_str(), half);
+            buffer.write(line.c_str() + half, line.length() - half);
+        }
+        buffer.finish();
+    });
+
+    str<> line;
+    str<> expected;
+    int count = 0;
+    while (true)
+    {
+        REQUIRE(buffer.wait_readable(1, 0));
+        if (!buffer.read_line(line))
+            break;
+        expected.format("line %d", count++);
+        REQUIRE(line.equals(expected.c_str()));
+    }
+
+    producer.join();
+    REQUIRE(count == 500);
+    REQUIRE(buffer.is_finished());
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/trace.h>
+
+#include <string>
+#include <thread>
+
+//------------------------------------------------------------------------------
+static bool dump_trace(std::string& out)
+{
+    out.clear();
+    if (!trace::dump("trace.json"))
+        return false;
+
+    FILE* file = fopen("trace.json", "rb");
+    if (!file)
+        return false;
+
+    char buffer[4096];
+    while (size_t len = fread(buffer, 1, sizeof(buffer), file))
+        out.append(buffer, len);
+    fclose(file);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static unsigned int count_occurrences(const std::string& s, const char* find)
+{
+    unsigned int count = 0;
+    for (size_t pos = s.find(find); pos != std::string::npos; pos = s.find(find, pos + 1))
+        ++count;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+static bool starts_with(const std::string& s, const char* prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+//------------------------------------------------------------------------------
+static void nested_spans()
+{
+    TRACE_SCOPE("outer", "c:\\dir\\\"file\".lua");
+    TRACE_SCOPE("inner");
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("trace")
+{
+    fs_fixture fs;
+
+    // Restarting ignores spans recorded by earlier tests.
+    trace::enable(false);
+    trace::enable(true);
+
+    std::string out;
+
+    SECTION("Disabled")
+    {
+        trace::enable(false);
+        nested_spans();
+
+        REQUIRE(dump_trace(out));
+        REQUIRE(out == "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n");
+    }
+
+    SECTION("Format")
+    {
+        nested_spans();
+        REQUIRE(dump_trace(out));
+
+        REQUIRE(starts_with(out, "{\"traceEvents\":[\n{\"name\":\"inner\",\"cat\":\"clink\",\"ph\":\"X\",\"ts\":"));
+        REQUIRE(count_occurrences(out, "},\n{\"name\":\"outer\",\"cat\":\"clink\",\"ph\":\"X\",\"ts\":") == 1);
+        REQUIRE(count_occurrences(out, ",\"args\":{\"detail\":\"c:\\\\dir\\\\\\\"file\\\".lua\"}}\n]") == 1);
+        REQUIRE(count_occurrences(out, "\"ph\":\"X\"") == 2);
+        REQUIRE(count_occurrences(out, "\"args\"") == 1);
+    }
+
+    SECTION("Threads")
+    {
+        nested_spans();
+        std::thread thread([] () {
+            for (int i = 0; i < 3; ++i)
+                nested_spans();
+        });
+        thread.join();
+
+        // Spans from threads that have exited are still dumped.
+        REQUIRE(dump_trace(out));
+        REQUIRE(count_occurrences(out, "\"name\":\"outer\"") == 4);
+        REQUIRE(count_occurrences(out, "\"name\":\"inner\"") == 4);
+    }
+
+    SECTION("Wrap")
+    {
+        // Only the most recent spans are kept.
+        for (int i = 0; i < 10000; ++i)
+            nested_spans();
+        trace::record("last", nullptr, trace::now(), trace::now());
+
+        REQUIRE(dump_trace(out));
+        REQUIRE(count_occurrences(out, "\"ph\":\"X\"") == 8192);
+        REQUIRE(count_occurrences(out, "{\"name\":\"last\",") == 1);
+    }
+
+    trace::enable(false);
+}
@@ -3,19 +3,34 @@
 
 #pragma once
 
+#include <core/base.h>
 #include <core/str.h>
-#include <core/str_map.h>
-#include <core/auto_free_str.h>
 #include <core/linear_allocator.h>
+#include <core/str_hashmap.h>
+
+#include <atomic>
+#include <vector>
 
 //------------------------------------------------------------------------------
-class alias_cache
+// Snapshot of all doskey aliases for the shell, fetched in one bulk console
+// call the first time an alias is looked up after clear().  The lookup table
+// is only rebuilt when the set of aliases has actually changed.
+class alias_cache : public no_copy
 {
 public:
-    alias_cache() : m_names(4096) {}
+    alias_cache() : m_store(4096) {}
     void clear();
     bool get_alias(const char* name, str_base& out);
+    static void notify_changed();
+    static unsigned int get_serial() { return s_serial; }
 private:
-    str_map_caseless<auto_free_str>::type m_map;
-    linear_allocator m_names;
+    bool refresh();
+    void rebuild(const std::vector<wchar_t>& raw);
+    str_hashmap_caseless<const char*> m_aliases;
+    linear_allocator m_store;
+    std::vector<wchar_t> m_raw;
+    unsigned int m_serial = 0;
+    bool m_checked = false;
+    bool m_bulk = false;
+    static std::atomic<unsigned int> s_serial;
 };
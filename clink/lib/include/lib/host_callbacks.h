@@ -18,6 +18,7 @@ public:
     virtual void filter_transient_prompt(bool final) = 0;
     virtual bool can_suggest(line_state& line) = 0;
     virtual bool suggest(line_state& line, matches* matches, int generation_id) = 0;
+    virtual bool generate_async(line_state& line, int generation_id) = 0;
     virtual void filter_matches(char** matches) = 0;
     virtual bool call_lua_rl_global_function(const char* func_name, line_state* line) = 0;
     virtual const char** copy_dir_history(int* total) = 0;
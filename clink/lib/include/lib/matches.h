@@ -120,6 +120,7 @@ private:
 
 //------------------------------------------------------------------------------
 class matches;
+namespace path { class compiled_wild_pattern; };
 
 //------------------------------------------------------------------------------
 class matches_iter
@@ -144,6 +145,7 @@ private:
     const matches&          m_matches;
     char*                   m_expanded_pattern;
     str_iter                m_pattern;
+    path::compiled_wild_pattern* m_compiled = nullptr;
     bool                    m_has_pattern = false;
     bool                    m_can_try_substring = false;
     unsigned int            m_index = 0;
@@ -189,6 +191,7 @@ public:
     virtual char            get_append_character() const = 0;
     virtual int             get_suppress_quoting() const = 0;
     virtual int             get_word_break_position() const = 0;
+    virtual bool            is_pending() const = 0;
     virtual bool            match_display_filter(const char* needle, char** matches, match_display_filter_entry*** filtered_matches, display_filter_flags flags, bool* old_filtering=nullptr) const = 0;
 
 private:
@@ -230,6 +233,7 @@ public:
                             match_builder(matches& matches);
     bool                    add_match(const char* match, match_type type, bool already_normalised=false);
     bool                    add_match(const match_desc& desc, bool already_normalised=false);
+    void                    reserve(unsigned int count);
     bool                    is_empty();
     void                    set_append_character(char append);
     void                    set_suppress_append(bool suppress=true);
@@ -5,6 +5,10 @@
 
 #include "matches.h"
 
+#include <core/base.h>
+
+#include <vector>
+
 //------------------------------------------------------------------------------
 struct match_extra
 {
@@ -33,17 +37,42 @@ private:
     static const match_extra s_empty_extra;
 };
 
+//------------------------------------------------------------------------------
+// Builds a match list for Readline, packing all the match strings into one
+// block instead of allocating each one.  The block belongs to the list's
+// lookaside table, and each match's match_extra is stored right in front of it
+// so looking up a match needs no hashing.  Readline must free the list with
+// _rl_free_match_list (or free the array after destroy_matches_lookaside), and
+// must not free the strings itself; see free_match_hook.
+class packed_matches_builder
+    : public no_copy
+{
+public:
+                            packed_matches_builder(unsigned int count_hint);
+                            ~packed_matches_builder();
+    bool                    add(const char* match, match_type type, char append_char, unsigned char flags, const char* display, const char* description);
+    unsigned int            get_count() const { return unsigned(m_offsets.size()); }
+    char**                  finish(const char* lcd, int lcd_len);
+private:
+    char*                   m_block = nullptr;
+    size_t                  m_used = 0;
+    size_t                  m_size = 0;
+    std::vector<size_t>     m_offsets;
+};
+
 //------------------------------------------------------------------------------
 // Each match in 'matches' must conform to the PACKED MATCH FORMAT (except the
 // lcd entry in [0], which is omitted from the lookaside table).
 match_details lookup_match(const char* match);
 int create_matches_lookaside(char** matches);
 int destroy_matches_lookaside(char** matches);
+bool is_packed_match(const char* match);
 void set_matches_lookaside_oneoff(const char* match, match_type type, char append_char, unsigned char flags);
 void clear_matches_lookaside_oneoff();
 
 extern "C" int lookup_match_type(const char* match);
 extern "C" void override_match_append(const char* match);
+extern "C" void free_match_hook(char* match);
 #ifdef DEBUG
 extern "C" int has_matches_lookaside(char** matches);
 #endif
@@ -5,7 +5,7 @@
 
 #include <core/base.h>
 #include <core/str.h>
-#include <core/str_map.h>
+#include <core/str_hashmap.h>
 
 #include <vector>
 
@@ -41,7 +41,7 @@ struct word_class_info
 //------------------------------------------------------------------------------
 class word_classifications : public no_copy
 {
-    typedef str_map_caseless<char>::type faces_map;
+    typedef str_hashmap_caseless<char> faces_map;
 
 public:
                     word_classifications() = default;
@@ -5,9 +5,11 @@
 
 #include "line_state.h"
 
+#include <core/str.h>
 #include <core/str_iter.h>
 #include <core/str_tokeniser.h>
 
+#include <atomic>
 #include <vector>
 
 class line_buffer;
@@ -46,11 +48,26 @@ class word_collector
         unsigned int        length;
     };
 
+    // The words and command bounds from tokenising one revision of a line.
+    struct tokenised
+    {
+        bool                matches(const char* buffer, unsigned int length, unsigned int cursor, bool stop_at_cursor, unsigned int generation) const;
+        void                set(const char* buffer, unsigned int length, unsigned int cursor, unsigned int generation);
+        bool                valid = false;
+        unsigned int        cursor = 0;
+        unsigned int        generation = 0;
+        str_moveable        line;
+        std::vector<word>   words;
+        std::vector<command> commands;
+    };
+
 public:
     word_collector(collector_tokeniser* command_tokeniser=nullptr, collector_tokeniser* word_tokeniser=nullptr, const char* quote_pair=nullptr);
     ~word_collector();
 
     void init_alias_cache();
+    void begin_line();
+    static void notify_state_changed();
 
     unsigned int collect_words(const char* buffer, unsigned int length, unsigned int cursor,
                                std::vector<word>& words, collect_words_mode mode) const;
@@ -67,14 +84,19 @@ private:
     char get_closing_quote() const;
     void find_command_bounds(const char* buffer, unsigned int length, unsigned int cursor,
                              std::vector<command>& commands, bool stop_at_cursor) const;
+    void tokenise(const char* line_buffer, unsigned int line_length, unsigned int line_cursor,
+                  tokenised& out, bool stop_at_cursor) const;
     bool get_alias(const char* name, str_base& out) const;
+    static unsigned int get_generation();
 
 private:
     collector_tokeniser* const m_command_tokeniser;
     collector_tokeniser* m_word_tokeniser;
     alias_cache* m_alias_cache = nullptr;
+    mutable tokenised m_tokenised[2];
     const char* const m_quote_pair;
     bool m_delete_word_tokeniser = false;
+    static std::atomic<unsigned int> s_generation;
 };
 
 //------------------------------------------------------------------------------
@@ -94,13 +116,19 @@ private:
 };
 
 //------------------------------------------------------------------------------
+// Splits collected words into one line_state per command.  Calling set() again
+// reuses the memory from the previous call, so a long-lived instance can be
+// rebuilt for each revision of the input line without reallocating.
 class commands
 {
 public:
+    commands() = default;
     commands(const char* line_buffer, unsigned int line_length, unsigned int line_cursor, const std::vector<word>& words);
     commands(const line_buffer& buffer, const std::vector<word>& words);
+    void set(const char* line_buffer, unsigned int line_length, unsigned int line_cursor, const std::vector<word>& words);
+    void set(const line_buffer& buffer, const std::vector<word>& words);
     const std::vector<line_state>& get_linestates() const;
 private:
-    std::vector<std::vector<word>> m_words_storage;
+    std::vector<std::vector<word>> m_words_storage; // Grows, but never shrinks.
     std::vector<line_state> m_linestates;
 };
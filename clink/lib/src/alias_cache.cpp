@@ -5,32 +5,111 @@
 #include "alias_cache.h"
 
 #include <core/os.h>
+#include <core/str_iter.h>
 
 //------------------------------------------------------------------------------
+std::atomic<unsigned int> alias_cache::s_serial(0);
+
+//------------------------------------------------------------------------------
+// Doesn't discard anything; the next lookup checks whether the aliases have
+// changed, and only rebuilds the table if they have.
 void alias_cache::clear()
 {
-    m_map.clear();
-    m_names.clear();
+    m_checked = false;
 }
 
 //------------------------------------------------------------------------------
 bool alias_cache::get_alias(const char* name, str_base& out)
 {
-    const auto& iter = m_map.find(name);
-    if (iter != m_map.end())
+    if (!m_checked || m_serial != s_serial)
+        m_bulk = refresh();
+
+    // Fall back to asking the console for each name if the bulk snapshot
+    // could not be fetched.
+    if (!m_bulk)
+        return os::get_alias(name, out);
+
+    const auto iter = m_aliases.find(name);
+    if (iter == m_aliases.end())
+        return false;
+
+    out = iter->second;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Aliases changed by this process invalidate every cache immediately, rather
+// than waiting until the next clear().
+void alias_cache::notify_changed()
+{
+    s_serial++;
+}
+
+//------------------------------------------------------------------------------
+bool alias_cache::refresh()
+{
+    m_checked = true;
+    m_serial = s_serial;
+
+    // The console returns "name=value" strings, each NUL terminated.
+    wchar_t* shell_name = const_cast<wchar_t*>(os::get_shellname());
+    const DWORD bytes = GetConsoleAliasesLengthW(shell_name);
+
+    std::vector<wchar_t> raw;
+    if (bytes)
     {
-        const char* value = iter->second.get();
-        if (!value || !*value)
+        raw.resize(bytes / sizeof(wchar_t));
+        if (!GetConsoleAliasesW(raw.data(), bytes, shell_name))
             return false;
-        out = value;
-        return true;
     }
 
-    const bool exists = os::get_alias(name, out);
+    if (!m_bulk || raw != m_raw)
+    {
+        rebuild(raw);
+        m_raw.swap(raw);
+    }
 
-    const char* cache_name = m_names.store(name);
-    auto_free_str cache_value(out.c_str(), out.length());
-    m_map.emplace(cache_name, std::move(cache_value));
+    return true;
+}
 
-    return exists;
+//------------------------------------------------------------------------------
+void alias_cache::rebuild(const std::vector<wchar_t>& raw)
+{
+    unsigned int count = 0;
+    for (wchar_t c : raw)
+        if (!c)
+            count++;
+
+    m_aliases.clear();
+    m_aliases.reserve(count);
+    m_store.reset();
+
+    str<> name;
+    str<> value;
+    const wchar_t* end = raw.data() + raw.size();
+    for (const wchar_t* walk = raw.data(); walk < end;)
+    {
+        const wchar_t* entry = walk;
+        while (walk < end && *walk)
+            walk++;
+        const wchar_t* eq = entry;
+        while (eq < walk && *eq != '=')
+            eq++;
+
+        if (eq > entry && eq + 1 < walk)
+        {
+            wstr_iter name_iter(entry, int(eq - entry));
+            wstr_iter value_iter(eq + 1, int(walk - (eq + 1)));
+            name.clear();
+            value.clear();
+            to_utf8(name, name_iter);
+            to_utf8(value, value_iter);
+            const char* stored_name = m_store.store(name.c_str());
+            const char* stored_value = m_store.store(value.c_str());
+            if (stored_name && stored_value)
+                m_aliases.emplace(stored_name, stored_value);
+        }
+
+        walk++;
+    }
 }
@@ -8,6 +8,7 @@
 #include <core/base.h>
 #include <core/os.h>
 #include <core/settings.h>
+#include <core/keyword_set.h>
 #include <core/debugheap.h>
 
 extern setting_bool g_enhanced_doskey;
@@ -112,37 +113,34 @@ const char* const cmd_state::c_delimit = "&(=+[]\\|;:,.<>/ \t";
 //------------------------------------------------------------------------------
 bool is_cmd_command(const char* word, state_flag* flag)
 {
-    dbg_ignore_scope(snapshot, "is_cmd_command"); // (s_map ctor allocates.)
-    static str_map_caseless<state_flag>::type s_map;
+    // Internal commands in CMD get special word break treatment.
 
-    if (s_map.size() == 0)
+    // NOTE: Keep in sync with cmd_commands in cmd.lua.
+    static const char* const c_cmds[] =
     {
-        // Internal commands in CMD get special word break treatment.
+        // Must be first; see below.
+        "rem",
+        // These treat special word break characters as part of the input.
+        "assoc", "color", "ftype", "if", "set", "ver", "verify",
+        // These treat special word break characters as ignored delimiters.
+        "break", "call", "cd", "chdir", "cls", "copy", "date", "del", "dir",
+        "dpath", "echo", "endlocal", "erase", "exit", "for", "goto", "md",
+        "mkdir", "mklink", "move", "path", "pause", "popd", "prompt", "pushd",
+        "rd", "ren", "rename", "rmdir", "setlocal", "shift", "start", "time",
+        "title", "type", "vol",
+    };
 
-        // NOTE: Keep in sync with cmd_commands in cmd.lua.
-        static const char* const c_cmds[] =
-        {
-            // These treat special word break characters as part of the input.
-            "assoc", "color", "ftype", "if", "set", "ver", "verify",
-            // These treat special word break characters as ignored delimiters.
-            "break", "call", "cd", "chdir", "cls", "copy", "date", "del", "dir",
-            "dpath", "echo", "endlocal", "erase", "exit", "for", "goto", "md",
-            "mkdir", "mklink", "move", "path", "pause", "popd", "prompt", "pushd",
-            "rd", "ren", "rename", "rmdir", "setlocal", "shift", "start", "time",
-            "title", "type", "vol",
-        };
-
-        s_map.emplace("rem", flag_rem);
-        for (const char* cmd : c_cmds)
-            s_map.emplace(cmd, flag_none);
-    }
+    // This is called for each character of each command word, while
+    // tokenising each keystroke.
+    dbg_ignore_scope(snapshot, "is_cmd_command"); // (s_cmds ctor allocates.)
+    static const keyword_set s_cmds(c_cmds, sizeof_array(c_cmds));
 
-    auto const it = s_map.find(word);
-    if (it == s_map.end())
+    const int index = s_cmds.find(word);
+    if (index < 0)
         return false;
 
     if (flag)
-        *flag = it->second;
+        *flag = index ? flag_none : flag_rem;
     return true;
 }
 
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "doskey.h"
+#include "alias_cache.h"
 #include "cmd_tokenisers.h"
 
 #include <core/base.h>
@@ -299,14 +300,24 @@ bool doskey::add_alias(const char* alias, const char* text)
 {
     wstr<64> walias(alias);
     wstr<> wtext(text);
-    return (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) == TRUE);
+    if (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) != TRUE)
+        return false;
+
+    // Only after the change; a refresh in between would otherwise cache the
+    // old aliases under the new serial.
+    alias_cache::notify_changed();
+    return true;
 }
 
 //------------------------------------------------------------------------------
 bool doskey::remove_alias(const char* alias)
 {
     wstr<64> walias(alias);
-    return (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) == TRUE);
+    if (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) != TRUE)
+        return false;
+
+    alias_cache::notify_changed();
+    return true;
 }
 
 //------------------------------------------------------------------------------
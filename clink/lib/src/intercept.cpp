@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "intercept.h"
 
+#include <core/debugheap.h>
+#include <core/keyword_set.h>
 #include <core/path.h>
 #include <core/os.h>
 #include <core/str.h>
@@ -104,9 +106,10 @@ static bool parse_line_token(str_base& out, const char* line)
                 // feature even if they're legitimately part of an actual path,
                 // unless they are quoted.
                 static const char* const c_commands[] = { "call", "cd", "chdir", "dir", "echo", "md", "mkdir", "popd", "pushd" };
-                for (const char* name : c_commands)
-                    if (out.iequals(name))
-                        return false;
+                dbg_ignore_scope(snapshot, "parse_line_token"); // (s_commands ctor allocates.)
+                static const keyword_set s_commands(c_commands, sizeof_array(c_commands));
+                if (s_commands.contains(out.c_str(), out.length()))
+                    return false;
                 first_component = false;
             }
             break;
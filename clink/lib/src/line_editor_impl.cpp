@@ -14,6 +14,7 @@
 #include "doskey.h"
 
 #include <core/base.h>
+#include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_iter.h>
@@ -32,6 +33,7 @@ extern "C" {
 //------------------------------------------------------------------------------
 extern setting_bool g_classify_words;
 extern setting_bool g_autosuggest_async;
+extern setting_bool g_match_progressive;
 extern int g_suggestion_offset;
 
 extern "C" void host_clear_suggestion();
@@ -119,12 +121,12 @@ void force_update_internal(bool restrict)
 }
 
 //------------------------------------------------------------------------------
-void update_matches()
+void update_matches(bool progressive)
 {
     if (!s_editor)
         return;
 
-    s_editor->update_matches();
+    s_editor->update_matches(progressive);
 }
 
 //------------------------------------------------------------------------------
@@ -138,6 +140,17 @@ bool notify_matches_ready(int generation_id)
     return s_editor->notify_matches_ready(generation_id, matches);
 }
 
+//------------------------------------------------------------------------------
+bool notify_matches_batch(int generation_id)
+{
+    if (!s_editor)
+        return true;
+
+    auto toolkit = get_deferred_matches(generation_id);
+    matches* matches = toolkit ? toolkit->get_matches() : nullptr;
+    return s_editor->notify_matches_batch(generation_id, matches);
+}
+
 //------------------------------------------------------------------------------
 void set_prompt(const char* prompt, const char* rprompt, bool redisplay)
 {
@@ -298,6 +311,8 @@ line_editor_impl::line_editor_impl(const desc& desc)
     add_module(m_selectcomplete);
     add_module(m_textlist);
 
+    m_collector.init_alias_cache();
+
     desc.input->set_key_tester(this);
 }
 
@@ -360,6 +375,7 @@ void line_editor_impl::begin_line()
     m_desc.input->begin();
     m_desc.output->begin();
     m_buffer.begin_line();
+    m_collector.begin_line();
     m_prev_generate.clear();
     m_prev_classify.clear();
     m_prev_command_word.clear();
@@ -522,9 +538,19 @@ bool line_editor_impl::notify_matches_ready(int generation_id, matches* matches)
     if (matches && generation_id == m_generation_id)
     {
         assert(&m_matches != matches);
+        const bool pending = is_generate_pending();
         m_matches.done_building();
         m_matches.transfer(*(matches_impl*)matches);
         clear_flag(flag_generate);
+
+        // The complete set of matches replaces the batches received so far.
+        if (pending)
+        {
+            m_pending_generation_id = 0;
+            restrict_pending();
+            set_flag(flag_select);
+            m_selectcomplete.refresh_matches();
+        }
     }
     else
     {
@@ -540,22 +566,59 @@ bool line_editor_impl::notify_matches_ready(int generation_id, matches* matches)
     return true;
 }
 
+//------------------------------------------------------------------------------
+bool line_editor_impl::notify_matches_batch(int generation_id, matches* matches)
+{
+    // A newer generation id means the coroutine is generating matches nobody
+    // will use, so tell it to stop.
+    if (generation_id != m_generation_id)
+        return false;
+
+    if (!matches || !is_generate_pending())
+        return true;
+
+    assert(&m_matches != matches);
+    if (!m_matches.append_batch(*(matches_impl*)matches, m_pending_consumed))
+        return true;
+
+    restrict_pending();
+    set_flag(flag_select);
+    m_selectcomplete.refresh_matches();
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::update_matches()
+{
+    update_matches(false/*progressive*/);
+}
+
+//------------------------------------------------------------------------------
+void line_editor_impl::update_matches(bool progressive)
 {
     // Get flag states because we're about to clear them.
     bool generate = check_flag(flag_generate);
     bool restrict = check_flag(flag_restrict);
     bool select = generate || restrict || check_flag(flag_select);
 
+    // A progressive update lets a coroutine generate the matches, which then
+    // arrive in batches.  flag_generate stays set until the final batch has
+    // arrived, so that a non-progressive update (e.g. the complete command)
+    // still generates the full set of matches synchronously.
+    const bool pending = (generate && progressive &&
+                          (is_generate_pending() || start_generate_pending()));
+
     // Clear flag states before running generators, so that generators can use
     // reset_generate_matches().
-    clear_flag(flag_generate);
+    if (!pending)
+        clear_flag(flag_generate);
     clear_flag(flag_restrict);
     clear_flag(flag_select);
 
-    if (generate)
+    if (generate && !pending)
     {
+        m_pending_generation_id = 0;
+
         line_state line = get_linestate();
         match_pipeline pipeline(m_matches);
         pipeline.reset();
@@ -586,6 +649,8 @@ void line_editor_impl::update_matches()
         m_needle = tmp.c_str();
         if (!is_literal_wild() && !just_tilde)
             m_needle.concat("*", 1);
+        if (pending)
+            m_pending_restrict = m_needle.c_str();
         pipeline.restrict(m_needle);
     }
 
@@ -606,6 +671,51 @@ void line_editor_impl::update_matches()
     }
 }
 
+//------------------------------------------------------------------------------
+bool line_editor_impl::is_generate_pending() const
+{
+    return m_pending_generation_id && m_pending_generation_id == m_generation_id;
+}
+
+//------------------------------------------------------------------------------
+bool line_editor_impl::start_generate_pending()
+{
+    if (!g_match_progressive.get() || !s_callbacks)
+        return false;
+
+    line_state line = get_linestate();
+    if (!s_callbacks->generate_async(line, m_generation_id))
+        return false;
+
+    match_pipeline pipeline(m_matches);
+    pipeline.reset();
+    m_matches.set_word_break_position(line.get_end_word_offset());
+    m_matches.set_pending(true);
+
+    m_pending_generation_id = m_generation_id;
+    m_pending_consumed = 0;
+    m_pending_restrict.clear();
+
+    // Pick up any matches already generated for this generation id.
+    if (auto toolkit = get_deferred_matches(m_generation_id))
+        m_matches.append_batch(*(matches_impl*)toolkit->get_matches(), m_pending_consumed);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void line_editor_impl::restrict_pending()
+{
+    // Batches are restricted the same way the first update was, since the
+    // restricted matches were discarded and can't be reselected.
+    if (m_pending_restrict.empty())
+        return;
+
+    str<64> needle(m_pending_restrict.c_str());
+    match_pipeline pipeline(m_matches);
+    pipeline.restrict(needle);
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::dispatch(int bind_group)
 {
@@ -805,12 +915,12 @@ void line_editor_impl::collect_words()
 }
 
 //------------------------------------------------------------------------------
-commands line_editor_impl::collect_commands()
+const commands& line_editor_impl::collect_commands()
 {
     m_classify_command_offset = collect_words(m_classify_words, nullptr, collect_words_mode::whole_command);
 
-    commands commands(m_buffer, m_classify_words);
-    return commands;
+    m_classify_commands.set(m_buffer, m_classify_words);
+    return m_classify_commands;
 }
 
 //------------------------------------------------------------------------------
@@ -938,7 +1048,7 @@ void line_editor_impl::classify()
     m_classifications.init(m_buffer.get_length(), &old_classifications);
 
     // Use the full line; don't stop at the cursor.
-    commands commands = collect_commands();
+    const commands& commands = collect_commands();
     m_classifier->classify(commands.get_linestates(), m_classifications);
     m_classifications.finish(is_showing_argmatchers());
 
@@ -1291,46 +1401,21 @@ void line_editor_impl::try_suggest()
     if (host_can_suggest(line))
     {
         matches_impl* matches = nullptr;
-        matches_impl* empty_matches = nullptr;
-
-        if (m_words.size())
-        {
-            const word& word = m_words[m_words.size() - 1];
-            if (word.offset < m_buffer.get_length() && m_buffer.get_length() - word.offset >= 2)
-            {
-                // Use an empty set of matches when a UNC path is detected.
-                // Or when a remote drive is detected (or unknown or invalid).
-                // Removable drives are accepted because typically these are
-                // thumb drives these days, which are fast.
-                const char* end_word = m_buffer.get_buffer() + word.offset;
-                bool no_matches = (path::is_separator(end_word[0]) && path::is_separator(end_word[1]));
-                if (!no_matches)
-                {
-                    str<> full;
-                    if (os::get_full_path_name(end_word, full, m_buffer.get_length() - word.offset))
-                    {
-                        path::get_drive(full);
-                        path::append(full, ""); // Because get_drive_type() requires a trailing path separator.
-                        no_matches = (os::get_drive_type(full.c_str()) < os::drive_type_removable);
-                    }
-                }
-                if (no_matches)
-                    matches = empty_matches = new matches_impl;
-            }
-        }
 
         // Never generate matches here; let it be deferred and happen on demand
         // in a coroutine.
-        if (!empty_matches && (!check_flag(flag_generate) || !g_autosuggest_async.get()))
+        if (!check_flag(flag_generate) || !g_autosuggest_async.get())
         {
-            update_matches();
+            // Suggestions must not hold up input.  Globbing a slow directory
+            // (UNC paths and network drives) uses what's cached and refreshes
+            // it in the background, instead of waiting on the network.
+            globber::nonblocking_scope nonblocking;
+            update_matches(is_generate_pending()/*progressive*/);
             matches = &m_matches;
         }
 
         assert(s_callbacks); // Was tested above inside host_can_suggest().
         s_callbacks->suggest(line, matches, m_generation_id);
-
-        delete empty_matches;
     }
 }
 
@@ -77,13 +77,15 @@ public:
     void                try_suggest();
     void                force_update_internal(bool restrict=false);
     bool                notify_matches_ready(int generation_id, matches* matches);
+    bool                notify_matches_batch(int generation_id, matches* matches);
+    void                update_matches(bool progressive);
     bool                call_lua_rl_global_function(const char* func_name);
 
 private:
     typedef editor_module                       module;
     typedef fixed_array<editor_module*, 16>     modules;
     typedef std::vector<word>                   words;
-    friend void update_matches();
+    friend void update_matches(bool progressive);
     friend matches* get_mutable_matches(bool nosort);
     friend matches* maybe_regenerate_matches(const char* needle, display_filter_flags flags);
     friend bool is_regen_blocked();
@@ -112,7 +114,7 @@ private:
     void                begin_line();
     void                end_line();
     void                collect_words();
-    commands            collect_commands();
+    const commands&     collect_commands();
     unsigned int        collect_words(words& words, matches_impl* matches, collect_words_mode mode);
     void                classify();
     void                maybe_send_oncommand_event();
@@ -124,6 +126,9 @@ private:
     void                set_flag(unsigned char flag);
     void                clear_flag(unsigned char flag);
     bool                check_flag(unsigned char flag) const;
+    bool                is_generate_pending() const;
+    bool                start_generate_pending();
+    void                restrict_pending();
 
     static bool         is_key_same(const key_t& prev_key, const char* prev_line, int prev_length,
                                     const key_t& next_key, const char* next_line, int next_length,
@@ -153,12 +158,17 @@ private:
     int                 m_generation_id = 0;
     str<64>             m_needle;
 
+    int                 m_pending_generation_id = 0;
+    unsigned int        m_pending_consumed = 0;
+    str<64>             m_pending_restrict;
+
     prev_buffer         m_prev_generate;
     words               m_words;
     unsigned short      m_command_offset = 0;
 
     prev_buffer         m_prev_classify;
     words               m_classify_words;
+    commands            m_classify_commands;
     unsigned short      m_classify_command_offset = 0;
 
     str<16>             m_prev_command_word;
@@ -406,6 +406,12 @@ bool match_adapter::has_descriptions() const
     return false;
 }
 
+//------------------------------------------------------------------------------
+bool match_adapter::is_pending() const
+{
+    return m_real_matches && m_real_matches->is_pending();
+}
+
 //------------------------------------------------------------------------------
 void match_adapter::free_filtered()
 {
@@ -39,6 +39,7 @@ public:
 
     bool            is_display_filtered() const;
     bool            has_descriptions() const;
+    bool            is_pending() const;
 
 private:
     void            free_filtered();
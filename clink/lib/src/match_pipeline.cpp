@@ -9,10 +9,12 @@
 #include "matches_impl.h"
 
 #include <core/array.h>
+#include <core/fuzzy_match.h>
 #include <core/path.h>
 #include <core/match_wild.h>
 #include <core/str_compare.h>
 #include <core/settings.h>
+#include <core/trace.h>
 #include <terminal/ecma48_iter.h>
 
 extern "C" {
@@ -32,6 +34,15 @@ static setting_enum g_sort_dirs(
     "before,with,after",
     1);
 
+setting_bool g_match_fuzzy(
+    "match.fuzzy",
+    "Fuzzy completion matching",
+    "When set, completions match if the typed characters appear in order\n"
+    "anywhere in a match, and matches are listed best first instead of\n"
+    "alphabetically.  Matches score higher when the typed characters are\n"
+    "consecutive or start words, path components, or camelCase humps.",
+    false);
+
 
 
 //------------------------------------------------------------------------------
@@ -59,7 +70,7 @@ static unsigned int pattern_selector(
     match_info* infos,
     int count)
 {
-    const int needle_len = strlen(needle);
+    const path::compiled_wild_pattern pattern(needle);
     int select_count = 0;
     for (int i = 0; i < count; ++i)
     {
@@ -69,7 +80,30 @@ static unsigned int pattern_selector(
             match_len--;
 
         const path::star_matches_everything flag = (is_pathish(infos[i].type) ? path::at_end : path::yes);
-        const bool select = path::match_wild(str_iter(needle, needle_len), str_iter(match, match_len), flag);
+        const bool select = pattern.match(match, match_len, flag);
+        infos[i].select = select;
+        if (select)
+            ++select_count;
+    }
+    return select_count;
+}
+
+//------------------------------------------------------------------------------
+static unsigned int fuzzy_selector(
+    const char* needle,
+    match_info* infos,
+    int count)
+{
+    const fuzzy_matcher matcher(needle);
+    int select_count = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const char* const match = infos[i].match;
+        int match_len = int(strlen(match));
+        while (match_len && path::is_separator((unsigned char)match[match_len - 1]))
+            match_len--;
+
+        const bool select = matcher.score(match, match_len, infos[i].score);
         infos[i].select = select;
         if (select)
             ++select_count;
@@ -176,6 +210,27 @@ static void alpha_sorter(match_info* infos, int count)
     std::sort(infos, infos + count, predicate);
 }
 
+//------------------------------------------------------------------------------
+static void score_sorter(match_info* infos, int count)
+{
+    int order = g_sort_dirs.get();
+    wstr<> ltmp;
+    wstr<> rtmp;
+
+    // Best scores first; ties fall back to the usual alphabetical order.
+    auto predicate = [&] (const match_info& lhs, const match_info& rhs) {
+        if (lhs.score != rhs.score)
+            return lhs.score > rhs.score;
+        ltmp.clear();
+        rtmp.clear();
+        to_utf16(ltmp, lhs.match);
+        to_utf16(rtmp, rhs.match);
+        return sort_worker(ltmp, lhs.type, rtmp, rhs.type, order);
+    };
+
+    std::sort(infos, infos + count, predicate);
+}
+
 //------------------------------------------------------------------------------
 static void ordinal_sorter(match_info* infos, int count)
 {
@@ -212,6 +267,8 @@ void match_pipeline::generate(
     match_generator* generator,
     bool old_filtering) const
 {
+    TRACE_SCOPE("generate matches");
+
     m_matches.set_word_break_position(state.get_end_word_offset());
 
     match_builder builder(m_matches);
@@ -289,6 +346,8 @@ void match_pipeline::restrict(str_base& needle) const
 //------------------------------------------------------------------------------
 void match_pipeline::select(const char* needle) const
 {
+    TRACE_SCOPE("select matches");
+
     const int count = m_matches.get_info_count();
 
     char* expanded = nullptr;
@@ -299,10 +358,18 @@ void match_pipeline::select(const char* needle) const
             needle = expanded;
     }
 
+    m_matches.m_scored = false;
+
     if (count)
     {
-        if (!prefix_selector(needle, m_matches.get_infos(), count) &&
-            can_try_substring_pattern(needle))
+        if (g_match_fuzzy.get())
+        {
+            // Fuzzy matching subsumes both prefix and substring matching.
+            fuzzy_selector(needle, m_matches.get_infos(), count);
+            m_matches.m_scored = (*needle != '\0');
+        }
+        else if (!prefix_selector(needle, m_matches.get_infos(), count) &&
+                 can_try_substring_pattern(needle))
         {
             char* sub = make_substring_pattern(needle, "*");
             if (sub)
@@ -336,12 +403,16 @@ void match_pipeline::sort() const
     // internal sorting.  However, Clink's Lua API allows generators to disable
     // sorting.
 
+    TRACE_SCOPE("sort matches");
+
     int count = m_matches.get_match_count();
     if (!count)
         return;
 
     if (m_matches.m_nosort)
         ordinal_sorter(m_matches.get_infos(), count); // "no sort" means "original order".
+    else if (m_matches.m_scored)
+        score_sorter(m_matches.get_infos(), count);
     else
         alpha_sorter(m_matches.get_infos(), count);
 }
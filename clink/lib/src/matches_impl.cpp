@@ -11,6 +11,7 @@
 #include <core/str.h>
 #include <core/str_compare.h>
 #include <core/str_hash.h>
+#include <core/str_intern.h>
 #include <core/str_tokeniser.h>
 #include <core/match_wild.h>
 #include <core/path.h>
@@ -55,22 +56,138 @@ extern setting_bool g_match_wild;
 
 
 //------------------------------------------------------------------------------
-struct matches_impl::match_lookup_hasher
+unsigned int match_dedup_set::hash(const char* match)
 {
-    size_t operator()(const match_lookup& info) const
+    return str_hash_words(match, strlen(match));
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::clear()
+{
+    if (m_count)
     {
-        return str_hash(info.match);
+        for (slot& s : m_slots)
+            s.index = c_empty;
+        m_count = 0;
     }
-};
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::swap(match_dedup_set& other)
+{
+    m_slots.swap(other.m_slots);
+    std::swap(m_count, other.m_count);
+}
 
 //------------------------------------------------------------------------------
-struct matches_impl::match_lookup_comparator
+bool match_dedup_set::find(const infos& entries, const match_lookup& lookup, unsigned int hash) const
 {
-    bool operator()(const match_lookup& i1, const match_lookup& i2) const
+    if (!m_count)
+        return false;
+
+    const unsigned int mask = capacity() - 1;
+    for (unsigned int i = hash & mask;; i = (i + 1) & mask)
     {
-        return (i1.type == i2.type && strcmp(i1.match, i2.match) == 0);
+        const slot& s = m_slots[i];
+        if (s.index == c_empty)
+            return false;
+        if (s.hash == hash)
+        {
+            const match_info& info = entries[s.index];
+            if (info.type == lookup.type && strcmp(info.match, lookup.match) == 0)
+                return true;
+        }
     }
-};
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::insert(unsigned int index, unsigned int hash)
+{
+    // Keep the load factor under 3/4 so probe sequences stay short.
+    if ((m_count + 1) * 4 > capacity() * 3)
+        grow();
+
+    const unsigned int mask = capacity() - 1;
+    unsigned int i = hash & mask;
+    while (m_slots[i].index != c_empty)
+        i = (i + 1) & mask;
+
+    m_slots[i].hash = hash;
+    m_slots[i].index = index;
+    ++m_count;
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::erase(unsigned int index, unsigned int hash)
+{
+    if (!m_count)
+        return;
+
+    const unsigned int mask = capacity() - 1;
+    unsigned int i = hash & mask;
+    while (m_slots[i].index != index)
+    {
+        if (m_slots[i].index == c_empty)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    // Shift later entries in the probe sequence back, so that no tombstones
+    // are needed.
+    unsigned int hole = i;
+    for (unsigned int j = (i + 1) & mask; m_slots[j].index != c_empty; j = (j + 1) & mask)
+    {
+        const unsigned int home = m_slots[j].hash & mask;
+        const unsigned int dist_hole = (hole - home) & mask;
+        const unsigned int dist_j = (j - home) & mask;
+        if (dist_hole <= dist_j)
+        {
+            m_slots[hole] = m_slots[j];
+            hole = j;
+        }
+    }
+
+    m_slots[hole].index = c_empty;
+    --m_count;
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::reserve(unsigned int count)
+{
+    unsigned int capacity = m_slots.empty() ? c_min_capacity : this->capacity();
+    while (count * 4 > capacity * 3)
+        capacity *= 2;
+    if (capacity > this->capacity())
+        rehash(capacity);
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::grow()
+{
+    rehash(m_slots.empty() ? c_min_capacity : capacity() * 2);
+}
+
+//------------------------------------------------------------------------------
+void match_dedup_set::rehash(unsigned int capacity)
+{
+    std::vector<slot> old;
+    old.swap(m_slots);
+
+    m_slots.resize(capacity, slot { 0, c_empty });
+    m_count = 0;
+
+    const unsigned int mask = capacity - 1;
+    for (const slot& s : old)
+    {
+        if (s.index == c_empty)
+            continue;
+        unsigned int i = s.hash & mask;
+        while (m_slots[i].index != c_empty)
+            i = (i + 1) & mask;
+        m_slots[i] = s;
+        ++m_count;
+    }
+}
 
 
 
@@ -254,6 +371,14 @@ bool match_builder::add_match(const match_desc& desc, bool already_normalized)
     return ((matches_impl&)m_matches).add_match(desc, already_normalized);
 }
 
+//------------------------------------------------------------------------------
+// Makes room for count more matches, so adding a known number of matches
+// doesn't repeatedly grow the match list and the duplicate detection table.
+void match_builder::reserve(unsigned int count)
+{
+    ((matches_impl&)m_matches).reserve(count);
+}
+
 //------------------------------------------------------------------------------
 bool match_builder::is_empty()
 {
@@ -363,6 +488,7 @@ matches_iter::matches_iter(const matches& matches, const char* pattern)
 //------------------------------------------------------------------------------
 matches_iter::~matches_iter()
 {
+    delete m_compiled;
     free(m_expanded_pattern);
 }
 
@@ -389,8 +515,11 @@ bool matches_iter::next()
             while (match_len && path::is_separator((unsigned char)match[match_len - 1]))
                 match_len--;
 
+            if (!m_compiled)
+                m_compiled = new path::compiled_wild_pattern(m_pattern.get_pointer(), m_pattern.length());
+
             const path::star_matches_everything flag = is_pathish(get_match_type()) ? path::at_end : path::yes;
-            if (path::match_wild(m_pattern, str_iter(match, match_len), flag))
+            if (m_compiled->match(match, match_len, flag))
                 goto found;
         }
     }
@@ -496,6 +625,8 @@ bool matches_iter::try_substring()
     free(m_expanded_pattern);
     m_expanded_pattern = pattern;
     m_pattern = str_iter(m_expanded_pattern, -1);
+    delete m_compiled;
+    m_compiled = nullptr;
     m_index = 0;
     m_next = 0;
     return true;
@@ -511,18 +642,39 @@ matches_impl::store_impl::store_impl(unsigned int size)
 
 
 
+//------------------------------------------------------------------------------
+// Completion passes tend to regenerate mostly the same matches, so match text,
+// display strings, and descriptions are shared across passes.  A reset counts
+// as a generation, and transfer() resets the source, so a pass can use several
+// generations; the grace period allows for that.
+static str_intern_pool& get_intern_pool()
+{
+    static str_intern_pool s_pool(8);
+    return s_pool;
+}
+
+
+
 //------------------------------------------------------------------------------
 matches_impl::matches_impl(unsigned int store_size)
 : m_store(min(store_size, 0x10000u))
 , m_filename_completion_desired(false)
 , m_filename_display_desired(false)
 {
+    // Ensure the pool is constructed first, so it is destroyed last.
+    get_intern_pool();
 }
 
 //------------------------------------------------------------------------------
 matches_impl::~matches_impl()
 {
-    delete m_dedup;
+    release_interned();
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::get_intern_stats(str_intern_stats& out)
+{
+    get_intern_pool().get_stats(out);
 }
 
 //------------------------------------------------------------------------------
@@ -532,9 +684,12 @@ matches_iter matches_impl::get_iter() const
 }
 
 //------------------------------------------------------------------------------
+// When match.fuzzy scored the matches, select() already filtered and ordered
+// them.  Filtering the unfiltered matches again with the wildcard pattern
+// would drop the ones that only matched fuzzily, so the pattern is ignored.
 matches_iter matches_impl::get_iter(const char* pattern) const
 {
-    return matches_iter(*this, pattern);
+    return matches_iter(*this, m_scored ? nullptr : pattern);
 }
 
 //------------------------------------------------------------------------------
@@ -780,8 +935,10 @@ bool matches_impl::match_display_filter(const char* needle, char** matches, matc
 //------------------------------------------------------------------------------
 void matches_impl::reset()
 {
-    delete m_dedup;
-    m_dedup = nullptr;
+    m_dedup.clear();
+
+    release_interned();
+    get_intern_pool().next_generation();
 
     m_store.reset();
     m_infos.clear();
@@ -793,6 +950,8 @@ void matches_impl::reset()
     m_suppress_append = false;
     m_regen_blocked = false;
     m_nosort = false;
+    m_scored = false;
+    m_pending = false;
     m_suppress_quoting = 0;
     m_word_break_position = -1;
     m_filename_completion_desired.reset();
@@ -807,6 +966,9 @@ void matches_impl::transfer(matches_impl& from)
     // Do not transfer m_generator; it is consumer configuration, not part of
     // the matches state.
 
+    release_interned();
+    m_interned.swap(from.m_interned);
+
     m_store = std::move(from.m_store);
     m_infos = std::move(from.m_infos);
     m_count = from.m_count;
@@ -817,16 +979,60 @@ void matches_impl::transfer(matches_impl& from)
     m_suppress_append = from.m_suppress_append;
     m_regen_blocked = from.m_regen_blocked;
     m_nosort = from.m_nosort;
+    m_scored = from.m_scored;
+    m_pending = false;
     m_suppress_quoting = from.m_suppress_quoting;
     m_word_break_position = from.m_word_break_position;
     m_filename_completion_desired = from.m_filename_completion_desired;
     m_filename_display_desired = from.m_filename_display_desired;
-    m_dedup = from.m_dedup;
+    m_dedup.swap(from.m_dedup);
 
-    from.m_dedup = nullptr;
     from.clear();
 }
 
+//------------------------------------------------------------------------------
+bool matches_impl::append_batch(const matches_impl& from, unsigned int& consumed)
+{
+    // Copies the matches that have been added to `from` since the previous
+    // batch.  `from` is still being built by a background generator, so it is
+    // left untouched; its final state replaces this one later via transfer().
+
+    const unsigned int count = static_cast<unsigned int>(from.m_infos.size());
+    if (consumed >= count)
+        return false;
+
+    // Previous batches may have been selected and sorted; make all of the
+    // infos available again so the new ones can be added and reselected.
+    if (m_coalesced)
+    {
+        // Selecting and sorting reorders the infos, so reindex them.
+        m_dedup.clear();
+        for (unsigned int i = 0, n = static_cast<unsigned int>(m_infos.size()); i < n; ++i)
+            m_dedup.insert(i, match_dedup_set::hash(m_infos[i].match));
+    }
+
+    m_count = static_cast<unsigned int>(m_infos.size());
+    m_coalesced = false;
+
+    for (; consumed < count; ++consumed)
+    {
+        const match_info& info = from.m_infos[consumed];
+        match_desc desc(info.match, info.display, info.description, info.type);
+        desc.append_char = info.append_char;
+        desc.suppress_append = info.suppress_append;
+        desc.append_display = info.append_display;
+        add_match(desc, true/*already_normalised*/);
+    }
+
+    m_append_character = from.m_append_character;
+    m_suppress_append = from.m_suppress_append;
+    m_nosort = from.m_nosort;
+    m_suppress_quoting = from.m_suppress_quoting;
+    m_filename_completion_desired = from.m_filename_completion_desired;
+    m_filename_display_desired = from.m_filename_display_desired;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::clear()
 {
@@ -939,10 +1145,8 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
         match = tmp.c_str();
     }
 
-    if (!m_dedup)
-        m_dedup = new match_lookup_unordered_set;
-
-    if (m_dedup->find({ match, type }) != m_dedup->end())
+    const unsigned int hash = match_dedup_set::hash(match);
+    if (m_dedup.find(m_infos, { match, type }, hash))
         return false;
 
     if (is_none)
@@ -953,7 +1157,9 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
         match = tmp.c_str();
     }
 
-    const char* store_match = m_store.store_front(match);
+    // Matches that may need a path separator appended later are modified in
+    // place, so they can't be shared.
+    const char* store_match = is_none ? m_store.store_front(match) : intern(match);
     if (!store_match)
         return false;
 
@@ -967,21 +1173,51 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
         m_any_infer_type = true;
     }
 
-    const char* store_display = (desc.display && *desc.display) ? m_store.store_front(desc.display) : nullptr;
-    const char* store_description = (desc.description && *desc.description) ? m_store.store_front(desc.description) : nullptr;
+    const char* store_display = (desc.display && *desc.display) ? intern(desc.display) : nullptr;
+    const char* store_description = (desc.description && *desc.description) ? intern(desc.description) : nullptr;
     bool append_display = (desc.append_display && store_display);
 
-    match_lookup lookup = { store_match, type };
-    m_dedup->emplace(std::move(lookup));
-
     unsigned int ordinal = static_cast<unsigned int>(m_infos.size());
-    match_info info = { store_match, store_display, store_description, ordinal, type, desc.append_char, desc.suppress_append, append_display, false/*select*/, is_none/*infer_type*/ };
+    m_dedup.insert(ordinal, hash);
+
+    match_info info = { store_match, store_display, store_description, ordinal, 0/*score*/, type, desc.append_char, desc.suppress_append, append_display, false/*select*/, is_none/*infer_type*/ };
     m_infos.emplace_back(std::move(info));
     ++m_count;
 
     return true;
 }
 
+//------------------------------------------------------------------------------
+const char* matches_impl::intern(const char* str)
+{
+    const char* interned = get_intern_pool().acquire(str);
+    if (interned)
+        m_interned.push_back(interned);
+    return interned;
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::release_interned()
+{
+    if (m_interned.empty())
+        return;
+
+    get_intern_pool().release(m_interned.data(), unsigned(m_interned.size()));
+    m_interned.clear();
+}
+
+//------------------------------------------------------------------------------
+void matches_impl::reserve(unsigned int count)
+{
+    if (m_coalesced)
+        return;
+
+    const unsigned int total = unsigned(m_infos.size()) + count;
+    m_infos.reserve(total);
+    m_interned.reserve(m_interned.size() + count);
+    m_dedup.reserve(total);
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::set_generator(match_generator* generator)
 {
@@ -1003,36 +1239,40 @@ void matches_impl::done_building()
         else if (s_slash_translation == 3)
             sep = '\\';
 
+        // The dedup set refers to infos by index, so duplicates are removed
+        // after the loop.  The loop runs backwards, so they're in descending
+        // order.
+        std::vector<unsigned int> dups;
+
         for (unsigned int i = m_count; i--;)
         {
-            if (m_infos[i].infer_type)
+            match_info& info = m_infos[i];
+            if (info.infer_type)
             {
                 // If matches are relative, but not relative to the current
                 // directory, then get_path_type() might yield unexpected
                 // results.  But that will interfere with many things, so no
                 // effort is invested here to compensate.
-                match_lookup lookup = { m_infos[i].match, m_infos[i].type };
-                switch (os::get_path_type(m_infos[i].match))
+                switch (os::get_path_type(info.match))
                 {
                 case os::path_type_dir:
                     {
                         // Remove it from the dup map before modifying it.
-                        m_dedup->erase(lookup);
+                        m_dedup.erase(i, match_dedup_set::hash(info.match));
                         // It's a directory, so update the type and add a
                         // trailing path separator.
-                        const size_t len = strlen(m_infos[i].match);
-                        const_cast<char*>(m_infos[i].match)[len] = sep;
-                        m_infos[i].type |= match_type::dir;
-                        assert(m_infos[i].match[len + 1] == '\0');
+                        const size_t len = strlen(info.match);
+                        const_cast<char*>(info.match)[len] = sep;
+                        info.type |= match_type::dir;
+                        assert(info.match[len + 1] == '\0');
                     }
                     break;
                 case os::path_type_file:
                     {
                         // Remove it from the dup map before modifying it.
-                        m_dedup->erase(lookup);
+                        m_dedup.erase(i, match_dedup_set::hash(info.match));
                         // It's a file, so update the type.
-                        lookup.type |= match_type::file;
-                        m_infos[i].type |= lookup.type;
+                        info.type |= match_type::file;
                     }
                     break;
                 default:
@@ -1040,16 +1280,19 @@ void matches_impl::done_building()
                 }
 
                 // Check if it has become a duplicate.
-                if (m_dedup->find(lookup) != m_dedup->end())
-                    m_infos.erase(m_infos.begin() + i);
+                const unsigned int hash = match_dedup_set::hash(info.match);
+                if (m_dedup.find(m_infos, { info.match, info.type }, hash))
+                    dups.push_back(i);
                 else
-                    m_dedup->emplace(std::move(lookup));
+                    m_dedup.insert(i, hash);
             }
         }
+
+        for (unsigned int i : dups)
+            m_infos.erase(m_infos.begin() + i);
     }
 
-    delete m_dedup;
-    m_dedup = nullptr;
+    m_dedup.clear();
 }
 
 //------------------------------------------------------------------------------
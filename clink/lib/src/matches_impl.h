@@ -6,8 +6,9 @@
 #include "matches.h"
 
 #include "core/array.h"
+#include "core/base.h"
 #include "core/linear_allocator.h"
-#include <unordered_set>
+#include "core/str_intern.h"
 #include <vector>
 
 //------------------------------------------------------------------------------
@@ -17,6 +18,7 @@ struct match_info
     const char*     display;
     const char*     description;
     unsigned        ordinal;            // Original unsorted order.
+    int             score;              // Fuzzy match score, when match.fuzzy is set.
     match_type      type;
     char            append_char;        // Zero means not specified.
     char            suppress_append;    // Negative means not specified.
@@ -44,6 +46,42 @@ protected:
 
 
 
+//------------------------------------------------------------------------------
+// Flat open addressing set of indices into a vector of match_info, used to
+// detect duplicate matches while building.  Slots cache each entry's hash, so
+// probing rarely needs to touch the match strings.  Clearing keeps the slot
+// table, so that it's reused by the next generation.
+class match_dedup_set : public no_copy
+{
+public:
+    typedef std::vector<match_info> infos;
+
+    static unsigned int     hash(const char* match);
+    void                    clear();
+    void                    swap(match_dedup_set& other);
+    bool                    find(const infos& entries, const match_lookup& lookup, unsigned int hash) const;
+    void                    insert(unsigned int index, unsigned int hash);
+    void                    erase(unsigned int index, unsigned int hash);
+    void                    reserve(unsigned int count);
+    unsigned int            size() const { return m_count; }
+    unsigned int            capacity() const { return unsigned(m_slots.size()); }
+
+private:
+    struct slot
+    {
+        unsigned int        hash;
+        unsigned int        index;          // c_empty means the slot is empty.
+    };
+
+    static const unsigned int c_empty = ~0u;
+    static const unsigned int c_min_capacity = 256;
+
+    void                    grow();
+    void                    rehash(unsigned int capacity);
+    std::vector<slot>       m_slots;
+    unsigned int            m_count = 0;
+};
+
 //------------------------------------------------------------------------------
 class match_generator;
 
@@ -51,12 +89,7 @@ class match_generator;
 class matches_impl
     : DBGOBJECT_ public matches
 {
-    struct match_lookup_hasher;
-    struct match_lookup_comparator;
-
 public:
-    typedef std::unordered_set<match_lookup, match_lookup_hasher, match_lookup_comparator> match_lookup_unordered_set;
-
                             matches_impl(unsigned int store_size=0x10000);
                             ~matches_impl();
     matches_iter            get_iter() const;
@@ -78,6 +111,7 @@ public:
     virtual char            get_append_character() const override;
     virtual int             get_suppress_quoting() const override;
     virtual int             get_word_break_position() const override;
+    virtual bool            is_pending() const override { return m_pending; }
     virtual bool            match_display_filter(const char* needle, char** matches, match_display_filter_entry*** filtered_matches, display_filter_flags flags, bool* old_filtering=nullptr) const override;
 
     void                    set_word_break_position(int position);
@@ -88,8 +122,12 @@ public:
     void                    done_building();
 
     void                    transfer(matches_impl& from);
+    bool                    append_batch(const matches_impl& from, unsigned int& consumed);
+    void                    set_pending(bool pending) { m_pending = pending; }
     void                    clear();
 
+    static void             get_intern_stats(str_intern_stats& out);
+
 private:
     virtual const char*     get_unfiltered_match(unsigned int index) const override;
     virtual match_type      get_unfiltered_match_type(unsigned int index) const override;
@@ -109,11 +147,14 @@ private:
     void                    set_matches_are_files(bool files);
     void                    set_no_sort();
     bool                    add_match(const match_desc& desc, bool already_normalised=false);
+    void                    reserve(unsigned int count);
     unsigned int            get_info_count() const;
     const match_info*       get_infos() const;
     match_info*             get_infos();
     void                    reset();
     void                    coalesce(unsigned int count_hint, bool restrict=false);
+    const char*             intern(const char* str);
+    void                    release_interned();
 
 private:
     class store_impl : public linear_allocator
@@ -127,9 +168,10 @@ private:
 
     match_generator*        m_generator = nullptr;
 
-    store_impl              m_store;
+    store_impl              m_store;        // Only for strings that get modified.
+    std::vector<const char*> m_interned;
     infos                   m_infos;
-    unsigned short          m_count = 0;
+    unsigned int            m_count = 0;
     bool                    m_any_infer_type = false;
     bool                    m_can_infer_type = true;
     bool                    m_coalesced = false;
@@ -137,12 +179,14 @@ private:
     bool                    m_suppress_append = false;
     bool                    m_regen_blocked = false;
     bool                    m_nosort = false;
+    bool                    m_scored = false;
+    bool                    m_pending = false;
     int                     m_suppress_quoting = 0;
     int                     m_word_break_position = -1;
     shadow_bool             m_filename_completion_desired;
     shadow_bool             m_filename_display_desired;
 
-    match_lookup_unordered_set* m_dedup = nullptr;
+    match_dedup_set         m_dedup;
 };
 
 //------------------------------------------------------------------------------
@@ -33,12 +33,16 @@ class matches_lookaside
     typedef std::unordered_map<UINT_PTR, match_extra*> match_extra_map;
 public:
                             matches_lookaside(char** matches);
+                            matches_lookaside(char** matches, char* block, size_t size);
                             ~matches_lookaside();
     bool                    associated(char** matches) const;
+    bool                    owns(const char* match) const;
     const match_extra*      find(const char* match) const;
 private:
     bool                    add(const char* match);
     char**                  m_matches;
+    char*                   m_block = nullptr;
+    size_t                  m_block_size = 0;
     match_extra_map         m_map;
     linear_allocator        m_allocator;
 };
@@ -56,9 +60,23 @@ matches_lookaside::matches_lookaside(char** matches)
         while (add(*(++matches))) {}
 };
 
+//------------------------------------------------------------------------------
+// Takes ownership of block, which holds the matches packed by
+// packed_matches_builder.
+matches_lookaside::matches_lookaside(char** matches, char* block, size_t size)
+: m_matches(matches)
+, m_block(block)
+, m_block_size(size)
+, m_allocator(8192)
+{
+    assert(matches);
+    assert(block);
+}
+
 //------------------------------------------------------------------------------
 matches_lookaside::~matches_lookaside()
 {
+    free(m_block);
 }
 
 //------------------------------------------------------------------------------
@@ -67,9 +85,21 @@ bool matches_lookaside::associated(char** matches) const
     return matches == m_matches;
 }
 
+//------------------------------------------------------------------------------
+bool matches_lookaside::owns(const char* match) const
+{
+    return match >= m_block && match < m_block + m_block_size;
+}
+
 //------------------------------------------------------------------------------
 const match_extra* matches_lookaside::find(const char* match) const
 {
+    if (owns(match))
+        return reinterpret_cast<const match_extra*>(match) - 1;
+
+    if (m_map.empty())
+        return nullptr;
+
     auto const iter = m_map.find(reinterpret_cast<UINT_PTR>(match));
     if (iter == m_map.end())
         return nullptr;
@@ -100,6 +130,148 @@ bool matches_lookaside::add(const char* match)
 
 
 
+//------------------------------------------------------------------------------
+packed_matches_builder::packed_matches_builder(unsigned int count_hint)
+{
+    m_offsets.reserve(count_hint);
+
+    // Guess an average of 64 bytes per match; add() grows the block as needed.
+    if (count_hint)
+    {
+        m_block = static_cast<char*>(malloc(count_hint * 64));
+        m_size = m_block ? count_hint * 64 : 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+packed_matches_builder::~packed_matches_builder()
+{
+    free(m_block);
+}
+
+//------------------------------------------------------------------------------
+bool packed_matches_builder::add(const char* match, match_type type, char append_char, unsigned char flags, const char* display, const char* description)
+{
+    // PACKED MATCH FORMAT is:
+    //  - N bytes:  MATCH (nul terminated char string)
+    //  - 1 byte:   TYPE (unsigned char)
+    //  - 1 byte:   APPEND CHAR (char)
+    //  - 1 byte:   FLAGS (unsigned char)
+    //  - N bytes:  DISPLAY (nul terminated char string)
+    //  - N bytes:  DESCRIPTION (nul terminated char string)
+    //
+    // WARNING:  Several things rely on this memory layout, including
+    // display_match_list_internal, matches_lookaside, and
+    // match_display_filter.
+    //
+    // Each packed match is preceded by its match_extra, which lets
+    // lookup_match() find it without a hash lookup.
+
+    const size_t match_len = strlen(match);
+    const size_t display_len = display ? strlen(display) : 0;
+    const size_t description_len = description ? strlen(description) : 0;
+    const size_t display_offset = match_len + 1 + 1/*type*/ + 1/*append_char*/ + 1/*flags*/;
+    const size_t description_offset = display_offset + display_len + 1;
+    const size_t packed_size = description_offset + description_len + 1;
+
+    const size_t offset = (m_used + alignof(match_extra) - 1) & ~(alignof(match_extra) - 1);
+    const size_t needed = offset + sizeof(match_extra) + packed_size;
+    if (needed > m_size)
+    {
+        size_t new_size = m_size ? m_size : 4096;
+        while (new_size < needed)
+            new_size <<= 1;
+        char* block = static_cast<char*>(realloc(m_block, new_size));
+        if (!block)
+            return false;
+        m_block = block;
+        m_size = new_size;
+    }
+
+    match_extra* extra = reinterpret_cast<match_extra*>(m_block + offset);
+    extra->display_offset = static_cast<unsigned short>(display_offset);
+    extra->description_offset = static_cast<unsigned short>(description_offset);
+    extra->type = type;
+    extra->append_char = append_char;
+    extra->flags = flags;
+
+    char* ptr = reinterpret_cast<char*>(extra + 1);
+
+    memcpy(ptr, match, match_len);
+    ptr += match_len;
+    *(ptr++) = '\0';
+
+    *(ptr++) = (char)type;
+    *(ptr++) = append_char;
+    *(ptr++) = (char)flags;
+
+    memcpy(ptr, display, display_len);
+    ptr += display_len;
+    *(ptr++) = '\0';
+
+    memcpy(ptr, description, description_len);
+    ptr += description_len;
+    *(ptr++) = '\0';
+
+    m_offsets.push_back(offset + sizeof(match_extra));
+    m_used = needed;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Returns a match list with a copy of lcd in [0] (or nullptr if lcd is
+// nullptr), followed by the packed matches, and creates its lookaside table.
+char** packed_matches_builder::finish(const char* lcd, int lcd_len)
+{
+    const unsigned int count = get_count();
+    char** matches = static_cast<char**>(malloc((count + 2) * sizeof(*matches)));
+    if (!matches)
+        return nullptr;
+
+    matches[0] = nullptr;
+    if (lcd)
+    {
+        matches[0] = static_cast<char*>(malloc(lcd_len + 1));
+        if (!matches[0])
+        {
+            free(matches);
+            return nullptr;
+        }
+        memcpy(matches[0], lcd, lcd_len);
+        matches[0][lcd_len] = '\0';
+    }
+
+    if (!count)
+    {
+        matches[1] = nullptr;
+        return matches;
+    }
+
+    // Give back the unused part of the block before taking pointers into it.
+    if (m_used < m_size)
+    {
+        if (char* block = static_cast<char*>(realloc(m_block, m_used)))
+            m_block = block;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+        matches[i + 1] = m_block + m_offsets[i];
+    matches[count + 1] = nullptr;
+
+#ifdef DEBUG
+    assert(s_lookasides.size() <= 5);
+#endif
+
+    s_lookasides.push_front(new matches_lookaside(matches, m_block, m_used));
+    m_block = nullptr;
+    m_used = 0;
+    m_size = 0;
+    m_offsets.clear();
+    return matches;
+}
+
+
+
 //------------------------------------------------------------------------------
 static const char* s_match = nullptr;
 static match_extra s_extra = {};
@@ -161,6 +333,15 @@ int destroy_matches_lookaside(char** matches)
     return false;
 }
 
+//------------------------------------------------------------------------------
+bool is_packed_match(const char* match)
+{
+    for (auto iter : s_lookasides)
+        if (iter->owns(match))
+            return true;
+    return false;
+}
+
 //------------------------------------------------------------------------------
 void set_matches_lookaside_oneoff(const char* match, match_type type, char append_char, unsigned char flags)
 {
@@ -198,6 +379,14 @@ extern "C" void override_match_append(const char* match)
         rl_filename_completion_desired = !!is_pathish(details.get_type());
 }
 
+//------------------------------------------------------------------------------
+extern "C" void free_match_hook(char* match)
+{
+    // Packed matches belong to the lookaside table of their match list.
+    if (!is_packed_match(match))
+        free(match);
+}
+
 //------------------------------------------------------------------------------
 extern "C" unsigned char lookup_match_flags(const char* match)
 {
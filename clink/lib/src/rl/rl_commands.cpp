@@ -14,9 +14,12 @@
 #include "rl_suggestions.h"
 
 #include <core/base.h>
+#include <core/dir_cache.h>
+#include <core/linear_allocator.h>
 #include <core/log.h>
 #include <core/path.h>
 #include <core/settings.h>
+#include <core/trace.h>
 #include <terminal/printer.h>
 #include <terminal/scroll.h>
 #include <terminal/screen_buffer.h>
@@ -2018,6 +2021,65 @@ int clink_diagnostics(int count, int invoking_key)
         g_printer->print(s.c_str(), s.length());
     }
 
+    // Directory cache info.
+
+    {
+        dir_cache_stats stats;
+        dir_cache::get_stats(stats);
+
+        s.clear();
+        s << bold << "directory cache:" << norm << lf;
+        g_printer->print(s.c_str(), s.length());
+
+        const unsigned int lookups = stats.hits + stats.misses;
+        s.clear();
+        s.format("  %-*s  %u hits, %u misses (%u%% hit rate)\n", spacing, "lookups",
+                 stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0);
+        g_printer->print(s.c_str(), s.length());
+
+        s.clear();
+        s.format("  %-*s  %u directories, %u entries\n", spacing, "cached",
+                 stats.snapshots, stats.entries);
+        g_printer->print(s.c_str(), s.length());
+
+        if (rl_explicit_arg)
+        {
+            s.clear();
+            s.format("  %-*s  %u stale, %u evicted, %u bypassed\n", spacing, "refreshes",
+                     stats.stale, stats.evictions, stats.uncacheable);
+            g_printer->print(s.c_str(), s.length());
+
+            s.clear();
+            s.format("  %-*s  %u loaded in background, %u abandoned\n", spacing, "slow dirs",
+                     stats.background, stats.abandoned);
+            g_printer->print(s.c_str(), s.length());
+        }
+    }
+
+    // Page pool info.
+
+    {
+        linear_allocator_stats stats;
+        linear_allocator::get_pool_stats(stats);
+
+        s.clear();
+        s << bold << "page pool:" << norm << lf;
+        g_printer->print(s.c_str(), s.length());
+
+        s.clear();
+        s.format("  %-*s  %u pages, %u KB\n", spacing, "pooled",
+                 stats.pooled_pages, unsigned(stats.pooled_bytes / 1024));
+        g_printer->print(s.c_str(), s.length());
+
+        if (rl_explicit_arg)
+        {
+            s.clear();
+            s.format("  %-*s  %u reused, %u allocated, %u freed, %u oversized\n", spacing, "pages",
+                     stats.reuses, stats.allocs, stats.frees, stats.oversized);
+            g_printer->print(s.c_str(), s.length());
+        }
+    }
+
     // Terminal info.
 
     if (rl_explicit_arg)
@@ -2048,6 +2110,39 @@ int clink_diagnostics(int count, int invoking_key)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+int clink_dump_trace(int count, int invoking_key)
+{
+    end_prompt(true/*crlf*/);
+
+    str<> s;
+    if (!trace::is_enabled())
+    {
+        s = "Tracing is off; turn on the 'debug.trace' setting to record timings.\n";
+    }
+    else
+    {
+        int id = 0;
+        str<> binaries;
+        str<> profile;
+        str<> scripts;
+        host_get_app_context(id, binaries, profile, scripts);
+
+        str<> name;
+        name.format("clink_trace_%d.json", id);
+        path::append(profile, name.c_str());
+
+        if (trace::dump(profile.c_str()))
+            s.format("Trace written to '%s'.\n", profile.c_str());
+        else
+            s.format("Unable to write trace to '%s'.\n", profile.c_str());
+    }
+    g_printer->print(s.c_str(), s.length());
+
+    rl_forced_update_display();
+    return 0;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -136,3 +136,4 @@ int     magic_space(int count, int invoking_key);
 
 //------------------------------------------------------------------------------
 int     clink_diagnostics(int count, int invoking_key);
+int     clink_dump_trace(int count, int invoking_key);
@@ -26,6 +26,7 @@
 #include <core/settings.h>
 #include <core/log.h>
 #include <core/debugheap.h>
+#include <core/trace.h>
 #include <terminal/ecma48_iter.h>
 #include <terminal/printer.h>
 #include <terminal/terminal_in.h>
@@ -90,7 +91,7 @@ extern int host_remove_history(int rl_history_index, const char* line);
 extern void host_send_event(const char* event_name);
 extern int macro_hook_func(const char* macro);
 extern int host_filter_matches(char** matches);
-extern void update_matches();
+extern void update_matches(bool progressive=false);
 extern void reset_generate_matches();
 extern void force_update_internal(bool restrict);
 extern matches* maybe_regenerate_matches(const char* needle, display_filter_flags flags);
@@ -908,6 +909,8 @@ void hook_display()
         return;
     rollback<bool> rb(s_busy, true);
 
+    TRACE_SCOPE("display");
+
     if (!s_suggestion.more() || rl_point != rl_end)
     {
         rl_redisplay();
@@ -1138,30 +1141,6 @@ static char* filename_menu_completion_function(const char *text, int state)
     return nullptr;
 }
 
-//------------------------------------------------------------------------------
-static bool ensure_matches_size(char**& matches, int count, int& reserved)
-{
-    count += 2;
-    if (count > reserved)
-    {
-        int new_reserve = 64;
-        while (new_reserve < count)
-        {
-            int prev = new_reserve;
-            new_reserve <<= 1;
-            if (new_reserve < prev)
-                return false;
-        }
-        char **new_matches = (char **)realloc(matches, new_reserve * sizeof(matches[0]));
-        if (!new_matches)
-            return false;
-
-        matches = new_matches;
-        reserved = new_reserve;
-    }
-    return true;
-}
-
 //------------------------------------------------------------------------------
 static void buffer_changing()
 {
@@ -1281,40 +1260,13 @@ static char** alternative_matches(const char* text, int start, int end)
         end_prefix = (char*)text + 2;
     int len_prefix = end_prefix ? end_prefix - text : 0;
 
-    // Deep copy of the generated matches.  Inefficient, but this is how
-    // readline wants them.
-    str<32> lcd;
-    int count = 0;
-    int reserved = 0;
-    char** matches = nullptr;
-    if (!ensure_matches_size(matches, s_matches->get_match_count(), reserved))
-        return nullptr;
-    matches[0] = (char*)malloc((end - start) + 1);
-    memcpy(matches[0], text, end - start);
-    matches[0][(end - start)] = '\0';
+    // Pack the generated matches into one block, since Readline wants char**
+    // and the PACKED MATCH FORMAT; see packed_matches_builder.
+    packed_matches_builder builder(s_matches->get_match_count());
     do
     {
         match_type type = iter.get_match_type();
 
-        ++count;
-        if (!ensure_matches_size(matches, count, reserved))
-        {
-            --count;
-            break;
-        }
-
-        // PACKED MATCH FORMAT is:
-        //  - N bytes:  MATCH (nul terminated char string)
-        //  - 1 byte:   TYPE (unsigned char)
-        //  - 1 byte:   APPEND CHAR (char)
-        //  - 1 byte:   FLAGS (unsigned char)
-        //  - N bytes:  DISPLAY (nul terminated char string)
-        //  - N bytes:  DESCRIPTION (nul terminated char string)
-        //
-        // WARNING:  Several things rely on this memory layout, including
-        // display_match_list_internal, matches_lookaside, and
-        // match_display_filter.
-
         unsigned char flags = 0;
         if (iter.get_match_append_display())
             flags |= MATCH_FLAG_APPEND_DISPLAY;
@@ -1328,42 +1280,27 @@ static char** alternative_matches(const char* text, int start, int end)
         }
 
         const char* const match = iter.get_match();
-        const char* const display = iter.get_match_display();
-        const char* const description = iter.get_match_description();
-        const int match_len = strlen(match);
-        const int match_display_len = display ? strlen(display) : 0;
-        const int match_description_len = description ? strlen(description) : 0;
-        const int match_size = match_len + 1 + 1/*type*/ + 1/*append_char*/ + 1/*flags*/ + match_display_len + 1 + match_description_len + 1;
-        char* ptr = (char*)malloc(match_size);
-
-        matches[count] = ptr;
-
-        memcpy(ptr, match, match_len);
-        ptr += match_len;
-        *(ptr++) = '\0';
-
-        *(ptr++) = (char)type;
-        *(ptr++) = (char)iter.get_match_append_char();
-        *(ptr++) = (char)flags;
-
-        memcpy(ptr, display, match_display_len);
-        ptr += match_display_len;
-        *(ptr++) = '\0';
-
-        memcpy(ptr, description, match_description_len);
-        ptr += match_description_len;
-        *(ptr++) = '\0';
+        if (!builder.add(match, type, iter.get_match_append_char(), flags,
+                         iter.get_match_display(), iter.get_match_description()))
+            break;
 
 #ifdef DEBUG
         // Set DEBUG_MATCHES=-5 to print the first 5 matches.
-        if (debug_matches > 0 || (debug_matches < 0 && count - 1 < 0 - debug_matches))
-            printf("%u: %s, %02.2x => %s\n", count - 1, match, type, matches[count]);
+        const int index = builder.get_count() - 1;
+        if (debug_matches > 0 || (debug_matches < 0 && index < 0 - debug_matches))
+            printf("%u: %s, %02.2x\n", index, match, type);
 #endif
     }
     while (iter.next());
-    matches[count + 1] = nullptr;
 
-    create_matches_lookaside(matches);
+    const int count = builder.get_count();
+    if (!count)
+        return nullptr;
+
+    char** matches = builder.finish(text, end - start);
+    if (!matches)
+        return nullptr;
+
     update_rl_modes_from_matches(s_matches, iter, count);
 
     return matches;
@@ -1713,6 +1650,7 @@ static void init_readline_hooks()
     rl_lookup_match_type = lookup_match_type;
     rl_override_match_append = override_match_append;
     rl_free_match_list_hook = free_match_list_hook;
+    rl_free_match_hook = free_match_hook;
     rl_ignore_some_completions_function = host_filter_matches;
     rl_attempted_completion_function = alternative_matches;
     rl_menu_completion_entry_function = filename_menu_completion_function;
@@ -1835,6 +1773,7 @@ void initialise_readline(const char* shell_name, const char* state_dir, const ch
         clink_add_funmap_entry("magic-space", magic_space, keycat_history, "Perform history expansion on the text before the cursor position and insert a space");
 
         clink_add_funmap_entry("clink-diagnostics", clink_diagnostics, keycat_misc, "Show internal diagnostic information");
+        clink_add_funmap_entry("clink-dump-trace", clink_dump_trace, keycat_misc, "Write recorded timings to a trace file (see the 'debug.trace' setting)");
 
         // Alias some command names for convenient compatibility with bash .inputrc configuration entries.
         rl_add_funmap_entry("alias-expand-line", clink_expand_doskey_alias);
@@ -42,7 +42,7 @@ extern void reset_generate_matches();
 extern bool is_regen_blocked();
 extern matches* maybe_regenerate_matches(const char* needle, display_filter_flags flags);
 extern void force_update_internal(bool restrict=false);
-extern void update_matches();
+extern void update_matches(bool progressive=false);
 extern void update_rl_modes_from_matches(const matches* matches, const matches_iter& iter, int count);
 extern void override_rl_last_func(rl_command_func_t* func, bool force_when_null=false);
 
@@ -74,6 +74,16 @@ static setting_color g_color_comment_row(
     "shows the \"and N more matches\" or \"rows X to Y of Z\" messages.",
     "bright white on cyan");
 
+setting_bool g_match_progressive(
+    "match.progressive",
+    "Show matches as they arrive",
+    "When enabled, 'clink-select-complete' generates matches in the background\n"
+    "and shows them as they arrive, with a note that more are still loading.\n"
+    "This keeps slow match generators (for example on network shares) from\n"
+    "blocking the display.  The 'complete' and 'menu-complete' commands still\n"
+    "wait for all matches.",
+    false);
+
 setting_bool g_match_best_fit(
     "match.fit_columns",
     "Fits match columns to screen width",
@@ -221,7 +231,10 @@ bail_out:
         return false;
     }
 
-    if (!m_matches.get_match_count())
+    // While matches are still loading there may not be any yet, but activate
+    // anyway so that they can be shown when they arrive.
+    const bool pending = m_matches.is_pending();
+    if (!m_matches.get_match_count() && !pending)
     {
 cant_activate:
         m_anchor = -1;
@@ -258,6 +271,7 @@ cant_activate:
     // there are too many matches.
     if (!m_expanded &&
         m_can_prompt &&
+        !pending &&
         (rl_completion_auto_query_items ?
             (m_match_rows > m_visible_rows) :
             (rl_completion_query_items > 0 && m_matches.get_match_count() >= rl_completion_query_items)))
@@ -312,10 +326,11 @@ cant_activate:
     m_was_backspace = false;
 
     // Insert first match.
-    bool only_one = (m_matches.get_match_count() == 1);
+    bool only_one = (m_matches.get_match_count() == 1 && !pending);
     m_point = m_buffer->get_cursor();
     reset_top();
-    insert_match(only_one/*final*/);
+    if (m_matches.get_match_count())
+        insert_match(only_one/*final*/);
 
     // If there's only one match, then we're done.
     if (only_one)
@@ -448,12 +463,14 @@ revert:
         return;
     }
 
-    // Cancel if no matches (which shouldn't be able to happen here).
+    // Cancel if no matches.  That can only happen if it was activated while
+    // matches were still loading; stop waiting and let the input be handled
+    // normally.
     int count = m_matches.get_match_count();
     if (!count)
     {
-        assert(count);
-        cancel(result);
+        cancel(result, true/*can_reactivate*/);
+        result.pass();
         return;
     }
 
@@ -986,21 +1003,10 @@ void selectcomplete_impl::update_matches(bool restrict)
     }
 
     // Update matches.
-    ::update_matches();
+    ::update_matches(true/*progressive*/);
 
     if (restrict)
-    {
-        // Update Readline modes based on the available completions.
-        {
-            matches_iter iter = m_matches.get_iter();
-            while (iter.next())
-                ;
-            update_rl_modes_from_matches(m_matches.get_matches(), iter, m_matches.get_match_count());
-        }
-
-        // Initialize whether descriptions are available.
-        m_matches.init_has_descriptions();
-    }
+        update_rl_modes();
 
     // Perform match display filtering.
     const display_filter_flags flags = display_filter_flags::selectable;
@@ -1011,25 +1017,30 @@ void selectcomplete_impl::update_matches(bool restrict)
         {
             m_matches.set_regen_matches(regen);
 
-            // Build char** array for filtering.
-            std::vector<autoptr<char>> matches;
+            // Build char** array for filtering.  The lcd is not needed.
             const unsigned int count = m_matches.get_match_count();
-            matches.emplace_back(nullptr); // Placeholder for lcd.
+            packed_matches_builder builder(count);
             for (unsigned int i = 0; i < count; i++)
             {
-                const char* text = m_matches.get_match(i);
-                const size_t len = strlen(text);
-                char* match = static_cast<char*>(malloc(len + 1));
-                memcpy(match, text, len + 1);
-                matches.emplace_back(match);
+                if (!builder.add(m_matches.get_match(i),
+                                 m_matches.get_match_type(i),
+                                 m_matches.get_match_append_char(i),
+                                 m_matches.get_match_flags(i),
+                                 m_matches.get_match_display(i),
+                                 m_matches.get_match_description(i)))
+                    break;
             }
-            matches.emplace_back(nullptr);
+            char** matches = builder.finish(nullptr, 0);
 
             // Get filtered matches.
             match_display_filter_entry** filtered_matches = nullptr;
-            create_matches_lookaside(&*matches.begin());
-            m_matches.get_matches()->match_display_filter(m_needle.c_str(), &*matches.begin(), &filtered_matches, flags);
-            destroy_matches_lookaside(&*matches.begin());
+            if (matches)
+            {
+                m_matches.get_matches()->match_display_filter(m_needle.c_str(), matches, &filtered_matches, flags);
+                if (matches[1])
+                    destroy_matches_lookaside(matches);
+                free(matches);
+            }
 
             // Use filtered matches.
             m_matches.set_filtered_matches(filtered_matches);
@@ -1099,6 +1110,61 @@ void selectcomplete_impl::update_matches(bool restrict)
     m_calc_widths = true;
 }
 
+//------------------------------------------------------------------------------
+void selectcomplete_impl::update_rl_modes()
+{
+    // Update Readline modes based on the available completions.
+    {
+        matches_iter iter = m_matches.get_iter();
+        while (iter.next())
+            ;
+        update_rl_modes_from_matches(m_matches.get_matches(), iter, m_matches.get_match_count());
+    }
+
+    // Initialize whether descriptions are available.
+    m_matches.init_has_descriptions();
+}
+
+//------------------------------------------------------------------------------
+void selectcomplete_impl::refresh_matches()
+{
+    // More matches have arrived from a background generator (or the final
+    // set has arrived), so filter them and update the display.
+
+    if (!is_active())
+        return;
+
+    // Try to keep the same match selected.
+    str<> selected;
+    if (m_index >= 0 && m_index < int(m_matches.get_match_count()))
+        selected = m_matches.get_match(m_index);
+
+    insert_needle();
+    update_matches(false/*restrict*/);
+    update_rl_modes();
+
+    const int count = m_matches.get_match_count();
+    if (selected.length())
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (strcmp(m_matches.get_match(i), selected.c_str()) == 0)
+            {
+                m_index = i;
+                break;
+            }
+        }
+    }
+
+    m_calc_widths = true;
+    m_prev_displayed = -1;
+    m_comment_row_displayed = false;
+    update_layout();
+    if (count)
+        insert_match();
+    update_display();
+}
+
 //------------------------------------------------------------------------------
 void selectcomplete_impl::update_len()
 {
@@ -1133,7 +1199,8 @@ force_desc_below:
         }
     }
 
-    if (m_calc_widths)
+    // Defer calculating widths while there are no matches yet.
+    if (m_calc_widths && m_matches.get_match_count())
     {
 #ifdef DEBUG
         const width_t col_extra = m_col_extra;
@@ -1176,7 +1243,7 @@ force_desc_below:
 
     if (m_visible_rows < 2)
         m_visible_rows = 0;     // At least 2 rows must fit.
-    else if (m_visible_rows < m_match_rows)
+    else if (m_visible_rows < m_match_rows || m_matches.is_pending())
         m_visible_rows--;       // Reserve space for comment row.
 }
 
@@ -1442,7 +1509,9 @@ void selectcomplete_impl::update_display()
                 }
             }
 
-            if (show_more_comment_row || (m_visible_rows < m_match_rows))
+            const bool pending = m_matches.is_pending();
+            const bool more_rows = show_more_comment_row || (m_visible_rows < m_match_rows);
+            if (more_rows || pending)
             {
                 rl_crlf();
                 up++;
@@ -1450,14 +1519,19 @@ void selectcomplete_impl::update_display()
                 if (!m_comment_row_displayed)
                 {
                     str<> tmp;
-                    if (!m_expanded)
+                    const char* loading = pending ? " (loading)" : "";
+                    if (!more_rows)
+                    {
+                        tmp.format("\x1b[%sm... loading more matches ...\x1b[m\x1b[K", g_color_comment_row.get());
+                    }
+                    else if (!m_expanded)
                     {
                         const int more = m_matches.get_match_count() - shown;
-                        tmp.format("\x1b[%sm... and %u more matches ...\x1b[m\x1b[K", g_color_comment_row.get(), more);
+                        tmp.format("\x1b[%sm... and %u more matches%s ...\x1b[m\x1b[K", g_color_comment_row.get(), more, loading);
                     }
                     else
                     {
-                        tmp.format("\x1b[%smrows %u to %u of %u\x1b[m\x1b[K", g_color_comment_row.get(), m_top + 1, m_top + m_visible_rows, m_match_rows);
+                        tmp.format("\x1b[%smrows %u to %u of %u%s\x1b[m\x1b[K", g_color_comment_row.get(), m_top + 1, m_top + m_visible_rows, m_match_rows, loading);
                     }
                     m_printer->print(tmp.c_str(), tmp.length());
                     m_comment_row_displayed = true;
@@ -1489,6 +1563,21 @@ void selectcomplete_impl::update_display()
                 }
             }
         }
+        else if (is_active() && m_matches.is_pending())
+        {
+            // No matches have arrived yet.
+            rl_crlf();
+            up++;
+
+            str<> tmp;
+            tmp.format("\x1b[%sm... loading matches ...\x1b[m\x1b[J", g_color_comment_row.get());
+            m_printer->print(tmp.c_str(), tmp.length());
+
+            m_prev_displayed = -1;
+            m_any_displayed = true;
+            m_comment_row_displayed = false;
+            m_clear_display = false;
+        }
         else
         {
             if (m_any_displayed)
@@ -25,6 +25,7 @@ public:
     bool            point_within(int in) const;
     bool            is_active() const;
     bool            accepts_mouse_input(mouse_input_type type) const;
+    void            refresh_matches();
 
 private:
     // editor_module.
@@ -38,6 +39,7 @@ private:
     // Internal methods.
     void            cancel(editor_module::result& result, bool can_reactivate=false);
     void            update_matches(bool restrict=false);
+    void            update_rl_modes();
     void            update_len();
     void            update_layout();
     void            update_top();
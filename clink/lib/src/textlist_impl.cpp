@@ -9,6 +9,7 @@
 #include "line_buffer.h"
 
 #include <core/base.h>
+#include <core/fuzzy_match.h>
 #include <core/settings.h>
 #include <core/str_compare.h>
 #include <core/str_iter.h>
@@ -25,6 +26,8 @@ extern "C" {
 extern int _rl_last_v_pos;
 };
 
+#include <memory>
+
 
 
 //------------------------------------------------------------------------------
@@ -56,6 +59,7 @@ enum {
 //------------------------------------------------------------------------------
 extern setting_enum g_ignore_case;
 extern setting_bool g_fuzzy_accent;
+extern setting_bool g_match_fuzzy;
 extern const char* get_popup_colors();
 extern const char* get_popup_desc_colors();
 extern int host_remove_history(int rl_history_index, const char* line);
@@ -172,6 +176,15 @@ static bool strstr_compare(const str_base& needle, const char* haystack)
     return false;
 }
 
+//------------------------------------------------------------------------------
+static bool find_compare(const str_base& needle, const fuzzy_matcher* matcher, const char* haystack, int& score)
+{
+    score = 0;
+    if (!matcher)
+        return strstr_compare(needle, haystack);
+    return haystack && *haystack && matcher->score(haystack, -1, score);
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -544,31 +557,55 @@ find:
             if (input.id == bind_id_textlist_findnext || input.id == bind_id_textlist_findprev)
                 advance_index(i, direction, m_count);
 
+            // With match.fuzzy, typing jumps to the best scoring entry, and
+            // find next/prev step through the entries that match at all.
+            std::unique_ptr<fuzzy_matcher> matcher;
+            if (g_match_fuzzy.get())
+                matcher = std::make_unique<fuzzy_matcher>(m_needle.c_str());
+            const bool best = matcher && input.id == bind_id_textlist_findincr;
+            int found = -1;
+            int found_score = 0;
+
             int original = i;
             while (true)
             {
-                bool match = strstr_compare(m_needle, m_items[i]);
+                int score = 0;
+                bool match = find_compare(m_needle, matcher.get(), m_items[i], score);
                 if (m_has_columns)
                 {
-                    for (int col = 0; !match && col < max_columns; col++)
-                        match = strstr_compare(m_needle, m_columns.get_col_text(i, col));
+                    for (int col = 0; (best || !match) && col < max_columns; col++)
+                    {
+                        int col_score;
+                        if (find_compare(m_needle, matcher.get(), m_columns.get_col_text(i, col), col_score))
+                        {
+                            score = match ? max(score, col_score) : col_score;
+                            match = true;
+                        }
+                    }
                 }
 
-                if (match)
+                if (match && (found < 0 || score > found_score))
                 {
-                    m_index = i;
-                    if (m_index < m_top || m_index >= m_top + m_visible_rows)
-                        m_top = max<int>(0, min<int>(m_index, m_count - m_visible_rows));
-                    m_prev_displayed = -1;
-                    need_display = true;
-                    break;
+                    found = i;
+                    found_score = score;
+                    if (!best)
+                        break;
                 }
 
                 advance_index(i, direction, m_count);
-                if (i == m_index)
+                if (i == (best ? original : m_index))
                     break;
             }
 
+            if (found >= 0)
+            {
+                m_index = found;
+                if (m_index < m_top || m_index >= m_top + m_visible_rows)
+                    m_top = max<int>(0, min<int>(m_index, m_count - m_visible_rows));
+                m_prev_displayed = -1;
+                need_display = true;
+            }
+
             if (need_display)
                 update_display();
         }
@@ -27,7 +27,7 @@ word_classifications::word_classifications(word_classifications&& other)
     m_face_definitions = std::move(other.m_face_definitions);
     m_faces = other.m_faces;
     m_length = other.m_length;
-    m_face_map = std::move(m_face_map);
+    m_face_map = std::move(other.m_face_map);
 
     other.m_faces = nullptr;    // Transferred ownership above.
     other.clear();
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <memory>
+#include <new>
 
 //------------------------------------------------------------------------------
 simple_word_tokeniser::simple_word_tokeniser(const char* delims)
@@ -34,9 +35,13 @@ simple_word_tokeniser::~simple_word_tokeniser()
 //------------------------------------------------------------------------------
 void simple_word_tokeniser::start(const str_iter& iter, const char* quote_pair)
 {
-    delete m_tokeniser;
+    // This runs for each command on each keystroke, so reuse the memory.
+    // str_tokeniser is trivially destructible.
     m_start = iter.get_pointer();
-    m_tokeniser = new str_tokeniser(iter, m_delims);
+    if (m_tokeniser)
+        new (m_tokeniser) str_tokeniser(iter, m_delims);
+    else
+        m_tokeniser = new str_tokeniser(iter, m_delims);
     m_tokeniser->add_quote_pair(quote_pair);
 }
 
@@ -56,6 +61,9 @@ word_token simple_word_tokeniser::next(unsigned int& offset, unsigned int& lengt
 
 
 
+//------------------------------------------------------------------------------
+std::atomic<unsigned int> word_collector::s_generation(0);
+
 //------------------------------------------------------------------------------
 word_collector::word_collector(collector_tokeniser* command_tokeniser, collector_tokeniser* word_tokeniser, const char* quote_pair)
 : m_command_tokeniser(command_tokeniser)
@@ -84,6 +92,56 @@ void word_collector::init_alias_cache()
         m_alias_cache = new alias_cache;
 }
 
+//------------------------------------------------------------------------------
+// Forgets the tokenised lines, and refreshes the alias cache on next use.
+// Words depend on the aliases and argmatchers, which can change between edit
+// lines.
+void word_collector::begin_line()
+{
+    for (auto& cached : m_tokenised)
+        cached.valid = false;
+    if (m_alias_cache)
+        m_alias_cache->clear();
+}
+
+//------------------------------------------------------------------------------
+// Forgets the tokenised lines in every word_collector.  Words depend on the
+// argmatchers, which can change in the middle of an edit line, e.g. when a
+// completion script is loaded on demand.
+void word_collector::notify_state_changed()
+{
+    s_generation++;
+}
+
+//------------------------------------------------------------------------------
+// Changes to the aliases made by this process are covered by alias_cache's
+// serial number.  Both only ever increase, so neither can mask the other.
+unsigned int word_collector::get_generation()
+{
+    return s_generation + alias_cache::get_serial();
+}
+
+//------------------------------------------------------------------------------
+bool word_collector::tokenised::matches(const char* buffer, unsigned int length, unsigned int cursor, bool stop_at_cursor, unsigned int generation) const
+{
+    // Tokenising the whole line doesn't depend on the cursor position.
+    return (valid &&
+            generation == this->generation &&
+            (!stop_at_cursor || cursor == this->cursor) &&
+            line.length() == length &&
+            memcmp(line.c_str(), buffer, length) == 0);
+}
+
+//------------------------------------------------------------------------------
+void word_collector::tokenised::set(const char* buffer, unsigned int length, unsigned int cursor, unsigned int generation)
+{
+    line.clear();
+    line.concat(buffer, length);
+    this->cursor = cursor;
+    this->generation = generation;
+    valid = true;
+}
+
 //------------------------------------------------------------------------------
 char word_collector::get_opening_quote() const
 {
@@ -141,18 +199,47 @@ bool word_collector::get_alias(const char* name, str_base& out) const
 }
 
 //------------------------------------------------------------------------------
+// Several consumers collect words from the same line during one keystroke
+// (generating matches, classifying, suggestions, display filtering), so the
+// result for the most recent line is kept for each mode and reused as long as
+// the line and the aliases and argmatchers are unchanged.
 unsigned int word_collector::collect_words(const char* line_buffer, unsigned int line_length, unsigned int line_cursor,
                                            std::vector<word>& words, collect_words_mode mode) const
 {
-    words.clear();
+    const bool stop_at_cursor = (mode == collect_words_mode::stop_at_cursor ||
+                                 mode == collect_words_mode::display_filter);
 
-    std::vector<command> commands;
-    commands.reserve(5);
-    bool stop_at_cursor = (mode == collect_words_mode::stop_at_cursor ||
-                           mode == collect_words_mode::display_filter);
-    find_command_bounds(line_buffer, line_length, line_cursor, commands, stop_at_cursor);
+    const unsigned int generation = get_generation();
+    tokenised& cached = m_tokenised[stop_at_cursor ? 0 : 1];
+    if (!cached.matches(line_buffer, line_length, line_cursor, stop_at_cursor, generation))
+    {
+        cached.valid = false;
+        tokenise(line_buffer, line_length, line_cursor, cached, stop_at_cursor);
+        cached.set(line_buffer, line_length, line_cursor, generation);
+    }
+
+    words = cached.words;
 
     unsigned int command_offset = 0;
+    for (const auto& command : cached.commands)
+    {
+        if (line_cursor >= command.offset)
+            command_offset = command.offset;
+    }
+
+    return command_offset;
+}
+
+//------------------------------------------------------------------------------
+void word_collector::tokenise(const char* line_buffer, unsigned int line_length, unsigned int line_cursor,
+                              tokenised& out, bool stop_at_cursor) const
+{
+    std::vector<word>& words = out.words;
+    std::vector<command>& commands = out.commands;
+
+    words.clear();
+    commands.reserve(5);
+    find_command_bounds(line_buffer, line_length, line_cursor, commands, stop_at_cursor);
 
     for (auto& command : commands)
     {
@@ -160,9 +247,6 @@ unsigned int word_collector::collect_words(const char* line_buffer, unsigned int
         unsigned int doskey_len = 0;
         bool deprecated_argmatcher = false;
 
-        if (line_cursor >= command.offset)
-            command_offset = command.offset;
-
         {
             unsigned int first_word_len = 0;
             while (first_word_len < command.length &&
@@ -299,8 +383,6 @@ unsigned int word_collector::collect_words(const char* line_buffer, unsigned int
         }
     }
 #endif
-
-    return command_offset;
 }
 
 //------------------------------------------------------------------------------
@@ -312,61 +394,74 @@ unsigned int word_collector::collect_words(const line_buffer& buffer, std::vecto
 //------------------------------------------------------------------------------
 commands::commands(const char* line_buffer, unsigned int line_length, unsigned int line_cursor, const std::vector<word>& words)
 {
-    // Count number of commands so we can pre-allocate words_storage so that
-    // emplace_back() doesn't invalidate pointers (references) stored in
-    // linestates.
+    set(line_buffer, line_length, line_cursor, words);
+}
+
+//------------------------------------------------------------------------------
+commands::commands(const line_buffer& buffer, const std::vector<word>& words)
+{
+    set(buffer, words);
+}
+
+//------------------------------------------------------------------------------
+void commands::set(const char* line_buffer, unsigned int line_length, unsigned int line_cursor, const std::vector<word>& words)
+{
+    m_linestates.clear();
+
+    // Count number of commands so we can size words_storage up front, so that
+    // growing it doesn't invalidate pointers (references) stored in
+    // linestates.  The word vectors from earlier calls are kept and refilled,
+    // so they only allocate when a command has more words than before.
     unsigned int num_commands = 0;
     for (const auto& word : words)
     {
         if (word.command_word)
             num_commands++;
     }
+    if (!words.empty() && !words[0].command_word)
+        num_commands++;
+    if (m_words_storage.size() < num_commands)
+        m_words_storage.resize(num_commands);
+    m_linestates.reserve(num_commands);
 
     // Build vector containing one line_state per command.
     size_t i = 0;
-    std::vector<word> tmp;
-    tmp.reserve(words.size());
-    m_words_storage.reserve(num_commands);
-    while (true)
+    while (i < words.size())
     {
-        if (!tmp.empty() && (i >= words.size() || words[i].command_word))
+        std::vector<word>& command_words = m_words_storage[m_linestates.size()];
+        command_words.clear();
+        do
         {
-            // Make sure classifiers can tell whether the word has a space
-            // before it, so that ` doskeyalias` gets classified as NOT a doskey
-            // alias, since doskey::resolve() won't expand it as a doskey alias.
-            int command_char_offset = tmp[0].offset;
-            if (command_char_offset == 1 && line_buffer[0] == ' ')
-                command_char_offset--;
-            else if (command_char_offset >= 2 &&
-                     line_buffer[command_char_offset - 1] == ' ' &&
-                     line_buffer[command_char_offset - 2] == ' ')
-                command_char_offset--;
-
-            m_words_storage.emplace_back(std::move(tmp));
-            assert(tmp.empty());
-            tmp.reserve(words.size());
-
-            m_linestates.emplace_back(
-                line_buffer,
-                line_length,
-                line_cursor,
-                command_char_offset,
-                m_words_storage.back()
-            );
+            command_words.emplace_back(words[i]);
+            i++;
         }
-
-        if (i >= words.size())
-            break;
-
-        tmp.emplace_back(words[i]);
-        i++;
+        while (i < words.size() && !words[i].command_word);
+
+        // Make sure classifiers can tell whether the word has a space
+        // before it, so that ` doskeyalias` gets classified as NOT a doskey
+        // alias, since doskey::resolve() won't expand it as a doskey alias.
+        int command_char_offset = command_words[0].offset;
+        if (command_char_offset == 1 && line_buffer[0] == ' ')
+            command_char_offset--;
+        else if (command_char_offset >= 2 &&
+                 line_buffer[command_char_offset - 1] == ' ' &&
+                 line_buffer[command_char_offset - 2] == ' ')
+            command_char_offset--;
+
+        m_linestates.emplace_back(
+            line_buffer,
+            line_length,
+            line_cursor,
+            command_char_offset,
+            command_words
+        );
     }
 }
 
 //------------------------------------------------------------------------------
-commands::commands(const line_buffer& buffer, const std::vector<word>& words)
-: commands(buffer.get_buffer(), buffer.get_length(), buffer.get_cursor(), words)
+void commands::set(const line_buffer& buffer, const std::vector<word>& words)
 {
+    set(buffer.get_buffer(), buffer.get_length(), buffer.get_cursor(), words);
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "alias_cache.h"
+
+#include <core/os.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+static void set_alias(const wchar_t* name, const wchar_t* text)
+{
+    wchar_t* host = const_cast<wchar_t*>(os::get_shellname());
+    AddConsoleAliasW(const_cast<wchar_t*>(name), const_cast<wchar_t*>(text), host);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Alias cache")
+{
+    set_alias(L"acfirst", L"one $*");
+    set_alias(L"acsecond", L"two");
+
+    alias_cache cache;
+    str<> out;
+
+    SECTION("Lookup")
+    {
+        REQUIRE(cache.get_alias("acfirst", out));
+        REQUIRE(out.equals("one $*"));
+        REQUIRE(cache.get_alias("ACSecond", out));
+        REQUIRE(out.equals("two"));
+        REQUIRE(!cache.get_alias("acthird", out));
+        REQUIRE(!cache.get_alias("acfirs", out));
+    }
+
+    SECTION("Changes")
+    {
+        REQUIRE(!cache.get_alias("acthird", out));
+
+        // Changes made outside the cache are noticed after clear().
+        set_alias(L"acthird", L"three");
+        REQUIRE(!cache.get_alias("acthird", out));
+        cache.clear();
+        REQUIRE(cache.get_alias("acthird", out));
+        REQUIRE(out.equals("three"));
+
+        // Changes reported via notify_changed() are noticed immediately.
+        set_alias(L"acthird", nullptr);
+        alias_cache::notify_changed();
+        REQUIRE(!cache.get_alias("acthird", out));
+        REQUIRE(cache.get_alias("acfirst", out));
+    }
+
+    set_alias(L"acfirst", nullptr);
+    set_alias(L"acsecond", nullptr);
+    set_alias(L"acthird", nullptr);
+}
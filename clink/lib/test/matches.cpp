@@ -0,0 +1,292 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "display_matches.h"
+#include "matches_impl.h"
+#include "match_pipeline.h"
+#include "matches_lookaside.h"
+
+#include <core/settings.h>
+#include <core/str.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+static bool has_match(const matches& matches, const char* match)
+{
+    for (unsigned int i = 0; i < matches.get_match_count(); ++i)
+        if (strcmp(matches.get_match(i), match) == 0)
+            return true;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches batches")
+{
+    matches_impl source;
+    match_builder builder(source);
+
+    matches_impl progressive;
+    progressive.set_pending(true);
+    unsigned int consumed = 0;
+
+    SECTION("Append")
+    {
+        REQUIRE(!progressive.append_batch(source, consumed));
+
+        builder.add_match("abc", match_type::word);
+        builder.add_match("abd", match_type::word);
+        REQUIRE(progressive.append_batch(source, consumed));
+        REQUIRE(consumed == 2);
+        REQUIRE(!progressive.append_batch(source, consumed));
+
+        match_pipeline pipeline(progressive);
+        pipeline.select("abc");
+        pipeline.sort();
+        REQUIRE(progressive.get_match_count() == 1);
+        REQUIRE(has_match(progressive, "abc"));
+
+        // Later batches are reselected along with the earlier ones.
+        builder.add_match("abcd", match_type::word);
+        builder.add_match("xyz", match_type::word);
+        REQUIRE(progressive.append_batch(source, consumed));
+        REQUIRE(consumed == 4);
+
+        pipeline.select("abc");
+        pipeline.sort();
+        REQUIRE(progressive.get_match_count() == 2);
+        REQUIRE(has_match(progressive, "abc"));
+        REQUIRE(has_match(progressive, "abcd"));
+        REQUIRE(progressive.is_pending());
+    }
+
+    SECTION("Transfer")
+    {
+        builder.add_match("abc", match_type::word);
+        REQUIRE(progressive.append_batch(source, consumed));
+
+        builder.add_match("abd", match_type::word);
+        progressive.done_building();
+        progressive.transfer(source);
+
+        REQUIRE(!progressive.is_pending());
+        REQUIRE(progressive.get_match_count() == 2);
+        REQUIRE(has_match(progressive, "abc"));
+        REQUIRE(has_match(progressive, "abd"));
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches dedup")
+{
+    SECTION("Builder")
+    {
+        matches_impl matches;
+        match_builder builder(matches);
+
+        str<> tmp;
+        for (unsigned int pass = 0; pass < 2; ++pass)
+        {
+            for (unsigned int i = 0; i < 1000; ++i)
+            {
+                tmp.format("c:\\some\\long\\common\\prefix\\file%u", i);
+                REQUIRE(builder.add_match(tmp.c_str(), match_type::word) == !pass);
+            }
+        }
+
+        // Same text with a different type is not a duplicate.
+        REQUIRE(builder.add_match("c:\\some\\long\\common\\prefix\\file0", match_type::arg));
+
+        matches.done_building();
+        REQUIRE(matches.get_match_count() == 1001);
+
+        // The set starts empty again for the next generation.
+        match_pipeline pipeline(matches);
+        pipeline.reset();
+        REQUIRE(matches.get_match_count() == 0);
+        REQUIRE(builder.add_match("c:\\some\\long\\common\\prefix\\file0", match_type::word));
+        REQUIRE(!builder.add_match("c:\\some\\long\\common\\prefix\\file0", match_type::word));
+    }
+
+    SECTION("Set")
+    {
+        std::vector<match_info> infos;
+        match_dedup_set set;
+
+        str<> tmp;
+        std::vector<str_moveable> names;
+        for (unsigned int i = 0; i < 500; ++i)
+        {
+            tmp.format("name%u", i);
+            names.emplace_back(tmp.c_str());
+        }
+        for (unsigned int i = 0; i < 500; ++i)
+        {
+            match_info info = { names[i].c_str(), nullptr, nullptr, i, 0, match_type::word };
+            infos.emplace_back(info);
+            set.insert(i, match_dedup_set::hash(names[i].c_str()));
+        }
+        REQUIRE(set.size() == 500);
+
+        const unsigned int capacity = set.capacity();
+        REQUIRE(capacity >= 500);
+
+        // Erasing shifts colliding entries back, so the rest stay findable.
+        for (unsigned int i = 0; i < 500; i += 2)
+            set.erase(i, match_dedup_set::hash(names[i].c_str()));
+        REQUIRE(set.size() == 250);
+        for (unsigned int i = 0; i < 500; ++i)
+        {
+            const bool found = set.find(infos, { names[i].c_str(), match_type::word }, match_dedup_set::hash(names[i].c_str()));
+            REQUIRE(found == bool(i & 1));
+        }
+
+        set.clear();
+        REQUIRE(set.size() == 0);
+        REQUIRE(set.capacity() == capacity);
+        REQUIRE(!set.find(infos, { names[1].c_str(), match_type::word }, match_dedup_set::hash(names[1].c_str())));
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches count")
+{
+    matches_impl matches;
+    match_builder builder(matches);
+
+    // More matches than fit in 16 bits.
+    str<> tmp;
+    for (unsigned int i = 0; i < 100000; ++i)
+    {
+        tmp.format("match%u", i);
+        REQUIRE(builder.add_match(tmp.c_str(), match_type::word));
+    }
+
+    matches.done_building();
+    REQUIRE(matches.get_match_count() == 100000);
+    REQUIRE(strcmp(matches.get_match(99999), "match99999") == 0);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches fuzzy with wildcards")
+{
+    setting* fuzzy = settings::find("match.fuzzy");
+    REQUIRE(fuzzy);
+    fuzzy->set("true");
+
+    matches_impl matches;
+    match_builder builder(matches);
+    builder.add_match("foobar", match_type::word);
+    builder.add_match("fbx", match_type::word);
+    builder.add_match("other", match_type::word);
+    matches.done_building();
+
+    match_pipeline pipeline(matches);
+    pipeline.select("fb");
+    pipeline.sort();
+    REQUIRE(matches.get_match_count() == 2);
+
+    // Completing with match.wild iterates with a "needle*" pattern, which
+    // must not drop "foobar" just because it only matched fuzzily.
+    std::vector<std::string> iterated;
+    matches_iter iter = matches.get_iter("fb*");
+    while (iter.next())
+        iterated.emplace_back(iter.get_match());
+    REQUIRE(iterated.size() == 2);
+    REQUIRE(iterated[0] == "fbx");
+    REQUIRE(iterated[1] == "foobar");
+
+    fuzzy->set();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches interning")
+{
+    matches_impl matches;
+    match_builder builder(matches);
+    match_pipeline pipeline(matches);
+
+    str_intern_stats before;
+    str_intern_stats after;
+    str<> tmp;
+
+    // Each pass regenerates the same matches and descriptions; only the first
+    // pass should need to allocate copies of them.
+    matches_impl::get_intern_stats(before);
+    for (unsigned int pass = 0; pass < 5; ++pass)
+    {
+        pipeline.reset();
+        for (unsigned int i = 0; i < 1000; ++i)
+        {
+            tmp.format("intern_test_match%u", i);
+            match_desc desc(tmp.c_str(), nullptr, (i & 1) ? "intern_test_odd" : "intern_test_even", match_type::word);
+            REQUIRE(builder.add_match(desc));
+        }
+        matches.done_building();
+        REQUIRE(matches.get_match_count() == 1000);
+    }
+    matches_impl::get_intern_stats(after);
+
+    REQUIRE(after.allocs - before.allocs == 1000 + 2);
+    REQUIRE(after.hits - before.hits >= 1000 * 2 * 4 + 1000 - 2);
+
+    REQUIRE(has_match(matches, "intern_test_match123"));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Packed matches")
+{
+    packed_matches_builder builder(2);
+    REQUIRE(builder.add("abc", match_type::word, ',', MATCH_FLAG_APPEND_DISPLAY, "ABC", "first"));
+    REQUIRE(builder.add("abcdef", match_type::dir, 0, 0, nullptr, nullptr));
+
+    // Add enough to make the block grow, which moves it.
+    str<> tmp;
+    for (unsigned int i = 0; i < 500; ++i)
+    {
+        tmp.format("match_%u", i);
+        REQUIRE(builder.add(tmp.c_str(), match_type::file, 0, 0, nullptr, "description"));
+    }
+    REQUIRE(builder.get_count() == 502);
+
+    char** matches = builder.finish("ab", 2);
+    REQUIRE(matches != nullptr);
+    REQUIRE(strcmp(matches[0], "ab") == 0);
+    REQUIRE(!is_packed_match(matches[0]));
+    REQUIRE(matches[503] == nullptr);
+
+    match_details details = lookup_match(matches[1]);
+    REQUIRE(is_packed_match(matches[1]));
+    REQUIRE(strcmp(details.get_match(), "abc") == 0);
+    REQUIRE(details.get_type() == match_type::word);
+    REQUIRE(details.get_append_char() == ',');
+    REQUIRE(details.get_flags() == MATCH_FLAG_APPEND_DISPLAY);
+    REQUIRE(strcmp(details.get_display(), "ABC") == 0);
+    REQUIRE(strcmp(details.get_description(), "first") == 0);
+
+    details = lookup_match(matches[2]);
+    REQUIRE(strcmp(details.get_match(), "abcdef") == 0);
+    REQUIRE(details.get_type() == match_type::dir);
+    REQUIRE(*details.get_display() == '\0');
+    REQUIRE(*details.get_description() == '\0');
+
+    details = lookup_match(matches[502]);
+    REQUIRE(strcmp(details.get_match(), "match_499") == 0);
+    REQUIRE(strcmp(details.get_description(), "description") == 0);
+
+    // The packed format follows the match text, for code that reads it
+    // directly.
+    const char* packed = matches[1] + 4;
+    REQUIRE(packed[0] == char(match_type::word));
+    REQUIRE(packed[1] == ',');
+    REQUIRE(strcmp(packed + 3, "ABC") == 0);
+
+    // Freeing the strings skips the packed matches.
+    for (unsigned int i = 0; matches[i]; ++i)
+        free_match_hook(matches[i]);
+    REQUIRE(destroy_matches_lookaside(matches));
+    free(matches);
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "word_collector.h"
+#include "alias_cache.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+class counting_tokeniser : public simple_word_tokeniser
+{
+public:
+    void start(const str_iter& iter, const char* quote_pair) override
+    {
+        m_starts++;
+        simple_word_tokeniser::start(iter, quote_pair);
+    }
+    unsigned int m_starts = 0;
+};
+
+//------------------------------------------------------------------------------
+TEST_CASE("Word collector cache")
+{
+    counting_tokeniser tokeniser;
+    word_collector collector(nullptr, &tokeniser);
+    std::vector<word> words;
+
+    const char* line = "abc def ghi";
+    const unsigned int len = unsigned(strlen(line));
+
+    SECTION("Reuse")
+    {
+        collector.collect_words(line, len, len, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(words.size() == 3);
+        REQUIRE(tokeniser.m_starts == 1);
+
+        // Same line and cursor is reused, including for display filtering.
+        words.clear();
+        collector.collect_words(line, len, len, words, collect_words_mode::display_filter);
+        REQUIRE(words.size() == 3);
+        REQUIRE(tokeniser.m_starts == 1);
+
+        // Moving the cursor tokenises again.
+        collector.collect_words(line, len, 5, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(words.size() == 2);
+        REQUIRE(tokeniser.m_starts == 2);
+    }
+
+    SECTION("Whole command")
+    {
+        collector.collect_words(line, len, len, words, collect_words_mode::whole_command);
+        REQUIRE(words.size() == 3);
+        REQUIRE(tokeniser.m_starts == 1);
+
+        // The whole line doesn't depend on the cursor.
+        collector.collect_words(line, len, 0, words, collect_words_mode::whole_command);
+        REQUIRE(words.size() == 3);
+        REQUIRE(tokeniser.m_starts == 1);
+
+        // A changed line tokenises again.
+        collector.collect_words("abc def", 7, 7, words, collect_words_mode::whole_command);
+        REQUIRE(words.size() == 2);
+        REQUIRE(tokeniser.m_starts == 2);
+
+        // Starting a new edit line forgets the cached words.
+        collector.begin_line();
+        collector.collect_words("abc def", 7, 7, words, collect_words_mode::whole_command);
+        REQUIRE(tokeniser.m_starts == 3);
+    }
+
+    SECTION("State changes")
+    {
+        collector.collect_words(line, len, len, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(tokeniser.m_starts == 1);
+
+        // Changed argmatchers can change the words, even mid-line.
+        word_collector::notify_state_changed();
+        collector.collect_words(line, len, len, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(tokeniser.m_starts == 2);
+
+        // So can changed aliases.
+        alias_cache::notify_changed();
+        collector.collect_words(line, len, len, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(tokeniser.m_starts == 3);
+
+        collector.collect_words(line, len, len, words, collect_words_mode::stop_at_cursor);
+        REQUIRE(tokeniser.m_starts == 3);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Word collector commands")
+{
+    const char* line = "abc def & ghi";
+    const unsigned int len = unsigned(strlen(line));
+
+    std::vector<word> words;
+    words.push_back({0, 3, true});
+    words.push_back({4, 3, false});
+    words.push_back({10, 3, true});
+
+    commands commands;
+    commands.set(line, len, len, words);
+
+    const std::vector<line_state>& linestates = commands.get_linestates();
+    REQUIRE(linestates.size() == 2);
+    REQUIRE(linestates[0].get_word_count() == 2);
+    REQUIRE(linestates[0].get_command_offset() == 0);
+    REQUIRE(linestates[1].get_word_count() == 1);
+    REQUIRE(linestates[1].get_command_offset() == 10);
+
+    // Rebuilding for another revision of the line reuses the same memory.
+    const word* first = linestates[0].get_words().data();
+    const word* second = linestates[1].get_words().data();
+    words.pop_back();
+    words.push_back({8, 3, true});
+    commands.set("abc def&ghi", 11, 11, words);
+    REQUIRE(linestates.size() == 2);
+    REQUIRE(linestates[0].get_words().data() == first);
+    REQUIRE(linestates[1].get_words().data() == second);
+    REQUIRE(linestates[1].get_command_offset() == 8);
+
+    // Fewer commands leaves the extra storage unused.
+    words.pop_back();
+    commands.set("abc def", 7, 7, words);
+    REQUIRE(linestates.size() == 1);
+    REQUIRE(linestates[0].get_word_count() == 2);
+    REQUIRE(linestates[0].get_words().data() == first);
+}
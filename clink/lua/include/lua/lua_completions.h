@@ -0,0 +1,58 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/base.h>
+#include <core/str.h>
+
+#include <memory>
+#include <vector>
+
+class lua_state;
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// The "completions" subdirectory of a script directory holds scripts named
+// after the command they provide completions for (e.g. "git.lua").  Those are
+// not loaded when Lua is initialised; instead each is loaded the first time
+// its command is seen.
+//
+// The list of scripts in a completions directory is cached for the life of
+// the process, and is refreshed only when the directory's last write time
+// changes, so reloading Lua does not need to enumerate the directory again.
+class completions_manifest : public no_copy
+{
+public:
+    struct entry
+    {
+        str_moveable        name;   // Lowercase, without the extension.
+        str_moveable        file;
+    };
+
+    static std::shared_ptr<const completions_manifest> get(const char* script_dir);
+
+    const char*             get_dir() const { return m_dir.c_str(); }
+    unsigned int            count() const { return unsigned(m_entries.size()); }
+    const entry&            get(unsigned int index) const { return m_entries[index]; }
+
+private:
+                            completions_manifest(const char* dir, const FILETIME& modified);
+    void                    scan();
+    str_moveable            m_dir;
+    std::vector<entry>      m_entries;
+    FILETIME                m_modified;
+};
+
+//------------------------------------------------------------------------------
+struct lua_completions_counts
+{
+    unsigned int            deferred;   // Not loaded yet.
+    unsigned int            loaded;     // Loaded on demand.
+    unsigned int            failed;     // Failed to load.
+};
+
+//------------------------------------------------------------------------------
+unsigned int lua_completions_add_dir(lua_state& lua, const char* script_dir);
+bool lua_completions_load(lua_State* state, const char* command_word);
+void lua_completions_get_counts(lua_State* state, lua_completions_counts& out);
@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/base.h>
+
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Tracks when each Lua coroutine is next due to be resumed, so the idle loop
+// doesn't need to visit every coroutine on every pass.  Coroutines are
+// identified by ids assigned in coroutines.lua.
+//
+// Timed coroutines are kept in a min-heap keyed by due time, so the next due
+// time is available in O(1) and collecting the due coroutines is O(ready).
+// Parked coroutines (waiting on a yieldguard, or queued behind one) have no
+// due time; they are resumed on every pass so they can check whether the
+// yieldguard is ready, and they don't affect the idle timeout.
+//
+// Times are whatever clock the caller uses (os.clock() in Lua), which lets
+// tests use a fake clock.
+class coroutine_schedule : public no_copy
+{
+public:
+    void                    set_due(unsigned int id, double due);
+    void                    park(unsigned int id);
+    void                    remove(unsigned int id);
+    void                    clear();
+
+    bool                    empty() const { return m_heap.empty() && m_parked.empty(); }
+    unsigned int            count() const { return unsigned(m_heap.size() + m_parked.size()); }
+    unsigned int            parked_count() const { return unsigned(m_parked.size()); }
+    bool                    get_next_due(double& due) const;
+    void                    get_ready(double now, std::vector<unsigned int>& out) const;
+
+private:
+    struct node
+    {
+        double              due;
+        unsigned int        id;
+    };
+
+    void                    remove_at(unsigned int index);
+    void                    sift_up(unsigned int index);
+    void                    sift_down(unsigned int index);
+    void                    place(unsigned int index, const node& n);
+    std::vector<node>       m_heap;
+    std::unordered_map<unsigned int, unsigned int> m_index; // id -> heap index.
+    std::vector<unsigned int> m_parked; // Rarely more than a few.
+};
@@ -7,6 +7,19 @@
 
 class lua_state;
 
+//------------------------------------------------------------------------------
+// Time spent in Lua garbage collection.  Keystroke time is collection that
+// happened automatically inside Lua callbacks (prompt filters, generators,
+// classifiers, etc); idle time is collection done while waiting for input.
+struct lua_gc_stats
+{
+    double          keystroke_time;
+    double          idle_time;
+    unsigned int    keystroke_steps;
+    unsigned int    idle_steps;
+    unsigned int    idle_cycles;
+};
+
 //------------------------------------------------------------------------------
 class lua_input_idle
     : public input_idle
@@ -21,12 +34,19 @@ public:
 
     void            kick();
 
+    static void     get_gc_stats(lua_gc_stats& out);
+
 private:
     bool            is_enabled();
     bool            has_coroutines();
     void            resume_coroutines();
+    unsigned        get_coroutine_timeout();
+    bool            is_gc_due();
+    void            collect_garbage();
     lua_state&      m_state;
     void*           m_event = 0;
     unsigned        m_iterations = 0;
+    int             m_gc_threshold_kb = 0;
+    bool            m_gc_in_cycle = false;
     bool            m_enabled = true;
 };
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <core/memo.h>
+
 class lua_state;
 class str_base;
 
@@ -48,7 +50,9 @@ public:
     static bool     is_filtering() { return s_filtering; }
 
 private:
+    bool            get_fingerprint(const char* in, const char* rin, fingerprint& fp);
     lua_state&      m_lua;
+    memo_cache      m_memo;
 
     static bool s_filtering;
 };
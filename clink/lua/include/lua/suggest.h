@@ -14,6 +14,7 @@ class suggester
 public:
                     suggester(lua_state& lua);
     bool            suggest(line_state& line, matches* matches, int generation_id);
+    bool            generate_async(line_state& line, int generation_id);
 
 private:
     lua_state&      m_lua;
@@ -59,6 +59,8 @@ function _argreader._new(root, line_state)
         _matcher = root,
         _realmatcher = root,
         _line_state = line_state,
+        _words = line_state:getwords(),
+        _wordinfos = line_state:getwordinfos(),
         _arg_index = 1,
         _stack = {},
     }, _argreader)
@@ -191,14 +193,14 @@ local function get_classify_color(code)
 end
 
 --------------------------------------------------------------------------------
-local function lookup_link(arg, word, line_state, word_index)
+local function lookup_link(arg, word, reader, word_index)
     if arg and arg._links then
         local eqlink
-        if line_state then
-            local info = line_state:getwordinfo(word_index)
+        if reader then
+            local info = reader._wordinfos[word_index]
             if info then -- word_index may be -1 when expanding a doskey alias.
                 local pos = info.offset + info.length
-                if line_state:getline():sub(pos, pos) == "=" then
+                if reader._line_state:getline():sub(pos, pos) == "=" then
                     eqlink = arg._links[word.."="]
                 end
             end
@@ -217,6 +219,8 @@ end
 function _argreader:update(word, word_index)
     local arg_match_type = "a" --arg
     local line_state = self._line_state
+    local words = self._words
+    local wordinfos = self._wordinfos
 
     --[[
     self._dbgword = word
@@ -238,8 +242,8 @@ function _argreader:update(word, word_index)
         local flagarg = self._matcher._flags._args[1]
         if not lookup_link(flagarg, word) then
             -- Check if the next word is adjacent.
-            local thiswordinfo = line_state:getwordinfo(word_index)
-            local nextwordinfo = line_state:getwordinfo(word_index + 1)
+            local thiswordinfo = wordinfos[word_index]
+            local nextwordinfo = wordinfos[word_index + 1]
             if nextwordinfo then
                 local thisend = thiswordinfo.offset + thiswordinfo.length + (thiswordinfo.quoted and 1 or 0)
                 local nextbegin = nextwordinfo.offset - (nextwordinfo.quoted and 1 or 0)
@@ -282,7 +286,7 @@ function _argreader:update(word, word_index)
     if not is_flag and realmatcher._flagsanywhere == false then
         self._noflags = true
     elseif not self._noflags then
-        next_is_flag = matcher:_is_flag(line_state:getword(word_index + 1))
+        next_is_flag = matcher:_is_flag(words[word_index + 1] or "")
     end
 
     -- Update matcher after possible _push.
@@ -366,10 +370,10 @@ function _argreader:update(word, word_index)
                         if arg._links and arg._links[word] then
                             t = arg_match_type
                         else
-                            local this_info = line_state:getwordinfo(word_index)
-                            local next_info = line_state:getwordinfo(word_index + 1)
+                            local this_info = wordinfos[word_index]
+                            local next_info = wordinfos[word_index + 1]
                             if this_info and next_info and this_info.offset + this_info.length == next_info.offset then
-                                local combined_word = word..line_state:getword(word_index + 1)
+                                local combined_word = word..words[word_index + 1]
                                 for _, i in ipairs(arg) do
                                     if type(i) ~= "function" and i == combined_word then
                                         t = arg_match_type
@@ -385,7 +389,7 @@ function _argreader:update(word, word_index)
                     end
                 end
                 if not matched then
-                    local this_info = line_state:getwordinfo(word_index)
+                    local this_info = wordinfos[word_index]
                     local pos = this_info.offset + this_info.length
                     if line_state:getline():sub(pos, pos) == "=" then
                         t, matched = is_word_present(word.."=", arg, t, arg_match_type)
@@ -403,10 +407,10 @@ function _argreader:update(word, word_index)
     end
 
     -- Does the word lead to another matcher?
-    local linked = lookup_link(arg, word, line_state, word_index)
+    local linked = lookup_link(arg, word, self, word_index)
     if linked then
         if is_flag and word:match("[:=]$") and word_index >= 0 then
-            local info = line_state:getwordinfo(word_index)
+            local info = wordinfos[word_index]
             if info and
                     line_state:getcursor() ~= info.offset + info.length and
                     line_state:getline():sub(info.offset + info.length, info.offset + info.length) == " " then
@@ -1206,13 +1210,13 @@ function _argmatcher:_generate(line_state, match_builder, extra_words)
     end
 
     -- Consume words and use them to move through matchers' arguments.
-    local word_count = line_state:getwordcount()
+    local words = reader._words
+    local wordinfos = reader._wordinfos
+    local word_count = #words
     local command_word_index = line_state:getcommandwordindex()
     for word_index = command_word_index + 1, (word_count - 1) do
-        local info = line_state:getwordinfo(word_index)
-        if not info.redir then
-            local word = line_state:getword(word_index)
-            reader:update(word, word_index)
+        if not wordinfos[word_index].redir then
+            reader:update(words[word_index], word_index)
         end
     end
 
@@ -1224,7 +1228,7 @@ function _argmatcher:_generate(line_state, match_builder, extra_words)
     local hidden
 
     local endword
-    local endwordinfo = line_state:getwordinfo(line_state:getwordcount())
+    local endwordinfo = wordinfos[word_count]
     if clink.use_old_filtering then
         endword = line_state:getline():sub(endwordinfo.offset, line_state:getcursor() - 1)
     else
@@ -1595,7 +1599,8 @@ end
 
 
 --------------------------------------------------------------------------------
-local function _has_argmatcher(command_word)
+local function _has_argmatcher(command_word, deferred_loaded)
+    local original_word = command_word
     command_word = clink.lower(command_word)
 
     -- Check for an exact match.
@@ -1611,6 +1616,12 @@ local function _has_argmatcher(command_word)
             return argmatcher
         end
     end
+
+    -- If a script in a completions directory is named after the command, load
+    -- it now and try again.
+    if not deferred_loaded and clink._load_deferred_completion(original_word) then
+        return _has_argmatcher(original_word, true)
+    end
 end
 
 --------------------------------------------------------------------------------
@@ -1759,13 +1770,13 @@ function clink._generate_from_historyline(line_state)
     end
 
     -- Consume words and use them to move through matchers' arguments.
-    local word_count = line_state:getwordcount()
+    local words = reader._words
+    local wordinfos = reader._wordinfos
+    local word_count = #words
     local command_word_index = line_state:getcommandwordindex()
     for word_index = command_word_index + 1, word_count do
-        local info = line_state:getwordinfo(word_index)
-        if not info.redir then
-            local word = line_state:getword(word_index)
-            reader:update(word, word_index)
+        if not wordinfos[word_index].redir then
+            reader:update(words[word_index], word_index)
         end
     end
 end
@@ -1806,13 +1817,13 @@ function argmatcher_generator:getwordbreakinfo(line_state)
         end
 
         -- Consume words and use them to move through matchers' arguments.
-        local word_count = line_state:getwordcount()
+        local words = reader._words
+        local wordinfos = reader._wordinfos
+        local word_count = #words
         local command_word_index = line_state:getcommandwordindex()
         for word_index = command_word_index + 1, (word_count - 1) do
-            local info = line_state:getwordinfo(word_index)
-            if not info.redir then
-                local word = line_state:getword(word_index)
-                reader:update(word, word_index)
+            if not wordinfos[word_index].redir then
+                reader:update(words[word_index], word_index)
             end
         end
 
@@ -1883,11 +1894,11 @@ function argmatcher_classifier:classify(commands)
             end
 
             -- Consume words and use them to move through matchers' arguments.
+            local words = reader._words
+            local wordinfos = reader._wordinfos
             for word_index = command_word_index + 1, word_count do
-                local info = line_state:getwordinfo(word_index)
-                if not info.redir then
-                    local word = line_state:getword(word_index)
-                    reader:update(word, word_index)
+                if not wordinfos[word_index].redir then
+                    reader:update(words[word_index], word_index)
                 end
             end
         end
@@ -2021,3 +2032,16 @@ function clink.arg.register_parser(cmd, parser)
     _argmatchers[cmd] = parser
     return matcher
 end
+
+--------------------------------------------------------------------------------
+function clink._diag_completions()
+    local deferred, loaded, failed = clink._get_completion_counts()
+    if loaded > 0 or failed > 0 or deferred > 0 then
+        clink.print("\x1b[1mcompletion scripts:\x1b[m")
+        print("  deferred", deferred)
+        print("  loaded", loaded)
+        if failed > 0 then
+            print("  failed", failed)
+        end
+    end
+end
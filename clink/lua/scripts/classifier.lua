@@ -45,8 +45,11 @@ function clink._classify(commands)
     local impl = function ()
         clink.classifier_stopped = nil
 
+        local tracing = clink._is_tracing()
         for _, classifier in ipairs(_classifiers) do
+            local begin = tracing and clink._trace_begin()
             local ret = classifier:classify(commands)
+            if begin then clink._trace_end("classifier", classifier.classify, begin) end
             if ret == true then
                 -- Remember the classifier function that stopped.
                 clink.classifier_stopped = classifier.classify
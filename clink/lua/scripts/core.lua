@@ -175,3 +175,24 @@ function os.globfiles(pattern, extrainfo)
         return t
     end
 end
+
+--------------------------------------------------------------------------------
+function os.walkdir(dir, options)
+    local c, ismain = coroutine.running()
+    if ismain then
+        return os._walkdir(dir, options)
+    elseif clink._is_coroutine_canceled(c) then
+        return {}, false
+    else
+        -- Yield until the walk finishes.
+        local w = os._makedirwalker(dir, options)
+        while not w:isdone() do
+            coroutine.yield()
+            if clink._is_coroutine_canceled(c) then
+                w:cancel()
+                return {}, false
+            end
+        end
+        return w:results()
+    end
+end
@@ -4,6 +4,9 @@
 --------------------------------------------------------------------------------
 clink = clink or {}
 local _coroutines = {}
+local _coroutines_by_id = {}            -- Maps schedule ids to entries in _coroutines.
+local _next_coroutine_id = 0
+local _schedule = clink._new_coroutine_schedule() -- Tracks when each coroutine is next due.
 local _coroutines_created = {}          -- Remembers creation info for each coroutine, for use by clink.addcoroutine.
 local _after_coroutines = {}            -- Funcs to run after a pass resuming coroutines.
 local _coroutines_resumable = false     -- When false, coroutines will no longer run.
@@ -26,6 +29,7 @@ local print = clink.print
 --      interval:       Interval at which to schedule the coroutine.
 --      context:        The context in which the coroutine was created.
 --      generation:     The generation to which this coroutine belongs.
+--      id:             Identifies the coroutine in _schedule.
 --
 --  Updated by the coroutine management system:
 --      resumed:        Number of times the coroutine has been resumed.
@@ -35,6 +39,42 @@ local print = clink.print
 --      infinite:       Use INFINITE wait for this coroutine; it's actively inside popenyield.
 --      queued:         Use INFINITE wait for this coroutine; it's queued inside popenyield.
 
+--------------------------------------------------------------------------------
+local function next_entry_target(entry, now)
+    if not entry.lastclock then
+        return 0
+    else
+        -- Multiple kinds of throttling for coroutines that want to run more
+        -- frequently than every 5 seconds:
+        --  1.  Throttle if running for 5 or more seconds, but reset the elapsed
+        --      timer every time io.popenyield() finishes.
+        --  2.  Throttle if running for more than 30 seconds total.
+        -- Throttled coroutines can only run once every 5 seconds.
+        local interval = entry.interval or 0
+        local throttleclock = entry.throttleclock or entry.firstclock
+        if now and interval < 5 then
+            if throttleclock and now - throttleclock > 5 then
+                interval = 5
+            elseif entry.firstclock and now - entry.firstclock > 30 then
+                interval = 5
+            end
+        end
+        return entry.lastclock + interval
+    end
+end
+
+--------------------------------------------------------------------------------
+-- Updates when the coroutine is next due.  Coroutines waiting on a yieldguard
+-- (or queued behind one) are parked instead; they're resumed on every pass so
+-- they can notice as soon as the yieldguard is ready.
+local function reschedule(entry)
+    if entry.yieldguard or entry.queued then
+        _schedule:park(entry.id)
+    else
+        _schedule:setdue(entry.id, next_entry_target(entry, entry.lastclock))
+    end
+end
+
 --------------------------------------------------------------------------------
 local function clear_coroutines()
     local preserve = {}
@@ -51,6 +91,8 @@ local function clear_coroutines()
     end
 
     _coroutines = {}
+    _coroutines_by_id = {}
+    _schedule:clear()
     _coroutines_created = {}
     _after_coroutines = {}
     _coroutines_resumable = false
@@ -64,6 +106,8 @@ local function clear_coroutines()
 
     for _, entry in ipairs(preserve) do
         _coroutines[entry.coroutine] = entry
+        _coroutines_by_id[entry.id] = entry
+        reschedule(entry)
         _coroutines_resumable = true
     end
 end
@@ -72,16 +116,20 @@ clink.onbeginedit(clear_coroutines)
 --------------------------------------------------------------------------------
 local function release_coroutine_yieldguard()
     if _coroutine_yieldguard and _coroutine_yieldguard.yieldguard:ready() then
+        -- The coroutine may have finished or been removed already, since
+        -- io.popenyield returns before the command has finished.
         local entry = _coroutines[_coroutine_yieldguard.coroutine]
         if entry and entry.yieldguard == _coroutine_yieldguard.yieldguard then
             entry.throttleclock = os.clock()
             entry.yieldguard = nil
-            _coroutine_yieldguard = nil
-            for _,entry in pairs(_coroutines) do
-                if entry.queued then
-                    entry.queued = nil
-                    break
-                end
+            reschedule(entry)
+        end
+        _coroutine_yieldguard = nil
+        for _,entry in pairs(_coroutines) do
+            if entry.queued then
+                entry.queued = nil
+                reschedule(entry)
+                break
             end
         end
     end
@@ -142,30 +190,6 @@ local function check_generation(c)
     return false
 end
 
---------------------------------------------------------------------------------
-local function next_entry_target(entry, now)
-    if not entry.lastclock then
-        return 0
-    else
-        -- Multiple kinds of throttling for coroutines that want to run more
-        -- frequently than every 5 seconds:
-        --  1.  Throttle if running for 5 or more seconds, but reset the elapsed
-        --      timer every time io.popenyield() finishes.
-        --  2.  Throttle if running for more than 30 seconds total.
-        -- Throttled coroutines can only run once every 5 seconds.
-        local interval = entry.interval
-        local throttleclock = entry.throttleclock or entry.firstclock
-        if now and interval < 5 then
-            if throttleclock and now - throttleclock > 5 then
-                interval = 5
-            elseif entry.firstclock and now - entry.firstclock > 30 then
-                interval = 5
-            end
-        end
-        return entry.lastclock + interval
-    end
-end
-
 --------------------------------------------------------------------------------
 function clink._after_coroutines(func)
     if type(func) ~= "function" then
@@ -181,20 +205,13 @@ end
 
 --------------------------------------------------------------------------------
 function clink._wait_duration()
+    release_coroutine_yieldguard()  -- Dequeue next if necessary.
     if _coroutines_resumable then
-        local target
-        local now = os.clock()
-        release_coroutine_yieldguard()  -- Dequeue next if necessary.
-        for _,entry in pairs(_coroutines) do
-            local this_target = next_entry_target(entry, now)
-            if entry.yieldguard or entry.queued then
-                -- Yield until output is ready; don't influence the timeout.
-            elseif not target or target > this_target then
-                target = this_target
-            end
-        end
+        -- Parked coroutines yield until output is ready; they don't influence
+        -- the timeout.
+        local target = _schedule:nextdue()
         if target then
-            return target - now
+            return target - os.clock()
         end
     end
 end
@@ -214,53 +231,58 @@ function clink._resume_coroutines()
     -- Protected call to resume coroutines.
     local remove = {}
     local impl = function()
-        for _,entry in pairs(_coroutines) do
-            if coroutine.status(entry.coroutine) == "dead" then
-                table.insert(remove, _)
+        for _,id in ipairs(_schedule:ready(os.clock())) do
+            local entry = _coroutines_by_id[id]
+            if not entry then
+                -- Removed by another coroutine earlier in this pass.
+            elseif coroutine.status(entry.coroutine) == "dead" then
+                table.insert(remove, entry.coroutine)
             else
-                _coroutines_resumable = true
                 local now = os.clock()
-                if next_entry_target(entry, now) <= now then
-                    local events
-                    local old_rl_state
-                    if not entry.firstclock then
-                        entry.firstclock = now
+                local events
+                local old_rl_state
+                if not entry.firstclock then
+                    entry.firstclock = now
+                end
+                entry.resumed = entry.resumed + 1
+                clink._set_coroutine_context(entry.context)
+                if entry.isgenerator then
+                    old_rl_state = rl_state
+                    rl_state = entry.rl_state
+                    if not entry.keepevents then
+                        events = clink._set_coroutine_events(entry.events)
                     end
-                    entry.resumed = entry.resumed + 1
-                    clink._set_coroutine_context(entry.context)
-                    if entry.isgenerator then
-                        old_rl_state = rl_state
-                        rl_state = entry.rl_state
-                        if not entry.keepevents then
-                            events = clink._set_coroutine_events(entry.events)
-                        end
+                end
+                local ok, ret = coroutine.resume(entry.coroutine, true--[[async]])
+                if entry.isgenerator then
+                    entry.rl_state = rl_state
+                    rl_state = old_rl_state
+                    if not entry.keepevents then
+                        entry.events = clink._set_coroutine_events(events)
                     end
-                    local ok, ret = coroutine.resume(entry.coroutine, true--[[async]])
-                    if entry.isgenerator then
-                        entry.rl_state = rl_state
-                        rl_state = old_rl_state
-                        if not entry.keepevents then
-                            entry.events = clink._set_coroutine_events(events)
-                        end
+                end
+                if ok then
+                    -- Use live clock so the interval excludes the execution
+                    -- time of the coroutine.
+                    entry.lastclock = os.clock()
+                    if entry.isgenerator and coroutine.status(entry.coroutine) ~= "dead" then
+                        clink._publish_match_batch(entry.coroutine)
                     end
-                    if ok then
-                        -- Use live clock so the interval excludes the execution
-                        -- time of the coroutine.
-                        entry.lastclock = os.clock()
+                else
+                    if _coroutine_canceled then
+                        entry.canceled = true
                     else
-                        if _coroutine_canceled then
-                            entry.canceled = true
-                        else
-                            print("")
-                            print("coroutine failed:")
-                            print(ret)
-                            entry.error = ret
-                        end
-                    end
-                    if coroutine.status(entry.coroutine) == "dead" then
-                        table.insert(remove, _)
+                        print("")
+                        print("coroutine failed:")
+                        print(ret)
+                        entry.error = ret
                     end
                 end
+                if coroutine.status(entry.coroutine) == "dead" then
+                    table.insert(remove, entry.coroutine)
+                elseif _coroutines[entry.coroutine] == entry then
+                    reschedule(entry)
+                end
             end
         end
     end
@@ -283,6 +305,9 @@ function clink._resume_coroutines()
     for _,c in ipairs(remove) do
         clink.removecoroutine(c)
     end
+    if next(_coroutines) then
+        _coroutines_resumable = true
+    end
     if _dead and #_dead > 20 then
         -- Trim the dead list to 20 entries.
         local t = {}
@@ -442,6 +467,8 @@ function clink._diag_coroutines()
         end
         print("  resumable", _coroutines_resumable)
         print("  wait_duration", clink._wait_duration())
+        local scheduled, parked = _schedule:count()
+        print("  scheduled", scheduled.." ("..parked.." parked)")
         if _coroutine_yieldguard then
             local yg = _coroutine_yieldguard.yieldguard
             print("  yieldguard", (yg:ready() and green.."ready"..norm or yellow.."yield"..norm))
@@ -460,6 +487,15 @@ function clink._diag_coroutines()
     end
 end
 
+--------------------------------------------------------------------------------
+function clink._diag_gc()
+    local stats = clink._get_gc_stats()
+    clink.print("\x1b[1mlua gc:\x1b[m")
+    print("  memory", stats.memory_kb.." KB")
+    print("  keystroke", stats.keystroke_ms.." ms in "..stats.keystroke_steps.." steps")
+    print("  idle", stats.idle_ms.." ms in "..stats.idle_steps.." steps, "..stats.idle_cycles.." cycles")
+end
+
 
 
 --------------------------------------------------------------------------------
@@ -484,14 +520,17 @@ function clink.addcoroutine(c, interval)
     if _coroutines[c] then
         if not _coroutines[c].throttled then
             _coroutines[c].interval = interval
+            reschedule(_coroutines[c])
         end
         return
     end
 
     -- Add a new coroutine.
     local created_info = _coroutines_created[c] or {}
-    _coroutines[c] = {
+    _next_coroutine_id = _next_coroutine_id + 1
+    local entry = {
         coroutine=c,
+        id=_next_coroutine_id,
         interval=interval or created_info.interval or 0,
         resumed=0,
         func=created_info.func,
@@ -502,6 +541,9 @@ function clink.addcoroutine(c, interval)
         rl_state=rl_state,
         src=created_info.src,
     }
+    _coroutines[c] = entry
+    _coroutines_by_id[entry.id] = entry
+    reschedule(entry)
     _coroutines_created[c] = nil
     _coroutines_resumable = true
 end
@@ -524,6 +566,11 @@ function clink.removecoroutine(c)
                 table.insert(_dead, entry)
             end
         end
+        local entry = _coroutines[c]
+        if entry then
+            _schedule:remove(entry.id)
+            _coroutines_by_id[entry.id] = nil
+        end
         _coroutines[c] = nil
         _coroutines_resumable = false
         for _ in pairs(_coroutines) do
@@ -571,6 +618,7 @@ function clink.setcoroutineinterval(c, interval)
     -- ok to blindly set the interval here even if the coroutine is currently
     -- being throttled.
     _coroutines[c].interval = interval
+    reschedule(_coroutines[c])
 end
 
 --------------------------------------------------------------------------------
@@ -615,6 +663,37 @@ end
 
 
 
+--------------------------------------------------------------------------------
+-- The native read, lines, and close methods block until enough output has
+-- arrived.  These wrappers yield instead, when inside a coroutine.
+local _popen_stream_hooked = nil
+local function hook_popen_stream(file)
+    local meta = getmetatable(file)
+    if _popen_stream_hooked == meta then
+        return
+    end
+    _popen_stream_hooked = meta
+
+    local native_read = meta.read
+    local function read(self, ...)
+        local _, ismain = coroutine.running()
+        if not ismain then
+            while not self:_ready(...) do
+                coroutine.yield()
+            end
+        end
+        return native_read(self, ...)
+    end
+
+    meta.read = read
+    meta.lines = function (self, ...)
+        local formats = table.pack(...)
+        return function ()
+            return read(self, table.unpack(formats, 1, formats.n))
+        end
+    end
+end
+
 --------------------------------------------------------------------------------
 --- -name:  io.popenyield
 --- -ver:   1.2.10
@@ -623,12 +702,18 @@ end
 --- -ret:   file
 --- This is the same as
 --- <code><span class="hljs-built_in">io</span>.<span class="hljs-built_in">popen</span>(<span class="arg">command</span>, <span class="arg">mode</span>)</code>
---- except that it only supports read mode and it yields until the command has
---- finished:
+--- except that it only supports read mode and reading from the file yields
+--- until enough output is available:
 ---
 --- Runs <span class="arg">command</span> and returns a read file handle for
---- reading output from the command.  It yields until the command has finished
---- and the complete output is ready to be read without blocking.
+--- reading output from the command.  The output is buffered in memory as the
+--- command produces it.  Reading from the file yields until enough output has
+--- arrived, so lines can be processed before the command has finished.
+---
+--- <strong>Note:</strong> starting in v1.3.13 the file handle is not a Lua
+--- file object, so <code><span class="hljs-built_in">io</span>.type()</code>
+--- doesn't recognize it.  It supports the <code>read()</code>,
+--- <code>lines()</code>, and <code>close()</code> methods.
 ---
 --- The <span class="arg">mode</span> can contain "r" (read mode) and/or either
 --- "t" for text mode (the default if omitted) or "b" for binary mode.  Write
@@ -682,17 +767,14 @@ function io.popenyield(command, mode)
             cancel_coroutine(message)
             return io.open("nul")
         end
-        -- Start the popenyield.
+        -- Start the popenyield.  The yieldguard stays set until the command
+        -- has finished, even though the file is returned right away; this
+        -- enforces no more than one spawned background process running at a
+        -- time.  Do not allow canceling once the process has been spawned.
         local file, yieldguard = io.popenyield_internal(command, mode)
         if file and yieldguard then
+            hook_popen_stream(file)
             set_coroutine_yieldguard(yieldguard)
-            while not yieldguard:ready() do
-                coroutine.yield()
-                -- Do not allow canceling once the process has been spawned.
-                -- This enforces no more than one spawned background process is
-                -- running at a time.
-            end
-            set_coroutine_yieldguard(nil)
         end
         return file
     else
@@ -174,6 +174,41 @@ function clink._make_match_generate_coroutine(line, matches, builder, generation
     clink.setcoroutinename(c, "generate matches")
     _match_generate_state.coroutine = c
     _match_generate_state.started = nil
+    _match_generate_state.generation_id = generation_id
+end
+
+--------------------------------------------------------------------------------
+-- Starts a coroutine to generate matches for progressive completion, unless
+-- one is already generating matches for the same generation id.
+function clink._start_match_generate(line, matches, builder, generation_id)
+    if _match_generate_state.coroutine then
+        if _match_generate_state.generation_id == generation_id then
+            return true
+        end
+        cancel_match_generate_coroutine()
+    end
+
+    clink._make_match_generate_coroutine(line, matches, builder, generation_id)
+    return _match_generate_state.coroutine and true or false
+end
+
+--------------------------------------------------------------------------------
+-- Called by the coroutine scheduler each time the match generator coroutine
+-- yields.  Publishes the matches generated so far as a batch, and cancels the
+-- coroutine if its generation id has been superseded.
+function clink._publish_match_batch(c)
+    if _match_generate_state.coroutine ~= c then
+        return
+    end
+
+    local generation_id = _match_generate_state.generation_id
+    if not clink._matches_batch_ready(generation_id) then
+        clink._cancel_coroutine(c)
+        _match_generate_state = {}
+        -- Let the line editor know, so it can start generating for the newer
+        -- generation id if needed.
+        clink.matches_ready(generation_id)
+    end
 end
 
 
@@ -229,8 +264,11 @@ function clink._generate(line_state, match_builder, old_filtering)
         cancel_match_generate_coroutine()
 
         -- Run match generators.
+        local tracing = clink._is_tracing()
         for _, generator in ipairs(_generators) do
+            local begin = tracing and clink._trace_begin()
             local ret = generator:generate(line_state, match_builder)
+            if begin then clink._trace_end("generator", generator.generate, begin) end
             if ret == true then
                 -- Remember the generator function that stopped.
                 clink.generator_stopped = generator.generate
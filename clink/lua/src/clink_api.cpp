@@ -18,6 +18,7 @@
 #include <core/str_tokeniser.h>
 #include <core/str_unordered_set.h>
 #include <core/settings.h>
+#include <core/trace.h>
 #include <core/linear_allocator.h>
 #include <core/debugheap.h>
 #include <lib/intercept.h>
@@ -1437,6 +1438,20 @@ static int matches_ready(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int matches_batch_ready(lua_State* state)
+{
+    bool isnum;
+    int id = checkinteger(state, 1, &isnum);
+    if (!isnum)
+        return 0;
+
+    extern bool notify_matches_batch(int generation_id);
+    lua_pushboolean(state, notify_matches_batch(id));
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 // UNDOCUMENTED; internal use only.
 static int recognize_command(lua_State* state)
@@ -1473,15 +1488,18 @@ static int generate_from_history(lua_State* state)
     lua_pushliteral(state, "_generate_from_historyline");
     lua_rawget(state, -2);
 
+    // Reused for each line, to avoid reallocating.
+    std::vector<word> words;
+    commands commands;
+
     while (*list)
     {
         const char* buffer = (*list)->line;
         unsigned int len = static_cast<unsigned int>(strlen(buffer));
 
         // Collect one line_state for each command in the line.
-        std::vector<word> words;
         collector.collect_words(buffer, len, len/*cursor*/, words, collect_words_mode::whole_command);
-        commands commands(buffer, len, 0, words);
+        commands.set(buffer, len, 0, words);
 
         for (const line_state& line : commands.get_linestates())
         {
@@ -1529,6 +1547,97 @@ static int is_cmd_command(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int is_tracing(lua_State* state)
+{
+    lua_pushboolean(state, trace::is_enabled());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+static int trace_begin(lua_State* state)
+{
+    lua_pushnumber(state, lua_Number(trace::now()));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// Interning takes a lock, so the interned names and details are cached in a
+// registry table keyed by the name string or the function.  The keys are weak,
+// so caching a function doesn't keep it alive.
+static const char c_trace_strings_key[] = "clink_trace_strings";
+
+//------------------------------------------------------------------------------
+static const char* get_trace_string(lua_State* state, int idx)
+{
+    idx = lua_absindex(state, idx);
+    if (!lua_isfunction(state, idx) && !lua_isstring(state, idx))
+        return nullptr;
+
+    save_stack_top ss(state);
+
+    lua_getfield(state, LUA_REGISTRYINDEX, c_trace_strings_key);
+    if (!lua_istable(state, -1))
+    {
+        lua_pop(state, 1);
+        lua_newtable(state);
+        lua_createtable(state, 0, 1);
+        lua_pushliteral(state, "k");
+        lua_setfield(state, -2, "__mode");
+        lua_setmetatable(state, -2);
+        lua_pushvalue(state, -1);
+        lua_setfield(state, LUA_REGISTRYINDEX, c_trace_strings_key);
+    }
+
+    lua_pushvalue(state, idx);
+    lua_rawget(state, -2);
+    if (lua_islightuserdata(state, -1))
+        return static_cast<const char*>(lua_touserdata(state, -1));
+    lua_pop(state, 1);
+
+    str<> s;
+    if (lua_isfunction(state, idx))
+    {
+        lua_Debug ar = {};
+        lua_pushvalue(state, idx);
+        if (lua_getinfo(state, ">S", &ar))
+            s.format("%s:%d", ar.short_src, ar.linedefined);
+    }
+    else
+    {
+        s = lua_tostring(state, idx);
+    }
+
+    const char* interned = trace::intern(s.c_str());
+    lua_pushvalue(state, idx);
+    lua_pushlightuserdata(state, const_cast<char*>(interned));
+    lua_rawset(state, -3);
+    return interned;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Records a span that started at the time returned by _trace_begin.  The
+// detail can be a string, or a function whose definition location is used.
+static int trace_end(lua_State* state)
+{
+    const long long end = trace::now();
+
+    if (!lua_isstring(state, 1) || !lua_isnumber(state, 3))
+        return 0;
+
+    const char* name = get_trace_string(state, 1);
+    if (!name)
+        return 0;
+
+    const char* detail = get_trace_string(state, 2);
+    const long long begin = (long long)lua_tonumber(state, 3);
+    trace::record(name, detail, begin, end);
+    return 0;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -1540,6 +1649,10 @@ extern int get_env_names(lua_State* state);
 extern int get_screen_info(lua_State* state);
 extern int is_dir(lua_State* state);
 extern int explode(lua_State* state);
+extern int load_deferred_completion(lua_State* state);
+extern int get_completion_counts(lua_State* state);
+extern int get_gc_stats(lua_State* state);
+extern int new_coroutine_schedule(lua_State* state);
 
 //------------------------------------------------------------------------------
 void clink_lua_initialise(lua_state& lua)
@@ -1586,11 +1699,19 @@ void clink_lua_initialise(lua_state& lua)
         { "set_suggestion_result",  &set_suggestion_result },
         { "kick_idle",              &kick_idle },
         { "matches_ready",          &matches_ready },
+        { "_matches_batch_ready",   &matches_batch_ready },
         { "_recognize_command",     &recognize_command },
         { "_generate_from_history", &generate_from_history },
         { "_mark_deprecated_argmatcher", &mark_deprecated_argmatcher },
         { "_invalidate_matches",    &invalidate_matches },
         { "is_cmd_command",         &is_cmd_command },
+        { "_load_deferred_completion", &load_deferred_completion },
+        { "_get_completion_counts", &get_completion_counts },
+        { "_get_gc_stats",          &get_gc_stats },
+        { "_new_coroutine_schedule", &new_coroutine_schedule },
+        { "_is_tracing",            &is_tracing },
+        { "_trace_begin",           &trace_begin },
+        { "_trace_end",             &trace_end },
     };
 
     lua_State* state = lua.get_state();
@@ -8,6 +8,7 @@
 #include <core/base.h>
 #include <core/os.h>
 #include <core/path.h>
+#include <core/stream_buffer.h>
 #include <core/globber.h>
 #include <core/debugheap.h>
 
@@ -30,7 +31,6 @@ static popenrw_info* s_head = nullptr;
 //------------------------------------------------------------------------------
 struct popenrw_info
 {
-    friend int io_popenyield(lua_State* state);
     friend int io_popenrw(lua_State* state);
 
     static popenrw_info* find(FILE* f)
@@ -71,7 +71,6 @@ struct popenrw_info
     , r(nullptr)
     , w(nullptr)
     , process_handle(0)
-    , async(false)
     {
     }
 
@@ -105,17 +104,11 @@ struct popenrw_info
         return wait;
     }
 
-    bool is_async()
-    {
-        return async;
-    }
-
 private:
     popenrw_info* next;
     FILE* r;
     FILE* w;
     intptr_t process_handle;
-    bool async;
 };
 
 //------------------------------------------------------------------------------
@@ -152,10 +145,9 @@ static int pclosefile(lua_State *state)
     intptr_t process_handle = info->get_wait_handle();
     if (process_handle)
     {
-        bool wait = !info->is_async();
         popenrw_info::remove(info);
         delete info;
-        return luaL_execresult(state, wait ? pclosewait(process_handle) : 0);
+        return luaL_execresult(state, pclosewait(process_handle));
     }
 
     return luaL_fileresult(state, (res == 0), NULL);
@@ -360,23 +352,23 @@ struct pipe_pair
 
 
 //------------------------------------------------------------------------------
-struct popen_buffering : public yield_thread
+// Drains the child's stdout pipe into a stream_buffer, which Lua reads from as
+// the output arrives.  In text mode, CRLF pairs are translated to LF the same
+// way the CRT does for text mode files.
+struct popen_reader : public yield_thread
 {
-    popen_buffering(FILE* r, HANDLE w)
+    popen_reader(FILE* r, const std::shared_ptr<stream_buffer>& buffer, bool binary)
     : m_read(r)
-    , m_write(w)
+    , m_buffer(buffer)
+    , m_binary(binary)
     {
         assert(r != nullptr);
-        assert(w != nullptr);
-        assert(w != INVALID_HANDLE_VALUE);
     }
 
-    ~popen_buffering()
+    ~popen_reader()
     {
         if (m_read)
             fclose(m_read);
-        if (m_write)
-            CloseHandle(m_write);
     }
 
     int results(lua_State*) override
@@ -390,37 +382,372 @@ private:
     void do_work() override
     {
         HANDLE rh = reinterpret_cast<HANDLE>(_get_osfhandle(fileno(m_read)));
-        HANDLE wh = m_write;
+        bool pending_cr = false;
 
         while (!is_canceled())
         {
             DWORD len;
-            if (!ReadFile(rh, m_buffer, sizeof_array(m_buffer), &len, nullptr))
+            if (!ReadFile(rh, m_data, sizeof_array(m_data), &len, nullptr) || !len)
                 break;
 
-            DWORD written;
-            if (!WriteFile(wh, m_buffer, len, &written, nullptr))
-                break;
-            if (written != len)
-                break;
+            if (m_binary)
+            {
+                m_buffer->write(m_data, len);
+            }
+            else
+            {
+                unsigned int out = 0;
+                for (DWORD i = 0; i < len; ++i)
+                {
+                    const char c = m_data[i];
+                    if (pending_cr && c != '\n')
+                        m_text[out++] = '\r';
+                    pending_cr = (c == '\r');
+                    if (!pending_cr)
+                        m_text[out++] = c;
+                }
+                m_buffer->write(m_text, out);
+            }
+
+            wake_idle();
         }
 
-        // Reset file pointer so the read handle can read from the beginning.
-        SetFilePointer(wh, 0, nullptr, FILE_BEGIN);
+        if (pending_cr)
+            m_buffer->write("\r", 1);
+        m_buffer->finish();
 
-        // Close the write handle since it's finished.
-        CloseHandle(m_write);
-        m_write = nullptr;
+        fclose(m_read);
+        m_read = nullptr;
     }
 
     FILE* m_read;
-    HANDLE m_write;
+    std::shared_ptr<stream_buffer> m_buffer;
+    const bool m_binary;
 
-    BYTE m_buffer[4096];
+    char m_data[4096];
+    char m_text[4096 + 1];
 };
 
 
 
+//------------------------------------------------------------------------------
+// A read-only file-like object for io.popenyield, which reads the command's
+// output from a stream_buffer as it arrives.  Reads block until enough output
+// is available; coroutines.lua wraps read, lines, and close so that coroutines
+// yield instead.
+#define LUA_POPENSTREAM "clink_popen_stream"
+
+//------------------------------------------------------------------------------
+struct popen_stream
+{
+    static popen_stream* make_new(lua_State* state, const std::shared_ptr<stream_buffer>& buffer);
+
+    intptr_t process_handle = 0;
+
+private:
+    static popen_stream* check(lua_State* state);
+    static bool get_needs(lua_State* state, int first, unsigned int& lines, unsigned int& bytes, bool& all);
+    bool read_line(lua_State* state, bool keep_eol);
+    bool read_chars(lua_State* state, unsigned int count);
+    bool read_number(lua_State* state);
+    void read_all(lua_State* state);
+    void close();
+
+    static int read(lua_State* state);
+    static int lines(lua_State* state);
+    static int lines_aux(lua_State* state);
+    static int close(lua_State* state);
+    static int ready(lua_State* state);
+    static int __gc(lua_State* state);
+    static int __tostring(lua_State* state);
+
+    std::shared_ptr<stream_buffer> m_buffer;
+};
+
+//------------------------------------------------------------------------------
+popen_stream* popen_stream::make_new(lua_State* state, const std::shared_ptr<stream_buffer>& buffer)
+{
+    popen_stream* ps = (popen_stream*)lua_newuserdata(state, sizeof(popen_stream));
+    new (ps) popen_stream();
+    ps->m_buffer = buffer;
+
+    static const luaL_Reg pslib[] =
+    {
+        {"read", read},
+        {"lines", lines},
+        {"close", close},
+        {"_ready", ready},
+        {"__gc", __gc},
+        {"__tostring", __tostring},
+        {nullptr, nullptr}
+    };
+
+    if (luaL_newmetatable(state, LUA_POPENSTREAM))
+    {
+        lua_pushvalue(state, -1);           // push metatable
+        lua_setfield(state, -2, "__index"); // metatable.__index = metatable
+        luaL_setfuncs(state, pslib, 0);     // add methods to new metatable
+    }
+    lua_setmetatable(state, -2);
+
+    return ps;
+}
+
+//------------------------------------------------------------------------------
+popen_stream* popen_stream::check(lua_State* state)
+{
+    popen_stream* ps = (popen_stream*)luaL_checkudata(state, 1, LUA_POPENSTREAM);
+    if (!ps->m_buffer)
+        luaL_error(state, "attempt to use a closed file");
+    return ps;
+}
+
+//------------------------------------------------------------------------------
+// Translates read formats into how much output must be available.
+bool popen_stream::get_needs(lua_State* state, int first, unsigned int& lines, unsigned int& bytes, bool& all)
+{
+    lines = 0;
+    bytes = 0;
+    all = false;
+
+    const int top = lua_gettop(state);
+    if (top < first)
+    {
+        lines = 1;
+        return true;
+    }
+
+    for (int n = first; n <= top; ++n)
+    {
+        if (lua_type(state, n) == LUA_TNUMBER)
+        {
+            bytes += max<unsigned int>(unsigned(lua_tointeger(state, n)), 1);
+            continue;
+        }
+
+        const char* p = lua_tostring(state, n);
+        if (!p)
+            return false;
+        if (*p == '*')
+            p++;
+        switch (*p)
+        {
+        case 'n':
+        case 'l':
+        case 'L':   lines++; break;
+        case 'a':   all = true; break;
+        default:    return false;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool popen_stream::read_line(lua_State* state, bool keep_eol)
+{
+    m_buffer->wait_readable(1, 0);
+
+    str_moveable line;
+    if (!m_buffer->read_line(line, keep_eol))
+        return false;
+
+    lua_pushlstring(state, line.c_str(), line.length());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool popen_stream::read_chars(lua_State* state, unsigned int count)
+{
+    m_buffer->wait_readable(0, max<unsigned int>(count, 1));
+
+    // Reading zero characters tests for end of file.
+    if (!count)
+    {
+        if (!m_buffer->available())
+            return false;
+        lua_pushliteral(state, "");
+        return true;
+    }
+
+    str_moveable chars;
+    if (!m_buffer->read(chars, count))
+        return false;
+
+    lua_pushlstring(state, chars.c_str(), chars.length());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool popen_stream::read_number(lua_State* state)
+{
+    m_buffer->wait_readable(1, 0);
+
+    // Skip leading whitespace, then take the longest run of characters that
+    // can be part of a number, and let Lua convert it.
+    str_moveable discard;
+    char c;
+    while (m_buffer->peek(&c, 1) && isspace((unsigned char)c))
+        m_buffer->read(discard, 1);
+
+    char buf[200];
+    const unsigned int len = m_buffer->peek(buf, sizeof_array(buf));
+    unsigned int n = 0;
+    while (n < len && buf[n] && (isxdigit((unsigned char)buf[n]) || strchr("+-.xXpP", buf[n])))
+        n++;
+    m_buffer->read(discard, n);
+
+    lua_pushlstring(state, buf, n);
+    int isnum;
+    const lua_Number num = lua_tonumberx(state, -1, &isnum);
+    lua_pop(state, 1);
+    if (!isnum)
+        return false;
+
+    lua_pushnumber(state, num);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void popen_stream::read_all(lua_State* state)
+{
+    m_buffer->wait_readable(0, 0, true/*all*/);
+
+    str_moveable all;
+    m_buffer->read(all, m_buffer->available());
+    lua_pushlstring(state, all.c_str(), all.length());
+}
+
+//------------------------------------------------------------------------------
+void popen_stream::close()
+{
+    if (m_buffer)
+    {
+        m_buffer->close();
+        m_buffer = nullptr;
+    }
+    if (process_handle)
+    {
+        CloseHandle(reinterpret_cast<HANDLE>(process_handle));
+        process_handle = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::read(lua_State* state)
+{
+    popen_stream* ps = check(state);
+
+    const int first = 2;
+    int nargs = lua_gettop(state) - 1;
+    if (nargs == 0)
+    {
+        if (!ps->read_line(state, false))
+            lua_pushnil(state);
+        return 1;
+    }
+
+    luaL_checkstack(state, nargs + LUA_MINSTACK, "too many arguments");
+
+    bool success = true;
+    int n;
+    for (n = first; nargs-- && success; n++)
+    {
+        if (lua_type(state, n) == LUA_TNUMBER)
+        {
+            success = ps->read_chars(state, unsigned(lua_tointeger(state, n)));
+            continue;
+        }
+
+        const char* p = lua_tostring(state, n);
+        luaL_argcheck(state, p, n, "invalid option");
+        if (*p == '*')
+            p++;
+        switch (*p)
+        {
+        case 'n':   success = ps->read_number(state); break;
+        case 'l':   success = ps->read_line(state, false); break;
+        case 'L':   success = ps->read_line(state, true); break;
+        case 'a':   ps->read_all(state); break;
+        default:    return luaL_argerror(state, n, "invalid format");
+        }
+    }
+
+    if (!success)
+        lua_pushnil(state);
+    return n - first;
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::lines(lua_State* state)
+{
+    check(state);
+
+    // The iterator holds the stream and the formats as upvalues.
+    const int count = lua_gettop(state);
+    luaL_argcheck(state, count <= LUA_MINSTACK - 2, LUA_MINSTACK - 2, "too many arguments");
+    lua_pushcclosure(state, lines_aux, count);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::lines_aux(lua_State* state)
+{
+    lua_settop(state, 0);
+    for (int n = 1; !lua_isnone(state, lua_upvalueindex(n)); ++n)
+        lua_pushvalue(state, lua_upvalueindex(n));
+    return read(state);
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::close(lua_State* state)
+{
+    popen_stream* ps = check(state);
+    ps->close();
+    return luaL_execresult(state, 0);
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.  Returns whether reading the given formats
+// can complete without blocking.
+int popen_stream::ready(lua_State* state)
+{
+    popen_stream* ps = check(state);
+
+    unsigned int lines, bytes;
+    bool all;
+    if (!get_needs(state, 2, lines, bytes, all))
+        return luaL_argerror(state, 2, "invalid format");
+
+    lua_pushboolean(state, ps->m_buffer->can_read(lines, bytes, all));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::__gc(lua_State* state)
+{
+    popen_stream* ps = (popen_stream*)luaL_checkudata(state, 1, LUA_POPENSTREAM);
+    if (ps)
+    {
+        ps->close();
+        ps->~popen_stream();
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int popen_stream::__tostring(lua_State* state)
+{
+    popen_stream* ps = (popen_stream*)luaL_checkudata(state, 1, LUA_POPENSTREAM);
+    if (!ps->m_buffer)
+        lua_pushliteral(state, "file (closed)");
+    else
+        lua_pushfstring(state, "file (%p)", ps);
+    return 1;
+}
+
+
+
 //------------------------------------------------------------------------------
 /// -name:  io.popenrw
 /// -ver:   1.1.42
@@ -544,66 +871,38 @@ private:
         return luaL_error(state, "invalid mode " LUA_QS
                           " (should match " LUA_QL("r?[bt]?") " or nil)", mode);
 
-    luaL_Stream* pr = nullptr;
+    popen_stream* ps = nullptr;
     luaL_YieldGuard* yg = nullptr;
     pipe_pair pipe_stdout;
 
-    pr = (luaL_Stream*)lua_newuserdata(state, sizeof(luaL_Stream));
-    luaL_setmetatable(state, LUA_FILEHANDLE);
-    pr->f = nullptr;
-    pr->closef = nullptr;
-
+    auto buffer = std::make_shared<stream_buffer>();
+    ps = popen_stream::make_new(state, buffer);
     yg = luaL_YieldGuard::make_new(state);
 
     bool failed = true;
-    FILE* temp_read = nullptr;
-    HANDLE temp_write = nullptr;
-    std::shared_ptr<popen_buffering> buffering;
-    popenrw_info* info = nullptr;
+    std::shared_ptr<popen_reader> reader;
 
     do
     {
         dbg_ignore_scope(snapshot, "Lua io_popenyield");
 
-        os::temp_file_mode tfmode = os::temp_file_mode::delete_on_close;
-        if (binary)
-            tfmode |= os::temp_file_mode::binary;
-        str<> name;
-        temp_read = os::create_temp_file(&name, "clk", ".tmp", tfmode);
-        if (!temp_read)
-            break;
-
-        temp_write = os::dup_handle(GetCurrentProcess(), reinterpret_cast<HANDLE>(_get_osfhandle(fileno(temp_read))), true/*inherit*/);
-        if (!temp_write)
-            break;
-
-        // The pipe and temp_write are both binary to simplify the thread's job.
+        // The pipe is binary; the reader translates line endings in text mode.
         if (!pipe_stdout.init(false/*write*/, true/*binary*/))
             break;
 
-        buffering = std::make_shared<popen_buffering>(pipe_stdout.local, temp_write);
+        reader = std::make_shared<popen_reader>(pipe_stdout.local, buffer, binary);
         pipe_stdout.transfer_local();
-        temp_write = nullptr;
-        if (!buffering->createthread())
+        if (!reader->createthread())
             break;
 
-        info = new popenrw_info;
         intptr_t process_handle = popenrw_internal(command, NULL, pipe_stdout.remote);
         if (!process_handle)
             break;
 
-        pr->f = temp_read;
-        pr->closef = &pclosefile;
-        temp_read = nullptr;
+        ps->process_handle = process_handle;
 
-        info->r = pr->f;
-        info->process_handle = process_handle;
-        info->async = true;
-        popenrw_info::add(info);
-        info = nullptr;
-
-        yg->init(buffering, command);
-        buffering->go();
+        yg->init(reader, command);
+        reader->go();
 
         failed = false;
     }
@@ -613,12 +912,7 @@ private:
     {
         errno_t e = errno;
 
-        if (temp_read)
-            fclose(temp_read);
-        if (temp_write)
-            CloseHandle(temp_write);
-        delete info;
-        buffering = nullptr;
+        reader = nullptr;
 
         if (failed)
             lua_pop(state, 2);
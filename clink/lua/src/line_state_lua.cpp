@@ -18,6 +18,8 @@ const line_state_lua::method line_state_lua::c_methods[] = {
     { "getwordinfo",            &get_word_info },
     { "getword",                &get_word },
     { "getendword",             &get_end_word },
+    { "getwords",               &get_words },
+    { "getwordinfos",           &get_word_infos },
     {}
 };
 
@@ -52,6 +54,45 @@ line_state_copy* make_line_state_copy(const line_state& line)
 
 
 
+//------------------------------------------------------------------------------
+static void push_word_info(lua_State* state, const word& word)
+{
+    lua_createtable(state, 0, 6);
+
+    lua_pushliteral(state, "offset");
+    lua_pushinteger(state, word.offset + 1);
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "length");
+    lua_pushinteger(state, word.length);
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "quoted");
+    lua_pushboolean(state, word.quoted);
+    lua_rawset(state, -3);
+
+    char delim[2] = { char(word.delim) };
+    lua_pushliteral(state, "delim");
+    lua_pushstring(state, delim);
+    lua_rawset(state, -3);
+
+    if (word.is_alias)
+    {
+        lua_pushliteral(state, "alias");
+        lua_pushboolean(state, true);
+        lua_rawset(state, -3);
+    }
+
+    if (word.is_redir_arg)
+    {
+        lua_pushliteral(state, "redir");
+        lua_pushboolean(state, true);
+        lua_rawset(state, -3);
+    }
+}
+
+
+
 //------------------------------------------------------------------------------
 line_state_lua::line_state_lua(const line_state& line)
 {
@@ -69,9 +110,42 @@ line_state_lua::line_state_lua(line_state_copy* copy)
 //------------------------------------------------------------------------------
 line_state_lua::~line_state_lua()
 {
+    if (m_cache_state)
+    {
+        luaL_unref(m_cache_state, LUA_REGISTRYINDEX, m_words_ref);
+        luaL_unref(m_cache_state, LUA_REGISTRYINDEX, m_infos_ref);
+    }
+
     delete m_copy;
 }
 
+//------------------------------------------------------------------------------
+bool line_state_lua::push_cached(lua_State* state, int ref) const
+{
+    if (ref == LUA_NOREF)
+        return false;
+
+    lua_rawgeti(state, LUA_REGISTRYINDEX, ref);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Keeps a reference to the table on top of the stack, leaving it on the stack.
+// The references are released through the main thread, since the coroutine
+// that built the table may be gone by the time this object is destroyed.
+void line_state_lua::cache(lua_State* state, int& ref)
+{
+    if (!m_cache_state)
+    {
+        lua_rawgeti(state, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        m_cache_state = lua_tothread(state, -1);
+        lua_pop(state, 1);
+    }
+
+    lua_pushvalue(state, -1);
+    ref = luaL_ref(state, LUA_REGISTRYINDEX);
+}
+
 //------------------------------------------------------------------------------
 /// -name:  line_state:getline
 /// -ver:   1.0.0
@@ -178,41 +252,7 @@ int line_state_lua::get_word_info(lua_State* state)
     if (index >= words.size())
         return 0;
 
-    const word& word = words[index];
-
-    lua_createtable(state, 0, 6);
-
-    lua_pushliteral(state, "offset");
-    lua_pushinteger(state, word.offset + 1);
-    lua_rawset(state, -3);
-
-    lua_pushliteral(state, "length");
-    lua_pushinteger(state, word.length);
-    lua_rawset(state, -3);
-
-    lua_pushliteral(state, "quoted");
-    lua_pushboolean(state, word.quoted);
-    lua_rawset(state, -3);
-
-    char delim[2] = { char(word.delim) };
-    lua_pushliteral(state, "delim");
-    lua_pushstring(state, delim);
-    lua_rawset(state, -3);
-
-    if (word.is_alias)
-    {
-        lua_pushliteral(state, "alias");
-        lua_pushboolean(state, true);
-        lua_rawset(state, -3);
-    }
-
-    if (word.is_redir_arg)
-    {
-        lua_pushliteral(state, "redir");
-        lua_pushboolean(state, true);
-        lua_rawset(state, -3);
-    }
-
+    push_word_info(state, words[index]);
     return 1;
 }
 
@@ -264,3 +304,82 @@ int line_state_lua::get_end_word(lua_State* state)
     lua_pushlstring(state, word.c_str(), word.length());
     return 1;
 }
+
+//------------------------------------------------------------------------------
+/// -name:  line_state:getwords
+/// -ver:   1.3.13
+/// -ret:   table
+/// Returns a table containing all of the words in the line, in order.  Each
+/// word is the same as what
+/// <a href="#line_state:getword">line_state:getword()</a> returns for its
+/// index, so quotes are omitted.
+///
+/// This is faster than calling
+/// <a href="#line_state:getword">line_state:getword()</a> once per word,
+/// especially for long lines.
+///
+/// Note:  The table is built once per line_state and the same table is returned
+/// by every call, so the table must not be modified.
+/// -show:  local words = line_state:getwords()
+/// -show:  for i = 1, #words do
+/// -show:  &nbsp;   print(i, words[i])
+/// -show:  end
+int line_state_lua::get_words(lua_State* state)
+{
+    if (push_cached(state, m_words_ref))
+        return 1;
+
+    const unsigned int count = m_line->get_word_count();
+    lua_createtable(state, count, 0);
+
+    str<32> word;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        word.clear();
+        m_line->get_word(i, word);
+        lua_pushlstring(state, word.c_str(), word.length());
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    cache(state, m_words_ref);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  line_state:getwordinfos
+/// -ver:   1.3.13
+/// -ret:   table
+/// Returns a table containing information about all of the words in the line,
+/// in order.  Each element is a table with the same scheme as what
+/// <a href="#line_state:getwordinfo">line_state:getwordinfo()</a> returns for
+/// its index.
+///
+/// This is faster than calling
+/// <a href="#line_state:getwordinfo">line_state:getwordinfo()</a> once per
+/// word, especially for long lines.
+///
+/// Note:  The tables are built once per line_state and the same tables are
+/// returned by every call, so the tables must not be modified.
+/// -show:  local infos = line_state:getwordinfos()
+/// -show:  for i = 1, #infos do
+/// -show:  &nbsp;   if infos[i].redir then
+/// -show:  &nbsp;       print(i, "is a redirection arg")
+/// -show:  &nbsp;   end
+/// -show:  end
+int line_state_lua::get_word_infos(lua_State* state)
+{
+    if (push_cached(state, m_infos_ref))
+        return 1;
+
+    const std::vector<word>& words = m_line->get_words();
+    lua_createtable(state, int(words.size()), 0);
+
+    for (unsigned int i = 0; i < words.size(); ++i)
+    {
+        push_word_info(state, words[i]);
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    cache(state, m_infos_ref);
+    return 1;
+}
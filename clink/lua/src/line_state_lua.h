@@ -28,10 +28,17 @@ public:
     int                 get_word_info(lua_State* state);
     int                 get_word(lua_State* state);
     int                 get_end_word(lua_State* state);
+    int                 get_words(lua_State* state);
+    int                 get_word_infos(lua_State* state);
 
 private:
+    bool                push_cached(lua_State* state, int ref) const;
+    void                cache(lua_State* state, int& ref);
     const line_state*   m_line;
     line_state_copy*    m_copy;
+    lua_State*          m_cache_state = nullptr;
+    int                 m_words_ref = LUA_NOREF;
+    int                 m_infos_ref = LUA_NOREF;
 
     friend class lua_bindable<line_state_lua>;
     static const char* const c_name;
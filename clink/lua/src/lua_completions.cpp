@@ -0,0 +1,270 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_completions.h"
+#include "lua_state.h"
+
+#include <core/globber.h>
+#include <core/log.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_transform.h>
+
+//------------------------------------------------------------------------------
+static const char c_registry_key[] = "clink_completions";
+static std::vector<std::shared_ptr<completions_manifest>> s_manifests;
+
+//------------------------------------------------------------------------------
+static void lower_name(const char* name, unsigned int len, str_base& out)
+{
+    str<> tmp;
+    tmp.concat(name, len);
+    wstr<> in(tmp.c_str());
+    wstr<> lower;
+    str_transform(in.c_str(), in.length(), lower, transform_mode::lower);
+    out = lower.c_str();
+}
+
+//------------------------------------------------------------------------------
+static bool get_dir_modified(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    out = data.ftLastWriteTime;
+    return true;
+}
+
+
+
+//------------------------------------------------------------------------------
+completions_manifest::completions_manifest(const char* dir, const FILETIME& modified)
+: m_dir(dir)
+, m_modified(modified)
+{
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const completions_manifest> completions_manifest::get(const char* script_dir)
+{
+    str<280> dir;
+    if (!os::get_full_path_name(script_dir, dir))
+        return nullptr;
+    path::append(dir, "completions");
+    path::normalise(dir);
+    path::maybe_strip_last_separator(dir);
+
+    auto iter = s_manifests.begin();
+    while (iter != s_manifests.end() && !dir.iequals((*iter)->get_dir()))
+        ++iter;
+
+    FILETIME modified;
+    if (!get_dir_modified(dir.c_str(), modified))
+    {
+        if (iter != s_manifests.end())
+            s_manifests.erase(iter);
+        return nullptr;
+    }
+
+    if (iter != s_manifests.end())
+    {
+        if (CompareFileTime(&modified, &(*iter)->m_modified) == 0)
+            return *iter;
+        s_manifests.erase(iter);
+    }
+
+    std::shared_ptr<completions_manifest> manifest(new completions_manifest(dir.c_str(), modified));
+    manifest->scan();
+    s_manifests.emplace_back(manifest);
+    return manifest;
+}
+
+//------------------------------------------------------------------------------
+void completions_manifest::scan()
+{
+    str_moveable buffer;
+    path::join(m_dir.c_str(), "*.lua", buffer);
+
+    globber lua_globs(buffer.c_str());
+    lua_globs.directories(false);
+
+    while (lua_globs.next(buffer))
+    {
+        const char* name = path::get_name(buffer.c_str());
+        const unsigned int len = unsigned(strlen(name));
+        if (len <= 4)
+            continue;
+
+        entry e;
+        lower_name(name, len - 4, e.name);
+        e.file = buffer.c_str();
+        m_entries.emplace_back(std::move(e));
+    }
+
+    LOG("Found %u deferred Lua scripts in '%s'", count(), get_dir());
+}
+
+
+
+//------------------------------------------------------------------------------
+static void push_registry_table(lua_State* state)
+{
+    lua_getfield(state, LUA_REGISTRYINDEX, c_registry_key);
+    if (lua_istable(state, -1))
+        return;
+
+    lua_pop(state, 1);
+    lua_newtable(state);
+    lua_pushvalue(state, -1);
+    lua_setfield(state, LUA_REGISTRYINDEX, c_registry_key);
+}
+
+//------------------------------------------------------------------------------
+// Registers the scripts in the completions subdirectory of script_dir.  When
+// more than one script directory has a script for the same command, the first
+// one registered wins.  Returns the number of scripts registered.
+unsigned int lua_completions_add_dir(lua_state& lua, const char* script_dir)
+{
+    const auto manifest = completions_manifest::get(script_dir);
+    if (!manifest)
+        return 0;
+
+    lua_State* state = lua.get_state();
+    save_stack_top ss(state);
+
+    push_registry_table(state);
+
+    unsigned int added = 0;
+    for (unsigned int i = 0; i < manifest->count(); ++i)
+    {
+        const auto& entry = manifest->get(i);
+        lua_getfield(state, -1, entry.name.c_str());
+        const bool exists = !lua_isnil(state, -1);
+        lua_pop(state, 1);
+        if (exists)
+            continue;
+
+        lua_pushlstring(state, entry.file.c_str(), entry.file.length());
+        lua_setfield(state, -2, entry.name.c_str());
+        added++;
+    }
+
+    return added;
+}
+
+//------------------------------------------------------------------------------
+// The registry table maps each name to the script file while it's deferred,
+// and to true or false once it has been loaded or has failed to load.
+static bool load_by_name(lua_State* state, const char* name)
+{
+    save_stack_top ss(state);
+
+    push_registry_table(state);
+    lua_getfield(state, -1, name);
+    if (!lua_isstring(state, -1))
+        return false;
+
+    str<280> file(lua_tostring(state, -1));
+    lua_pop(state, 1);
+
+    // Mark it before loading, in case the script refers to its own command.
+    lua_pushboolean(state, false);
+    lua_setfield(state, -2, name);
+
+    int err = luaL_loadfile(state, file.c_str());
+    if (err)
+    {
+        LOG("Failed to load '%s': %s", file.c_str(), lua_tostring(state, -1));
+        return false;
+    }
+
+    err = lua_state::pcall(state, 0, 0);
+    if (err)
+        return false;
+
+    lua_pushboolean(state, true);
+    lua_setfield(state, -2, name);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Loads the deferred script for command_word, if there is one and it hasn't
+// been loaded yet.  Like argmatcher lookups, this tries the file name and then
+// the file name without its extension if the extension is in %PATHEXT%.
+bool lua_completions_load(lua_State* state, const char* command_word)
+{
+    if (!command_word || !*command_word)
+        return false;
+
+    const char* name = path::get_name(command_word);
+    str<> lower;
+    lower_name(name, unsigned(strlen(name)), lower);
+    if (load_by_name(state, lower.c_str()))
+        return true;
+
+    const char* ext = path::get_extension(name);
+    if (ext && path::is_executable_extension(name))
+    {
+        lower_name(name, unsigned(ext - name), lower);
+        if (load_by_name(state, lower.c_str()))
+            return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void lua_completions_get_counts(lua_State* state, lua_completions_counts& out)
+{
+    memset(&out, 0, sizeof(out));
+
+    save_stack_top ss(state);
+
+    lua_getfield(state, LUA_REGISTRYINDEX, c_registry_key);
+    if (!lua_istable(state, -1))
+        return;
+
+    lua_pushnil(state);
+    while (lua_next(state, -2))
+    {
+        if (lua_isstring(state, -1))
+            out.deferred++;
+        else if (lua_toboolean(state, -1))
+            out.loaded++;
+        else
+            out.failed++;
+        lua_pop(state, 1);
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+int load_deferred_completion(lua_State* state)
+{
+    const char* command_word = checkstring(state, 1);
+    if (!command_word)
+        return 0;
+
+    lua_pushboolean(state, lua_completions_load(state, command_word));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+int get_completion_counts(lua_State* state)
+{
+    lua_completions_counts counts;
+    lua_completions_get_counts(state, counts);
+    lua_pushinteger(state, counts.deferred);
+    lua_pushinteger(state, counts.loaded);
+    lua_pushinteger(state, counts.failed);
+    return 3;
+}
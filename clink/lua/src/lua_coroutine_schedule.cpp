@@ -0,0 +1,309 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_coroutine_schedule.h"
+#include "lua_bindable.h"
+#include "lua_state.h"
+
+#include <algorithm>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+// Inserts or updates a timed coroutine, unparking it if necessary.
+void coroutine_schedule::set_due(unsigned int id, double due)
+{
+    auto parked = std::find(m_parked.begin(), m_parked.end(), id);
+    if (parked != m_parked.end())
+        m_parked.erase(parked);
+
+    auto iter = m_index.find(id);
+    if (iter != m_index.end())
+    {
+        const unsigned int index = iter->second;
+        const double old_due = m_heap[index].due;
+        m_heap[index].due = due;
+        if (due < old_due)
+            sift_up(index);
+        else
+            sift_down(index);
+        return;
+    }
+
+    const unsigned int index = unsigned(m_heap.size());
+    m_heap.push_back({ due, id });
+    m_index.emplace(id, index);
+    sift_up(index);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::park(unsigned int id)
+{
+    auto iter = m_index.find(id);
+    if (iter != m_index.end())
+        remove_at(iter->second);
+
+    if (std::find(m_parked.begin(), m_parked.end(), id) == m_parked.end())
+        m_parked.push_back(id);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::remove(unsigned int id)
+{
+    auto iter = m_index.find(id);
+    if (iter != m_index.end())
+        remove_at(iter->second);
+
+    auto parked = std::find(m_parked.begin(), m_parked.end(), id);
+    if (parked != m_parked.end())
+        m_parked.erase(parked);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::clear()
+{
+    m_heap.clear();
+    m_index.clear();
+    m_parked.clear();
+}
+
+//------------------------------------------------------------------------------
+// Gets the earliest due time of the timed coroutines.  Returns false if there
+// are none.
+bool coroutine_schedule::get_next_due(double& due) const
+{
+    if (m_heap.empty())
+        return false;
+    due = m_heap[0].due;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Collects the ids of the coroutines to resume:  the timed coroutines that are
+// due by now, in order of due time, followed by the parked coroutines.  Only
+// the due nodes and their immediate children are visited.
+void coroutine_schedule::get_ready(double now, std::vector<unsigned int>& out) const
+{
+    out.clear();
+
+    std::vector<node> due;
+    std::vector<unsigned int> pending;
+    if (!m_heap.empty() && m_heap[0].due <= now)
+        pending.push_back(0);
+
+    while (!pending.empty())
+    {
+        const unsigned int index = pending.back();
+        pending.pop_back();
+        due.push_back(m_heap[index]);
+
+        for (unsigned int child = index * 2 + 1; child <= index * 2 + 2; ++child)
+        {
+            if (child < m_heap.size() && m_heap[child].due <= now)
+                pending.push_back(child);
+        }
+    }
+
+    std::sort(due.begin(), due.end(), [] (const node& a, const node& b) {
+        return (a.due < b.due) || (a.due == b.due && a.id < b.id);
+    });
+
+    out.reserve(due.size() + m_parked.size());
+    for (const auto& n : due)
+        out.push_back(n.id);
+    out.insert(out.end(), m_parked.begin(), m_parked.end());
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::remove_at(unsigned int index)
+{
+    assert(index < m_heap.size());
+    m_index.erase(m_heap[index].id);
+
+    const unsigned int last = unsigned(m_heap.size() - 1);
+    if (index != last)
+    {
+        const node moved = m_heap[last];
+        m_heap.pop_back();
+        place(index, moved);
+        sift_up(index);
+        sift_down(m_index[moved.id]);
+    }
+    else
+    {
+        m_heap.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::sift_up(unsigned int index)
+{
+    const node n = m_heap[index];
+    while (index > 0)
+    {
+        const unsigned int parent = (index - 1) / 2;
+        if (!(n.due < m_heap[parent].due))
+            break;
+        place(index, m_heap[parent]);
+        index = parent;
+    }
+    place(index, n);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::sift_down(unsigned int index)
+{
+    const unsigned int size = unsigned(m_heap.size());
+    const node n = m_heap[index];
+    while (true)
+    {
+        unsigned int child = index * 2 + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && m_heap[child + 1].due < m_heap[child].due)
+            child++;
+        if (!(m_heap[child].due < n.due))
+            break;
+        place(index, m_heap[child]);
+        index = child;
+    }
+    place(index, n);
+}
+
+//------------------------------------------------------------------------------
+void coroutine_schedule::place(unsigned int index, const node& n)
+{
+    m_heap[index] = n;
+    m_index[n.id] = index;
+}
+
+
+
+//------------------------------------------------------------------------------
+class coroutine_schedule_lua
+    : public lua_bindable<coroutine_schedule_lua>
+{
+public:
+    int                 set_due(lua_State* state);
+    int                 park(lua_State* state);
+    int                 remove(lua_State* state);
+    int                 clear(lua_State* state);
+    int                 get_next_due(lua_State* state);
+    int                 get_ready(lua_State* state);
+    int                 get_count(lua_State* state);
+
+private:
+    coroutine_schedule  m_schedule;
+    std::vector<unsigned int> m_ready;
+
+    friend class lua_bindable<coroutine_schedule_lua>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
+
+//------------------------------------------------------------------------------
+const char* const coroutine_schedule_lua::c_name = "coroutine_schedule_lua";
+const coroutine_schedule_lua::method coroutine_schedule_lua::c_methods[] = {
+    { "setdue",                 &set_due },
+    { "park",                   &park },
+    { "remove",                 &remove },
+    { "clear",                  &clear },
+    { "nextdue",                &get_next_due },
+    { "ready",                  &get_ready },
+    { "count",                  &get_count },
+    {}
+};
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::set_due(lua_State* state)
+{
+    bool isnum;
+    const int id = checkinteger(state, 1, &isnum);
+    if (!isnum)
+        return 0;
+    const lua_Number due = checknumber(state, 2, &isnum);
+    if (!isnum)
+        return 0;
+
+    m_schedule.set_due(id, due);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::park(lua_State* state)
+{
+    bool isnum;
+    const int id = checkinteger(state, 1, &isnum);
+    if (!isnum)
+        return 0;
+
+    m_schedule.park(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::remove(lua_State* state)
+{
+    bool isnum;
+    const int id = checkinteger(state, 1, &isnum);
+    if (!isnum)
+        return 0;
+
+    m_schedule.remove(id);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::clear(lua_State* state)
+{
+    m_schedule.clear();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::get_next_due(lua_State* state)
+{
+    double due;
+    if (!m_schedule.get_next_due(due))
+        return 0;
+
+    lua_pushnumber(state, due);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::get_ready(lua_State* state)
+{
+    bool isnum;
+    const lua_Number now = checknumber(state, 1, &isnum);
+    if (!isnum)
+        return 0;
+
+    m_schedule.get_ready(now, m_ready);
+
+    lua_createtable(state, int(m_ready.size()), 0);
+    for (unsigned int i = 0; i < m_ready.size(); ++i)
+    {
+        lua_pushinteger(state, m_ready[i]);
+        lua_rawseti(state, -2, i + 1);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+int coroutine_schedule_lua::get_count(lua_State* state)
+{
+    lua_pushinteger(state, m_schedule.count());
+    lua_pushinteger(state, m_schedule.parked_count());
+    return 2;
+}
+
+
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+int new_coroutine_schedule(lua_State* state)
+{
+    coroutine_schedule_lua::make_new(state);
+    return 1;
+}
@@ -6,6 +6,8 @@
 #include "lua_state.h"
 
 #include <core/base.h>
+#include <core/os.h>
+#include <core/settings.h>
 
 #include <assert.h>
 
@@ -15,9 +17,52 @@ extern "C" {
 #include <lualib.h>
 }
 
+//------------------------------------------------------------------------------
+static setting_bool g_lua_idle_gc(
+    "lua.idle_gc",
+    "Collects Lua garbage while waiting for input",
+    "When enabled, Lua garbage collection happens mostly in small time slices\n"
+    "while waiting for input, and runs less often inside prompt filters, match\n"
+    "generators, classifiers, and so on.  This reduces latency spikes while\n"
+    "typing, at the cost of somewhat higher peak memory use.",
+    true);
+
+//------------------------------------------------------------------------------
+static const int c_default_gc_pause = 200;      // Lua's default.
+static const int c_keystroke_gc_pause = 400;    // Wait for 4x growth.
+static const int c_gc_step_kb = 16;
+static const int c_gc_min_growth_kb = 256;
+static const unsigned c_gc_delay_ms = 50;
+static const double c_gc_budget = 0.004;
+
 //------------------------------------------------------------------------------
 extern void set_yield_wake_event(HANDLE event);
 static lua_input_idle* s_idle = nullptr;
+static lua_gc_stats s_gc_stats = {};
+static double s_gc_step_start = 0;
+static bool s_in_idle = false;
+
+//------------------------------------------------------------------------------
+static void gc_step_hook(int begin)
+{
+    if (begin)
+    {
+        s_gc_step_start = os::clock();
+        return;
+    }
+
+    const double elapsed = os::clock() - s_gc_step_start;
+    if (s_in_idle)
+    {
+        s_gc_stats.idle_time += elapsed;
+        s_gc_stats.idle_steps++;
+    }
+    else
+    {
+        s_gc_stats.keystroke_time += elapsed;
+        s_gc_stats.keystroke_steps++;
+    }
+}
 
 //------------------------------------------------------------------------------
 void kick_idle()
@@ -32,11 +77,13 @@ lua_input_idle::lua_input_idle(lua_state& state)
 {
     assert(!s_idle);
     s_idle = this;
+    lua_gcstephook = gc_step_hook;
 }
 
 //------------------------------------------------------------------------------
 lua_input_idle::~lua_input_idle()
 {
+    lua_gcstephook = nullptr;
     s_idle = nullptr;
     set_yield_wake_event(nullptr);
 }
@@ -55,6 +102,11 @@ void lua_input_idle::reset()
 
     if (old_event)
         CloseHandle(old_event);
+
+    // When collecting while idle, let memory grow further before the
+    // collector starts a new cycle on its own inside a callback.
+    const int pause = g_lua_idle_gc.get() ? c_keystroke_gc_pause : c_default_gc_pause;
+    lua_gc(m_state.get_state(), LUA_GCSETPAUSE, pause);
 }
 
 //------------------------------------------------------------------------------
@@ -74,6 +126,19 @@ unsigned lua_input_idle::get_timeout()
 {
     m_iterations++;
 
+    unsigned timeout = get_coroutine_timeout();
+
+    // Once a collection cycle has started, keep going as soon as possible;
+    // otherwise wait briefly so a burst of typing isn't interrupted.
+    if (is_gc_due())
+        timeout = min<unsigned>(timeout, m_gc_in_cycle ? 0 : c_gc_delay_ms);
+
+    return timeout;
+}
+
+//------------------------------------------------------------------------------
+unsigned lua_input_idle::get_coroutine_timeout()
+{
     if (!is_enabled())
         return INFINITE;
 
@@ -105,9 +170,15 @@ void* lua_input_idle::get_waitevent()
 //------------------------------------------------------------------------------
 void lua_input_idle::on_idle()
 {
-    assert(m_enabled);
+    s_in_idle = true;
+
+    if (m_enabled)
+        resume_coroutines();
 
-    resume_coroutines();
+    if (is_gc_due())
+        collect_garbage();
+
+    s_in_idle = false;
 }
 
 //------------------------------------------------------------------------------
@@ -150,3 +221,84 @@ void lua_input_idle::resume_coroutines()
 
     m_state.pcall(state, 0, 0);
 }
+
+//------------------------------------------------------------------------------
+bool lua_input_idle::is_gc_due()
+{
+    if (!g_lua_idle_gc.get())
+        return false;
+
+    if (m_gc_in_cycle)
+        return true;
+
+    return lua_gc(m_state.get_state(), LUA_GCCOUNT, 0) >= m_gc_threshold_kb;
+}
+
+//------------------------------------------------------------------------------
+// Performs GC steps until the time budget is used up or the cycle finishes.
+// After a cycle finishes, the next one isn't due until memory use grows by a
+// quarter (or at least c_gc_min_growth_kb).
+void lua_input_idle::collect_garbage()
+{
+    lua_State* state = m_state.get_state();
+    const double start = os::clock();
+
+    m_gc_in_cycle = true;
+    do
+    {
+        s_gc_stats.idle_steps++;
+        if (lua_gc(state, LUA_GCSTEP, c_gc_step_kb))
+        {
+            const int kb = lua_gc(state, LUA_GCCOUNT, 0);
+            m_gc_threshold_kb = kb + max(kb / 4, c_gc_min_growth_kb);
+            m_gc_in_cycle = false;
+            s_gc_stats.idle_cycles++;
+            break;
+        }
+    }
+    while (os::clock() - start < c_gc_budget);
+
+    s_gc_stats.idle_time += os::clock() - start;
+}
+
+//------------------------------------------------------------------------------
+void lua_input_idle::get_gc_stats(lua_gc_stats& out)
+{
+    out = s_gc_stats;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+int get_gc_stats(lua_State* state)
+{
+    lua_gc_stats stats;
+    lua_input_idle::get_gc_stats(stats);
+
+    lua_createtable(state, 0, 6);
+
+    lua_pushliteral(state, "keystroke_ms");
+    lua_pushinteger(state, int(stats.keystroke_time * 1000));
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "keystroke_steps");
+    lua_pushinteger(state, stats.keystroke_steps);
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "idle_ms");
+    lua_pushinteger(state, int(stats.idle_time * 1000));
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "idle_steps");
+    lua_pushinteger(state, stats.idle_steps);
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "idle_cycles");
+    lua_pushinteger(state, stats.idle_cycles);
+    lua_rawset(state, -3);
+
+    lua_pushliteral(state, "memory_kb");
+    lua_pushinteger(state, lua_gc(state, LUA_GCCOUNT, 0));
+    lua_rawset(state, -3);
+
+    return 1;
+}
@@ -639,8 +639,9 @@ void lua_match_generator::filter_matches(char** matches, char completion_type, b
     {
         if (keep_typeless.find(*read) == keep_typeless.end())
         {
+            // Packed matches belong to the list's lookaside table.
             discarded = true;
-            free(*read);
+            free_match_hook(*read);
         }
         else
         {
@@ -661,7 +662,7 @@ void lua_match_generator::filter_matches(char** matches, char completion_type, b
     // If no matches, free the lcd as well.
     if (!matches[1])
     {
-        free(matches[0]);
+        free_match_hook(matches[0]);
         matches[0] = nullptr;
     }
 }
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_completions.h"
 #include "lua_script_loader.h"
 #include "rl_buffer_lua.h"
 #include "line_state_lua.h"
@@ -563,6 +564,10 @@ bool lua_state::send_oncommand_event(line_state& line, const char* command, bool
     lua_State* state = get_state();
     line_state_lua line_lua(line);
 
+    // The recognizer has seen the command, so load its deferred completion
+    // script (if any) before handlers see the event.
+    lua_completions_load(state, command);
+
     const char* type;
     if (!quoted && is_cmd_command(command))
         type = "command";
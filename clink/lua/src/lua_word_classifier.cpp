@@ -8,6 +8,7 @@
 #include "line_state_lua.h"
 
 #include <core/base.h>
+#include <core/trace.h>
 #include <lib/line_state.h>
 #include <lib/word_classifications.h>
 
@@ -57,6 +58,8 @@ lua_word_classifier::lua_word_classifier(lua_state& state)
 //------------------------------------------------------------------------------
 void lua_word_classifier::classify(const std::vector<line_state>& commands, word_classifications& classifications)
 {
+    TRACE_SCOPE("classify words");
+
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
 
@@ -6,14 +6,23 @@
 #include "lua_state.h"
 
 #include <core/base.h>
+#include <core/globber.h>
+#include <core/path.h>
+#include <core/settings.h>
 #include <core/str.h>
 #include <lib/matches.h>
 
+//------------------------------------------------------------------------------
+extern setting_bool g_glob_hidden;
+extern setting_bool g_glob_system;
+
 //------------------------------------------------------------------------------
 const char* const match_builder_lua::c_name = "match_builder_lua";
 const match_builder_lua::method match_builder_lua::c_methods[] = {
     { "addmatch",           &add_match },
     { "addmatches",         &add_matches },
+    { "addmatchlist",       &add_match_list },
+    { "addglob",            &add_glob },
     { "isempty",            &is_empty },
     { "setappendcharacter", &set_append_character },
     { "setsuppressappend",  &set_suppress_append },
@@ -287,6 +296,7 @@ int match_builder_lua::add_matches(lua_State* state)
 
     int count = 0;
     int total = int(lua_rawlen(state, 1));
+    m_builder->reserve(total);
     for (int i = 1; i <= total; ++i)
     {
         lua_rawgeti(state, 1, i);
@@ -299,6 +309,155 @@ int match_builder_lua::add_matches(lua_State* state)
     return 2;
 }
 
+//------------------------------------------------------------------------------
+/// -name:  builder:addmatchlist
+/// -ver:   1.3.13
+/// -arg:   matches:table
+/// -arg:   [spec:string|table]
+/// -ret:   integer, boolean
+/// Adds a table of match strings which all share the same type and append
+/// behavior.  Returns the number of matches added and a boolean indicating if
+/// all matches were added successfully.
+///
+/// This is faster than <a href="#builder:addmatches">builder:addmatches()</a>
+/// for large numbers of matches, because the <span class="arg">spec</span> is
+/// only parsed once and room for all the matches is reserved up front.
+///
+/// The <span class="arg">spec</span> argument can be a match type string (see
+/// <a href="#builder:addmatch">builder:addmatch()</a>), or a table with the
+/// following scheme:
+/// -show:  {
+/// -show:  &nbsp;   type            = "..."    -- [string] OPTIONAL; the match type.
+/// -show:  &nbsp;   appendchar      = "..."    -- [string] OPTIONAL; character to append after each match.
+/// -show:  &nbsp;   suppressappend  = t_or_f   -- [boolean] OPTIONAL; whether to suppress appending a character after each match.
+/// -show:  }
+///
+/// Elements of <span class="arg">matches</span> which are not strings are
+/// skipped.
+/// -show:  builder:addmatchlist({"abc", "def"}, "word")
+/// -show:  builder:addmatchlist({"name=", "value="}, { type="arg", suppressappend=true })
+int match_builder_lua::add_match_list(lua_State* state)
+{
+    if (lua_gettop(state) <= 0 || !lua_istable(state, 1))
+    {
+        lua_pushinteger(state, 0);
+        lua_pushboolean(state, 0);
+        return 2;
+    }
+
+    match_desc desc(nullptr, nullptr, nullptr, match_type::none);
+    if (lua_istable(state, 2))
+    {
+        lua_pushliteral(state, "type");
+        lua_rawget(state, 2);
+        if (lua_isstring(state, -1))
+            desc.type = to_match_type(lua_tostring(state, -1));
+        lua_pop(state, 1);
+
+        lua_pushliteral(state, "appendchar");
+        lua_rawget(state, 2);
+        if (lua_isstring(state, -1))
+            desc.append_char = *lua_tostring(state, -1);
+        lua_pop(state, 1);
+
+        lua_pushliteral(state, "suppressappend");
+        lua_rawget(state, 2);
+        if (lua_isboolean(state, -1))
+            desc.suppress_append = lua_toboolean(state, -1);
+        lua_pop(state, 1);
+    }
+    else
+    {
+        const char* type_str = optstring(state, 2, "");
+        if (!type_str)
+            return 0;
+        desc.type = to_match_type(type_str);
+    }
+
+    int count = 0;
+    const int total = int(lua_rawlen(state, 1));
+    m_builder->reserve(total);
+    for (int i = 1; i <= total; ++i)
+    {
+        lua_rawgeti(state, 1, i);
+        if (lua_isstring(state, -1))
+        {
+            desc.match = lua_tostring(state, -1);
+            count += !!m_builder->add_match(desc);
+        }
+        lua_pop(state, 1);
+    }
+
+    lua_pushinteger(state, count);
+    lua_pushboolean(state, count == total);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  builder:addglob
+/// -ver:   1.3.13
+/// -arg:   globpattern:string
+/// -arg:   [root:string]
+/// -arg:   [dirsonly:boolean]
+/// -ret:   integer
+/// Adds files and/or directories matching <span class="arg">globpattern</span>
+/// as matches, and returns the number of matches added.  Each match gets the
+/// same type that <a href="#os.globfiles">os.globfiles()</a> reports for it,
+/// e.g. "file,hidden" or "dir,link".
+///
+/// This is equivalent to adding the results from
+/// <code>os.globfiles(globpattern, true)</code> one by one, but is much faster
+/// because it doesn't need to build a table of results.
+///
+/// When <span class="arg">root</span> is provided, it is joined in front of
+/// each file name (the glob results are only the file names).
+///
+/// When <span class="arg">dirsonly</span> is true, only directories are added,
+/// as with <a href="#os.globdirs">os.globdirs()</a>.
+///
+/// Note: unlike <a href="#os.globfiles">os.globfiles()</a>, this does not yield
+/// periodically when used in a coroutine.
+/// -show:  local root = path.getdirectory(word) or ""
+/// -show:  builder:addglob(word.."*", root)
+int match_builder_lua::add_glob(lua_State* state)
+{
+    const char* mask = checkstring(state, 1);
+    const char* root = optstring(state, 2, "");
+    if (!mask || !root)
+        return 0;
+    const bool dirs_only = lua_toboolean(state, 3) != 0;
+
+    globber globber(mask);
+    globber.files(!dirs_only);
+    globber.hidden(g_glob_hidden.get());
+    globber.system(g_glob_system.get());
+
+    // The parent directory is needed to check whether symlinks are orphaned.
+    str_moveable parent(mask);
+    path::to_parent(parent, nullptr);
+    const unsigned int parent_len = parent.length();
+
+    str_moveable match(root);
+    const unsigned int root_len = match.length();
+
+    int count = 0;
+    str<288> file;
+    globber::extrainfo info;
+    while (globber.next(file, false, &info))
+    {
+        path::append(parent, file.c_str());
+        const match_type type = to_match_type(info.st_mode, info.attr, parent.c_str());
+        parent.truncate(parent_len);
+
+        match.truncate(root_len);
+        path::append(match, file.c_str());
+        count += !!m_builder->add_match(match.c_str(), type);
+    }
+
+    lua_pushinteger(state, count);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 bool match_builder_lua::add_match_impl(lua_State* state, int stack_index, match_type type)
 {
@@ -7,6 +7,7 @@
 #include "yield.h"
 
 #include <core/base.h>
+#include <core/dir_walker.h>
 #include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -26,14 +27,14 @@ extern "C" {
 #include <memory>
 
 //------------------------------------------------------------------------------
-static setting_bool g_glob_hidden(
+setting_bool g_glob_hidden(
     "files.hidden",
     "Include hidden files",
     "Includes or excludes files with the 'hidden' attribute set when generating\n"
     "file lists.",
     true);
 
-static setting_bool g_glob_system(
+setting_bool g_glob_system(
     "files.system",
     "Include system files",
     "Includes or excludes files with the 'system' attribute set when generating\n"
@@ -175,6 +176,64 @@ int globber_lua::close(lua_State* state)
 
 
 
+//------------------------------------------------------------------------------
+class dir_walker_lua
+    : public lua_bindable<dir_walker_lua>
+{
+public:
+                        dir_walker_lua(const char* root, const dir_walk_options* options);
+    int                 isdone(lua_State* state);
+    int                 results(lua_State* state);
+    int                 cancel(lua_State* state);
+
+private:
+    dir_walker          m_walker;
+
+    friend class lua_bindable<dir_walker_lua>;
+    static const char* const c_name;
+    static const method c_methods[];
+};
+
+//------------------------------------------------------------------------------
+const char* const dir_walker_lua::c_name = "dir_walker_lua";
+const dir_walker_lua::method dir_walker_lua::c_methods[] = {
+    { "isdone",                 &isdone },
+    { "results",                &results },
+    { "cancel",                 &cancel },
+    {}
+};
+
+//------------------------------------------------------------------------------
+dir_walker_lua::dir_walker_lua(const char* root, const dir_walk_options* options)
+: m_walker(root, *options)
+{
+    m_walker.start();
+}
+
+//------------------------------------------------------------------------------
+int dir_walker_lua::isdone(lua_State* state)
+{
+    lua_pushboolean(state, m_walker.is_done());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int push_walk_results(lua_State* state, const dir_walker& walker);
+int dir_walker_lua::results(lua_State* state)
+{
+    m_walker.wait();
+    return push_walk_results(state, m_walker);
+}
+
+//------------------------------------------------------------------------------
+int dir_walker_lua::cancel(lua_State* state)
+{
+    m_walker.cancel();
+    return 0;
+}
+
+
+
 //------------------------------------------------------------------------------
 struct execute_thread : public yield_thread
 {
@@ -579,6 +638,147 @@ int glob_files(lua_State* state)
     return glob_impl(state, false);
 }
 
+//------------------------------------------------------------------------------
+static bool get_walk_options(lua_State* state, dir_walk_options& options)
+{
+    options.hidden = g_glob_hidden.get();
+    options.system = g_glob_system.get();
+
+    if (lua_isnoneornil(state, 2))
+        return true;
+    if (!lua_istable(state, 2))
+        return false;
+
+    lua_getfield(state, 2, "depth");
+    if (lua_isnumber(state, -1))
+        options.max_depth = max<int>(int(lua_tointeger(state, -1)), 0);
+    lua_pop(state, 1);
+
+    lua_getfield(state, 2, "limit");
+    if (lua_isnumber(state, -1))
+        options.max_entries = max<int>(int(lua_tointeger(state, -1)), 0);
+    lua_pop(state, 1);
+
+    static const struct { const char* name; bool dir_walk_options::* member; } c_flags[] =
+    {
+        { "files", &dir_walk_options::files },
+        { "dirs", &dir_walk_options::directories },
+        { "hidden", &dir_walk_options::hidden },
+        { "system", &dir_walk_options::system },
+    };
+    for (const auto& flag : c_flags)
+    {
+        lua_getfield(state, 2, flag.name);
+        if (!lua_isnil(state, -1))
+            options.*flag.member = !!lua_toboolean(state, -1);
+        lua_pop(state, 1);
+    }
+
+    lua_getfield(state, 2, "pattern");
+    if (lua_isstring(state, -1))
+        options.pattern = lua_tostring(state, -1);
+    lua_pop(state, 1);
+
+    lua_getfield(state, 2, "ignore");
+    if (lua_istable(state, -1))
+    {
+        const int count = int(lua_rawlen(state, -1));
+        for (int i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(state, -1, i);
+            if (lua_isstring(state, -1))
+                options.ignore.emplace_back(lua_tostring(state, -1));
+            lua_pop(state, 1);
+        }
+    }
+    lua_pop(state, 1);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static int push_walk_results(lua_State* state, const dir_walker& walker)
+{
+    std::vector<dir_walk_entry> entries;
+    walker.get_entries(entries);
+
+    lua_createtable(state, int(entries.size()), 0);
+    int i = 1;
+    for (const auto& entry : entries)
+    {
+        lua_pushlstring(state, entry.path.c_str(), entry.path.length());
+        lua_rawseti(state, -2, i++);
+    }
+
+    lua_pushboolean(state, walker.is_truncated());
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  os.walkdir
+/// -ver:   1.3.13
+/// -arg:   dir:string
+/// -arg:   [options:table]
+/// -ret:   table, boolean
+/// Collects the files and directories under <span class="arg">dir</span>,
+/// descending into subdirectories, and returns them in a table of strings.
+/// The paths are relative to <span class="arg">dir</span>, and directories
+/// have a trailing path separator.  Subdirectories are enumerated in parallel,
+/// but the results are always in the same order:  sorted by name within each
+/// directory, with each subdirectory's contents following the subdirectory.
+///
+/// The second return value is true if the results were truncated because
+/// there were more than the limit (see below).
+///
+/// The optional <span class="arg">options</span> table can contain any of the
+/// following fields:
+/// -show:  local t, truncated = os.walkdir(dir, {
+/// -show:  &nbsp;   depth = 8,          -- [integer] Levels of subdirectories to descend (0 is just dir).
+/// -show:  &nbsp;   limit = 10000,      -- [integer] Maximum number of entries to return.
+/// -show:  &nbsp;   files = true,       -- [boolean] Include files.
+/// -show:  &nbsp;   dirs = true,        -- [boolean] Include directories (they're descended regardless).
+/// -show:  &nbsp;   hidden = nil,       -- [boolean] Include hidden files and dirs (default is the files.hidden setting).
+/// -show:  &nbsp;   system = nil,       -- [boolean] Include system files and dirs (default is the files.system setting).
+/// -show:  &nbsp;   pattern = "*.mk",   -- [string] Only include names matching this wildcard.
+/// -show:  &nbsp;   ignore = { ".git", "node_modules" }, -- [table] Skip directories matching these wildcards.
+/// -show:  })
+/// Symlinks and junctions to directories are included, but are not descended
+/// into.
+///
+/// When this is used in a coroutine it yields until the results are ready.
+int walk_dir(lua_State* state)
+{
+    const char* root = checkstring(state, 1);
+    if (!root)
+        return 0;
+
+    dir_walk_options options;
+    if (!get_walk_options(state, options))
+        return luaL_argerror(state, 2, "must be a table or nil");
+
+    dir_walker walker(root, options);
+    walker.start();
+    walker.wait();
+    return push_walk_results(state, walker);
+}
+
+//------------------------------------------------------------------------------
+int make_dir_walker(lua_State* state)
+{
+    const char* root = checkstring(state, 1);
+    if (!root)
+        return 0;
+
+    dir_walk_options options;
+    if (!get_walk_options(state, options))
+        return luaL_argerror(state, 2, "must be a table or nil");
+
+    if (!dir_walker_lua::make_new(state, root, &options))
+        return 0;
+
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 int make_dir_globber(lua_State* state)
 {
@@ -1325,6 +1525,8 @@ void os_lua_initialise(lua_state& lua)
         { "_globfiles",  &glob_files }, // Public os.globfiles method is in core.lua.
         { "_makedirglobber", &make_dir_globber },
         { "_makefileglobber", &make_file_globber },
+        { "_walkdir",    &walk_dir },   // Public os.walkdir method is in core.lua.
+        { "_makedirwalker", &make_dir_walker },
     };
 
     lua_State* state = lua.get_state();
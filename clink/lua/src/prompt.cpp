@@ -8,6 +8,7 @@
 #include <core/str.h>
 #include <core/str_iter.h>
 #include <core/os.h>
+#include <core/trace.h>
 #include <lib/line_buffer.h>
 #include "lua_script_loader.h"
 #include "lua_state.h"
@@ -397,6 +398,15 @@ void prompt_filter::filter(const char* in, str_base& out)
 //------------------------------------------------------------------------------
 void prompt_filter::filter(const char* in, const char* rin, str_base& out, str_base& rout, bool transient, bool final)
 {
+    TRACE_SCOPE(transient ? "filter transient prompt" : "filter prompt");
+
+    // Reuse the previous result if none of the inputs that the prompt filters
+    // declared they depend on have changed.
+    fingerprint fp;
+    const bool memoise = !transient && get_fingerprint(in, rin, fp);
+    if (memoise && m_memo.find(fp.get(), out, rout))
+        return;
+
     lua_State* state = m_lua.get_state();
 
     int top = lua_gettop(state);
@@ -425,21 +435,98 @@ void prompt_filter::filter(const char* in, const char* rin, str_base& out, str_b
     }
 
     rollback<bool> rb(s_filtering, true);
-    if (m_lua.pcall(state, 5, 2) != 0)
+    if (m_lua.pcall(state, 5, 3) != 0)
     {
         lua_pop(state, 2);
         return;
     }
 
     // Collect the filtered prompt.
-    const char* prompt = lua_tostring(state, -2);
-    const char* rprompt = lua_tostring(state, -1);
+    const char* prompt = lua_tostring(state, -3);
+    const char* rprompt = lua_tostring(state, -2);
     out = prompt;
     rout = rprompt;
 
+    // The result can't be reused if it's waiting for a prompt coroutine.
+    if (memoise && prompt && lua_toboolean(state, -1))
+        m_memo.store(fp.get(), prompt, rprompt);
+
     lua_settop(state, top);
 }
 
+//------------------------------------------------------------------------------
+// Returns false unless every prompt filter has declared its dependencies.
+bool prompt_filter::get_fingerprint(const char* in, const char* rin, fingerprint& fp)
+{
+    lua_State* state = m_lua.get_state();
+    save_stack_top ss(state);
+
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_get_prompt_dependencies");
+    lua_rawget(state, -2);
+
+    if (m_lua.pcall(state, 0, 1) != 0 || !lua_istable(state, -1))
+        return false;
+
+    fp.add(in);
+    fp.add(rin);
+
+    // The prompt filters themselves, in order.
+    lua_getfield(state, -1, "filters");
+    if (lua_istable(state, -1))
+    {
+        const int count = int(lua_rawlen(state, -1));
+        fp.add((long long)count);
+        for (int i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(state, -1, i);
+            fp.add((long long)lua_tointeger(state, -1));
+            lua_pop(state, 1);
+        }
+    }
+    lua_pop(state, 1);
+
+    lua_getfield(state, -1, "cwd");
+    if (lua_toboolean(state, -1))
+        fp.add_cwd();
+    lua_pop(state, 1);
+
+    lua_getfield(state, -1, "exitcode");
+    if (lua_toboolean(state, -1))
+        fp.add((long long)os::get_errorlevel());
+    lua_pop(state, 1);
+
+    lua_getfield(state, -1, "env");
+    if (lua_istable(state, -1))
+    {
+        const int count = int(lua_rawlen(state, -1));
+        for (int i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(state, -1, i);
+            if (const char* name = lua_tostring(state, -1))
+                fp.add_env(name);
+            lua_pop(state, 1);
+        }
+    }
+    lua_pop(state, 1);
+
+    lua_getfield(state, -1, "paths");
+    if (lua_istable(state, -1))
+    {
+        const int count = int(lua_rawlen(state, -1));
+        for (int i = 1; i <= count; ++i)
+        {
+            lua_rawgeti(state, -1, i);
+            if (const char* path = lua_tostring(state, -1))
+                fp.add_path_stamp(path);
+            lua_pop(state, 1);
+        }
+    }
+    lua_pop(state, 1);
+
+    return true;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -57,7 +57,10 @@ suggester::suggester(lua_state& lua)
 //------------------------------------------------------------------------------
 bool suggester::suggest(line_state& line, matches* matches, int generation_id)
 {
-    s_toolkit.reset();
+    // Keep the toolkit for the same generation id, since a coroutine may still
+    // be generating matches into it (e.g. for progressive completion).
+    if (s_toolkit && s_toolkit->get_generation_id() != generation_id)
+        s_toolkit.reset();
 
     if (!line.get_length())
     {
@@ -92,7 +95,8 @@ nosuggest:
     }
     else
     {
-        s_toolkit = make_match_builder_toolkit(generation_id, line.get_end_word_offset());
+        if (!s_toolkit)
+            s_toolkit = make_match_builder_toolkit(generation_id, line.get_end_word_offset());
 
         // These can't be bound to stack objects because they must stay valid
         // for the duration of the coroutine.
@@ -109,3 +113,32 @@ nosuggest:
     const bool cancelled = lua_isboolean(state, -1) && lua_toboolean(state, -1);
     return !cancelled;
 }
+
+//------------------------------------------------------------------------------
+bool suggester::generate_async(line_state& line, int generation_id)
+{
+    // Start a coroutine to generate matches in the background.  The line
+    // editor receives them in batches as the coroutine yields, and then the
+    // complete set when the coroutine finishes.
+    if (!s_toolkit || s_toolkit->get_generation_id() != generation_id)
+        s_toolkit = make_match_builder_toolkit(generation_id, line.get_end_word_offset());
+
+    lua_State* state = m_lua.get_state();
+    save_stack_top ss(state);
+
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_start_match_generate");
+    lua_rawget(state, -2);
+
+    // These can't be bound to stack objects because they must stay valid for
+    // the duration of the coroutine.
+    line_state_lua::make_new(state, make_line_state_copy(line));
+    matches_lua::make_new(state, s_toolkit);
+    match_builder_lua::make_new(state, s_toolkit);
+    lua_pushinteger(state, generation_id);
+
+    if (m_lua.pcall(state, 4, 1) != 0)
+        return false;
+
+    return lua_toboolean(state, -1);
+}
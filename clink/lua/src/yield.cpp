@@ -112,6 +112,15 @@ bool yield_thread::is_canceled() const
     return !!m_cancelled;
 }
 
+//------------------------------------------------------------------------------
+// Lets the input loop resume coroutines before the thread has finished, e.g.
+// to consume partial results.
+void yield_thread::wake_idle()
+{
+    if (m_wake_event)
+        SetEvent(m_wake_event);
+}
+
 //------------------------------------------------------------------------------
 unsigned __stdcall yield_thread::threadproc(void *arg)
 {
@@ -29,6 +29,7 @@ struct yield_thread : public std::enable_shared_from_this<yield_thread>
 
 protected:
     bool            is_canceled() const;
+    void            wake_idle();
 
 private:
     virtual void    do_work() = 0;
@@ -0,0 +1,100 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <core/path.h>
+#include <lua/lua_completions.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+static const char* completions_fs[] = {
+    "completions/lazycmd.lua",
+    "completions/broken.lua",
+    "completions/unused.lua",
+    nullptr,
+};
+
+//------------------------------------------------------------------------------
+static void write_script(const char* root, const char* name, const char* script)
+{
+    str<280> file;
+    path::join(root, "completions", file);
+    path::append(file, name);
+
+    FILE* f = fopen(file.c_str(), "wt");
+    REQUIRE(f);
+    fputs(script, f);
+    fclose(f);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua deferred completions")
+{
+    fs_fixture fs(completions_fs);
+
+    write_script(fs.get_root(), "lazycmd.lua", "clink.argmatcher('lazycmd'):addarg('alpha', 'beta')\n");
+    write_script(fs.get_root(), "broken.lua", "this is not lua\n");
+    write_script(fs.get_root(), "unused.lua", "clink.argmatcher('unused'):addarg('gamma')\n");
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+
+    line_editor_tester tester;
+    tester.get_editor()->set_generator(lua_generator);
+
+    REQUIRE(lua_completions_add_dir(lua, fs.get_root()) == 3);
+
+    // Adding the same directory again doesn't register anything new, and uses
+    // the cached manifest.
+    const auto manifest = completions_manifest::get(fs.get_root());
+    REQUIRE(manifest);
+    REQUIRE(manifest->count() == 3);
+    REQUIRE(completions_manifest::get(fs.get_root()) == manifest);
+    REQUIRE(lua_completions_add_dir(lua, fs.get_root()) == 0);
+
+    lua_completions_counts counts;
+    lua_completions_get_counts(lua.get_state(), counts);
+    REQUIRE(counts.deferred == 3);
+    REQUIRE(counts.loaded == 0);
+    REQUIRE(counts.failed == 0);
+
+    SECTION("Load on use")
+    {
+        tester.set_input("lazycmd ");
+        tester.set_expected_matches("alpha", "beta");
+        tester.run();
+
+        lua_completions_get_counts(lua.get_state(), counts);
+        REQUIRE(counts.deferred == 2);
+        REQUIRE(counts.loaded == 1);
+
+        // Once loaded, the argmatcher is found without loading again.
+        tester.set_input("LazyCmd.exe b");
+        tester.set_expected_matches("beta");
+        tester.run();
+
+        lua_completions_get_counts(lua.get_state(), counts);
+        REQUIRE(counts.loaded == 1);
+    }
+
+    SECTION("Executable extension")
+    {
+        tester.set_input("lazycmd.exe a");
+        tester.set_expected_matches("alpha");
+        tester.run();
+    }
+
+    SECTION("Failure")
+    {
+        REQUIRE(!lua_completions_load(lua.get_state(), "broken"));
+        REQUIRE(!lua_completions_load(lua.get_state(), "broken"));
+
+        lua_completions_get_counts(lua.get_state(), counts);
+        REQUIRE(counts.deferred == 2);
+        REQUIRE(counts.failed == 1);
+    }
+}
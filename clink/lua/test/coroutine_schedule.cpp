@@ -0,0 +1,126 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_coroutine_schedule.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Coroutine schedule: due order")
+{
+    coroutine_schedule schedule;
+    std::vector<unsigned int> ready;
+    double due;
+
+    REQUIRE(schedule.empty());
+    REQUIRE(!schedule.get_next_due(due));
+
+    schedule.set_due(1, 3.0);
+    schedule.set_due(2, 1.0);
+    schedule.set_due(3, 2.0);
+    schedule.set_due(4, 10.0);
+    REQUIRE(schedule.count() == 4);
+    REQUIRE(schedule.get_next_due(due));
+    REQUIRE(due == 1.0);
+
+    // Nothing is due yet.
+    schedule.get_ready(0.5, ready);
+    REQUIRE(ready.empty());
+
+    // Only the due coroutines are collected, in order of due time.
+    schedule.get_ready(3.0, ready);
+    REQUIRE(ready.size() == 3);
+    REQUIRE(ready[0] == 2);
+    REQUIRE(ready[1] == 3);
+    REQUIRE(ready[2] == 1);
+
+    // Rescheduling moves a coroutine later.
+    schedule.set_due(2, 5.0);
+    REQUIRE(schedule.get_next_due(due));
+    REQUIRE(due == 2.0);
+    REQUIRE(schedule.count() == 4);
+
+    schedule.remove(3);
+    schedule.remove(1);
+    REQUIRE(schedule.get_next_due(due));
+    REQUIRE(due == 5.0);
+
+    schedule.get_ready(20.0, ready);
+    REQUIRE(ready.size() == 2);
+    REQUIRE(ready[0] == 2);
+    REQUIRE(ready[1] == 4);
+
+    schedule.clear();
+    REQUIRE(schedule.empty());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Coroutine schedule: parked")
+{
+    coroutine_schedule schedule;
+    std::vector<unsigned int> ready;
+    double due;
+
+    schedule.set_due(1, 1.0);
+    schedule.set_due(2, 2.0);
+    schedule.park(1);
+    REQUIRE(schedule.count() == 2);
+    REQUIRE(schedule.parked_count() == 1);
+
+    // Parked coroutines don't affect the next due time...
+    REQUIRE(schedule.get_next_due(due));
+    REQUIRE(due == 2.0);
+
+    // ...but are always ready, after the timed ones.
+    schedule.get_ready(0.0, ready);
+    REQUIRE(ready.size() == 1);
+    REQUIRE(ready[0] == 1);
+    schedule.get_ready(2.0, ready);
+    REQUIRE(ready.size() == 2);
+    REQUIRE(ready[0] == 2);
+    REQUIRE(ready[1] == 1);
+
+    // Setting a due time unparks it.
+    schedule.set_due(1, 0.5);
+    REQUIRE(schedule.parked_count() == 0);
+    REQUIRE(schedule.get_next_due(due));
+    REQUIRE(due == 0.5);
+
+    schedule.park(2);
+    schedule.remove(2);
+    REQUIRE(schedule.count() == 1);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Coroutine schedule: fake clock")
+{
+    coroutine_schedule schedule;
+    std::vector<unsigned int> ready;
+    double due;
+
+    // Coroutine n runs every n ticks.
+    const unsigned int num = 50;
+    for (unsigned int id = 1; id <= num; ++id)
+        schedule.set_due(id, 0.0);
+
+    unsigned int resumed[num + 1] = {};
+    for (double now = 0.0; now < 100.0; now += 1.0)
+    {
+        schedule.get_ready(now, ready);
+        for (unsigned int id : ready)
+        {
+            resumed[id]++;
+            schedule.set_due(id, now + id);
+        }
+
+        // The wait is always until the earliest due coroutine.
+        REQUIRE(schedule.get_next_due(due));
+        REQUIRE(due > now);
+        REQUIRE(due <= now + 1.0);
+    }
+
+    for (unsigned int id = 1; id <= num; ++id)
+        REQUIRE(resumed[id] == (100 + id - 1) / id);
+}
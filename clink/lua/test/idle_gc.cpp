@@ -0,0 +1,51 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_input_idle.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua idle gc")
+{
+    lua_state lua;
+    lua_input_idle idle(lua);
+    idle.reset();
+
+    lua_State* state = lua.get_state();
+
+    // Let the first idle cycle settle the baseline.
+    for (int i = 0; i < 10000 && idle.get_timeout() != INFINITE; ++i)
+        idle.on_idle();
+    REQUIRE(idle.get_timeout() == INFINITE);
+
+    lua_gc_stats before;
+    lua_input_idle::get_gc_stats(before);
+
+    // Make garbage without giving the collector a chance to keep up.
+    lua_gc(state, LUA_GCSTOP, 0);
+    REQUIRE(lua.do_string("local t = {} for i = 1, 20000 do t[i] = { i, tostring(i) } end t = nil"));
+    lua_gc(state, LUA_GCRESTART, 0);
+    const int garbage_kb = lua_gc(state, LUA_GCCOUNT, 0);
+
+    // Collection is now due, but it waits briefly before starting.
+    const unsigned timeout = idle.get_timeout();
+    REQUIRE(timeout != INFINITE);
+    REQUIRE(timeout > 0);
+
+    // Idle steps finish the cycle and free the garbage.
+    for (int i = 0; i < 10000 && idle.get_timeout() != INFINITE; ++i)
+        idle.on_idle();
+    REQUIRE(idle.get_timeout() == INFINITE);
+    REQUIRE(lua_gc(state, LUA_GCCOUNT, 0) < garbage_kb);
+
+    lua_gc_stats after;
+    lua_input_idle::get_gc_stats(after);
+    REQUIRE(after.idle_cycles > before.idle_cycles);
+    REQUIRE(after.idle_steps > before.idle_steps);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <lua/lua_match_generator.h>
+#include <lua/lua_script_loader.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+// The generator compares the batched accessors against the per-word accessors,
+// and reports the outcome as a match.
+static const char script[] =
+"local g = clink.generator(10)\n"
+"\n"
+"local function check(line_state)\n"
+"    local words = line_state:getwords()\n"
+"    local infos = line_state:getwordinfos()\n"
+"    if not rawequal(words, line_state:getwords()) then return 'nocache' end\n"
+"    if not rawequal(infos, line_state:getwordinfos()) then return 'nocache' end\n"
+"    if #words ~= line_state:getwordcount() then return 'count' end\n"
+"    if #infos ~= line_state:getwordcount() then return 'count' end\n"
+"    for i = 1, line_state:getwordcount() do\n"
+"        if words[i] ~= line_state:getword(i) then return 'word'..i end\n"
+"        local a = infos[i]\n"
+"        local b = line_state:getwordinfo(i)\n"
+"        for _, k in ipairs({ 'offset', 'length', 'quoted', 'delim', 'alias', 'redir' }) do\n"
+"            if a[k] ~= b[k] then return 'info'..i..k end\n"
+"        end\n"
+"    end\n"
+"    return 'ok'\n"
+"end\n"
+"\n"
+"function g:generate(line_state, builder)\n"
+"    if line_state:getword(1) == 'checkcmd' then\n"
+"        builder:addmatch(check(line_state))\n"
+"        return true\n"
+"    end\n"
+"end\n"
+;
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua line_state batched accessors")
+{
+    fs_fixture fs;
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+    REQUIRE(lua.do_string(script, int(strlen(script))));
+
+    line_editor_tester tester;
+    tester.get_editor()->set_generator(lua_generator);
+
+    SECTION("Simple")
+    {
+        tester.set_input("checkcmd abc -x def ");
+        tester.set_expected_matches("ok");
+        tester.run();
+    }
+
+    SECTION("Quotes and redirection")
+    {
+        tester.set_input("checkcmd \"a b\" x\"y\"z >out \"q r\" ");
+        tester.set_expected_matches("ok");
+        tester.run();
+    }
+
+    SECTION("Long line")
+    {
+        str<> input("checkcmd");
+        for (int i = 0; i < 200; ++i)
+        {
+            input.concat(" --flag");
+            input.concat(i & 1 ? "=\"v a l\"" : ":val");
+        }
+        input.concat(" ");
+
+        tester.set_input(input.c_str());
+        tester.set_expected_matches("ok");
+        tester.run();
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2022 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+#include "line_editor_tester.h"
+
+#include <lua/lua_match_generator.h>
+#include <lua/lua_script_loader.h>
+#include <lua/lua_state.h>
+#include <lib/matches_lookaside.h>
+
+//------------------------------------------------------------------------------
+static const char script[] =
+"local g = clink.generator(10)\n"
+"\n"
+"function g:generate(line_state, builder)\n"
+"    local command = line_state:getword(1)\n"
+"    if command == 'listcmd' then\n"
+"        local n, all = builder:addmatchlist({ 'alpha', 'alpine', 'beta', 42, {} }, 'word')\n"
+"        assert(n == 4 and not all)\n"
+"        return true\n"
+"    elseif command == 'speccmd' then\n"
+"        local n, all = builder:addmatchlist({ 'name=', 'nombre=' }, { type='arg', suppressappend=true })\n"
+"        assert(n == 2 and all)\n"
+"        return true\n"
+"    elseif command == 'globcmd' then\n"
+"        builder:addglob(line_state:getendword()..'*', path.getdirectory(line_state:getendword()))\n"
+"        return true\n"
+"    elseif command == 'dirscmd' then\n"
+"        builder:addglob(line_state:getendword()..'*', nil, true)\n"
+"        return true\n"
+"    end\n"
+"end\n"
+;
+
+//------------------------------------------------------------------------------
+static const char* builder_fs[] = {
+    "alpha_file",
+    "alpine_file",
+    "apple/leaf",
+    "apple/stem",
+    nullptr,
+};
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua match builder batches")
+{
+    fs_fixture fs(builder_fs);
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+    REQUIRE(lua.do_string(script, int(strlen(script))));
+
+    line_editor_tester tester;
+    tester.get_editor()->set_generator(lua_generator);
+
+    SECTION("Match list")
+    {
+        tester.set_input("listcmd al");
+        tester.set_expected_matches("alpha", "alpine");
+        tester.run();
+
+        tester.set_input("listcmd 4");
+        tester.set_expected_matches("42");
+        tester.run();
+    }
+
+    SECTION("Match list spec")
+    {
+        tester.set_input("speccmd na" DO_COMPLETE);
+        tester.set_expected_output("speccmd name=");
+        tester.run();
+    }
+
+    SECTION("Glob")
+    {
+        tester.set_input("globcmd al");
+        tester.set_expected_matches("alpha_file", "alpine_file");
+        tester.run();
+
+        tester.set_input("globcmd a");
+        tester.set_expected_matches("alpha_file", "alpine_file", "apple\\");
+        tester.run();
+
+        tester.set_input("globcmd apple\\");
+        tester.set_expected_matches("apple\\leaf", "apple\\stem");
+        tester.run();
+    }
+
+    SECTION("Glob dirs")
+    {
+        tester.set_input("dirscmd a");
+        tester.set_expected_matches("apple\\");
+        tester.run();
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua filter packed matches")
+{
+    static const char filter_script[] =
+    "clink.onfiltermatches(function(matches)\n"
+    "    local keep = {}\n"
+    "    for _, m in ipairs(matches) do\n"
+    "        if m.match:find('^keep') then\n"
+    "            table.insert(keep, m)\n"
+    "        end\n"
+    "    end\n"
+    "    return keep\n"
+    "end)\n"
+    ;
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+    REQUIRE(lua.do_string(filter_script, int(strlen(filter_script))));
+
+    packed_matches_builder builder(4);
+    REQUIRE(builder.add("drop_one", match_type::word, 0, 0, nullptr, nullptr));
+    REQUIRE(builder.add("keep_one", match_type::word, 0, 0, nullptr, nullptr));
+    REQUIRE(builder.add("drop_two", match_type::word, 0, 0, nullptr, nullptr));
+    REQUIRE(builder.add("keep_two", match_type::word, 0, 0, nullptr, nullptr));
+    char** matches = builder.finish("", 0);
+    REQUIRE(matches != nullptr);
+
+    // The discarded matches live in the packed block, so filtering must not
+    // free them individually.
+    lua_generator.filter_matches(matches, '?', false);
+    REQUIRE(strcmp(matches[1], "keep_one") == 0);
+    REQUIRE(strcmp(matches[2], "keep_two") == 0);
+    REQUIRE(matches[3] == nullptr);
+    REQUIRE(is_packed_match(matches[1]));
+    REQUIRE(lookup_match(matches[2]).get_type() == match_type::word);
+
+    for (unsigned int i = 0; matches[i]; ++i)
+        free_match_hook(matches[i]);
+    REQUIRE(destroy_matches_lookaside(matches));
+    free(matches);
+}
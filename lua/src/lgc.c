@@ -1174,9 +1174,21 @@ void luaC_forcestep (lua_State *L) {
 /*
 ** performs a basic GC step only if collector is running
 */
+/* begin_clink_change */
+void (*lua_gcstephook) (int begin) = NULL;
+/* end_clink_change */
+
 void luaC_step (lua_State *L) {
   global_State *g = G(L);
-  if (g->gcrunning) luaC_forcestep(L);
+/* begin_clink_change */
+  //if (g->gcrunning) luaC_forcestep(L);
+  if (g->gcrunning) {
+    void (*hook) (int) = lua_gcstephook;
+    if (hook) hook(1);
+    luaC_forcestep(L);
+    if (hook) hook(0);
+  }
+/* end_clink_change */
   else luaE_setdebt(g, -GCSTEPSIZE);  /* avoid being called too often */
 }
 
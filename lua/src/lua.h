@@ -293,6 +293,12 @@ LUA_API int  (lua_status) (lua_State *L);
 
 LUA_API int (lua_gc) (lua_State *L, int what, int data);
 
+/* begin_clink_change */
+/* If set, called with begin=1 before and begin=0 after each automatic
+** (allocation driven) GC step, so the host can measure where GC time goes. */
+LUA_API void (*lua_gcstephook) (int begin);
+/* end_clink_change */
+
 
 /*
 ** miscellaneous functions
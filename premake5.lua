@@ -467,6 +467,43 @@ clink_exe("clink_test")
         links("gdi32")
         linkgroups("on")
 
+--------------------------------------------------------------------------------
+clink_exe("clink_bench")
+    links("clink_app_common")
+    links("clink_core")
+    links("clink_lib")
+    links("clink_lua")
+    links("clink_process")
+    links("clink_terminal")
+    links("lua")
+    links("readline")
+    links("shlwapi")
+    links("rpcrt4")
+    includedirs("clink/bench/src")
+    includedirs("clink/app/src")
+    includedirs("clink/core/include")
+    includedirs("clink/lib/include")
+    includedirs("clink/lib/include/lib")
+    includedirs("clink/lib/src")
+    includedirs("clink/lua/include")
+    includedirs("clink/terminal/include")
+    includedirs("lua/src")
+    includedirs("readline")
+    includedirs("readline/compat")
+    files("clink/bench/**")
+
+    exceptionhandling("on")
+
+    configuration("vs*")
+        pchheader("pch.h")
+        pchsource("clink/bench/src/pch.cpp")
+
+    configuration("gmake")
+        buildoptions("-fpermissive")
+        buildoptions("-std=c++17")
+        links("gdi32")
+        linkgroups("on")
+
 --------------------------------------------------------------------------------
 require "vstudio"
 local function add_tag(tag, value, project_name)
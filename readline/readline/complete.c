@@ -156,6 +156,7 @@ static char *rl_quote_filename PARAMS((char *, int, char *));
 static void _rl_complete_sigcleanup PARAMS((int, void *));
 
 /* begin_clink_change */
+static void free_match PARAMS((char *));
 /*static*/ void set_completion_defaults PARAMS((int));
 /*static*/ int get_y_or_n PARAMS((int));
 /*static*/ int _rl_internal_pager PARAMS((int));
@@ -281,6 +282,11 @@ int rl_visible_stats = 0;
    freeing a match list.  This can, for instance, allow a host to
    free any data that it had associated with the match list. */
 rl_vcppfunc_t *rl_free_match_list_hook = (rl_vcppfunc_t *)NULL;
+
+/* If non-zero, this is the address of a function to call to free a
+   string in a match list, instead of xfree.  This allows a host to
+   own the strings in the match lists it generates. */
+rl_vcpfunc_t *rl_free_match_hook = (rl_vcpfunc_t *)NULL;
 /* end_clink_change */
 
 /* If non-zero, then this is the address of a function to call when
@@ -1762,7 +1768,9 @@ remove_duplicate_matches (char **matches)
     {
       if (strcmp (matches[i], matches[i + 1]) == 0)
 	{
-	  xfree (matches[i]);
+/* begin_clink_change */
+	  free_match (matches[i]);
+/* end_clink_change */
 	  matches[i] = (char *)&dead_slot;
 	}
       else
@@ -1780,7 +1788,9 @@ remove_duplicate_matches (char **matches)
   temp_array[j] = (char *)NULL;
 
   if (matches[0] != (char *)&dead_slot)
-    xfree (matches[0]);
+/* begin_clink_change */
+    free_match (matches[0]);
+/* end_clink_change */
 
   /* Place the lowest common denominator back in [0]. */
   temp_array[0] = lowest_common;
@@ -1790,7 +1800,9 @@ remove_duplicate_matches (char **matches)
      insert. */
   if (j == 2 && strcmp (temp_array[0], temp_array[1]) == 0)
     {
-      xfree (temp_array[1]);
+/* begin_clink_change */
+      free_match (temp_array[1]);
+/* end_clink_change */
       temp_array[1] = (char *)NULL;
     }
   return (temp_array);
@@ -2756,15 +2768,29 @@ _rl_free_match_list (char **matches)
     return;
 
 /* begin_clink_change */
+  /* Free the strings before calling the hook, since the host may own
+     the strings until the hook releases the match list. */
+  for (i = 0; matches[i]; i++)
+    free_match (matches[i]);
+
   if (rl_free_match_list_hook)
     rl_free_match_list_hook (matches);
 /* end_clink_change */
 
-  for (i = 0; matches[i]; i++)
-    xfree (matches[i]);
   xfree (matches);
 }
 
+/* begin_clink_change */
+static void
+free_match (char *match)
+{
+  if (rl_free_match_hook)
+    rl_free_match_hook (match);
+  else
+    xfree (match);
+}
+/* end_clink_change */
+
 /* Compare a possibly-quoted filename TEXT from the line buffer and a possible
    MATCH that is the product of filename completion, which acts on the dequoted
    text. */
@@ -3703,7 +3729,10 @@ rl_old_menu_complete (int count, int invoking_key)
  */
       if (matches && matches[0] && matches[1] && !matches[2])
 	{
-	  xfree (matches[0]);
+/* begin_clink_change */
+	  //xfree (matches[0]);
+	  free_match (matches[0]);
+/* end_clink_change */
 	  matches[0] = matches[1];
 	  matches[1] = NULL;
 	}
@@ -82,4 +82,9 @@ extern char *strchr ();
 /* histsearch.c */
 extern int _hs_history_patsearch PARAMS((const char *, int, int));
 
+/* begin_clink_change */
+/* history.c */
+extern void _hs_replace_history_line PARAMS((HIST_ENTRY *, const char *));
+/* end_clink_change */
+
 #endif /* !_HISTLIB_H_ */
@@ -64,6 +64,28 @@ extern int errno;
 
 static char *hist_inittime PARAMS((void));
 
+/* begin_clink_change */
+/* Entries added by add_history_bulk() are carved, together with their lines,
+   out of large arena blocks, instead of costing three allocations each.  Each
+   block counts its live entries and is freed when the last one is freed. */
+typedef struct _hist_arena {
+  struct _hist_arena *next;
+  char *ptr;			/* next free byte */
+  char *end;
+  char *timestamp;		/* shared by all entries in the block */
+  int live;
+} HIST_ARENA;
+
+#define HIST_ARENA_MIN_SIZE	(64 * 1024)
+#define HIST_ARENA_ALIGN(n)	(((n) + sizeof (void *) - 1) & ~(sizeof (void *) - 1))
+
+static HIST_ARENA *hist_arenas = (HIST_ARENA *)NULL;
+static HIST_ARENA *hist_bulk_arena = (HIST_ARENA *)NULL;
+
+static int hist_make_room PARAMS((int *));
+static HIST_ARENA *hist_arena_find PARAMS((const void *));
+/* end_clink_change */
+
 /* **************************************************************** */
 /*								    */
 /*			History Functions			    */
@@ -289,6 +311,26 @@ add_history (const char *string)
   HIST_ENTRY *temp;
   int new_length;
 
+/* begin_clink_change */
+  if (!hist_make_room (&new_length))
+    return;
+
+  temp = alloc_history_entry ((char *)string, hist_inittime ());
+
+  the_history[new_length] = (HIST_ENTRY *)NULL;
+  the_history[new_length - 1] = temp;
+  history_length = new_length;
+}
+
+/* Makes room for one more entry at the end of the history list, and sets
+   *NEW_LENGTH to the length the list will have with it.  Returns zero if the
+   history is stifled to zero entries. */
+static int
+hist_make_room (int *new_length_out)
+{
+  int new_length;
+/* end_clink_change */
+
   if (history_stifled && (history_length == history_max_entries))
     {
       register int i;
@@ -296,7 +338,9 @@ add_history (const char *string)
       /* If the history is stifled, and history_length is zero,
 	 and it equals history_max_entries, we don't save items. */
       if (history_length == 0)
-	return;
+/* begin_clink_change */
+	return 0;
+/* end_clink_change */
 
       /* If there is something in the slot, then remove it. */
       if (the_history[0])
@@ -326,6 +370,13 @@ add_history (const char *string)
 	{
 	  if (history_length == (history_size - 1))
 	    {
+/* begin_clink_change */
+	      /* Grow geometrically while bulk loading, since the count passed
+		 to begin_history_bulk_load() is only an estimate. */
+	      if (hist_bulk_arena)
+		history_size += history_size;
+	      else
+/* end_clink_change */
 	      history_size += DEFAULT_HISTORY_GROW_SIZE;
 	      the_history = (HIST_ENTRY **)
 		xrealloc (the_history, history_size * sizeof (HIST_ENTRY *));
@@ -334,13 +385,142 @@ add_history (const char *string)
 	}
     }
 
-  temp = alloc_history_entry ((char *)string, hist_inittime ());
+/* begin_clink_change */
+  *new_length_out = new_length;
+  return 1;
+}
+
+static HIST_ARENA *
+hist_arena_new (size_t size)
+{
+  HIST_ARENA *arena;
+  char *ts;
+  size_t ts_size;
+
+  ts = hist_inittime ();
+  ts_size = HIST_ARENA_ALIGN (strlen (ts) + 1);
+
+  arena = (HIST_ARENA *)xmalloc (HIST_ARENA_ALIGN (sizeof (HIST_ARENA)) + ts_size + size);
+  arena->timestamp = (char *)arena + HIST_ARENA_ALIGN (sizeof (HIST_ARENA));
+  strcpy (arena->timestamp, ts);
+  xfree (ts);
+
+  arena->ptr = arena->timestamp + ts_size;
+  arena->end = arena->ptr + size;
+  arena->live = 0;
+  arena->next = hist_arenas;
+  hist_arenas = arena;
+  return arena;
+}
+
+/* Returns the arena block containing P, or NULL. */
+static HIST_ARENA *
+hist_arena_find (const void *p)
+{
+  HIST_ARENA *arena;
+
+  for (arena = hist_arenas; arena; arena = arena->next)
+    if ((const char *)p > (const char *)arena && (const char *)p < arena->end)
+      return arena;
+  return (HIST_ARENA *)NULL;
+}
+
+static void
+hist_arena_release (HIST_ARENA *arena)
+{
+  HIST_ARENA **link;
+
+  for (link = &hist_arenas; *link; link = &(*link)->next)
+    if (*link == arena)
+      {
+	*link = arena->next;
+	break;
+      }
+  if (hist_bulk_arena == arena)
+    hist_bulk_arena = (HIST_ARENA *)NULL;
+  xfree (arena);
+}
+
+/* Prepare to add about COUNT entries totalling about BYTES of text with
+   add_history_bulk().  The history list is grown once to fit them, and one
+   arena block is allocated to hold them. */
+void
+begin_history_bulk_load (int count, size_t bytes)
+{
+  int needed;
+
+  if (count < 0)
+    count = 0;
+  if (history_stifled && count > history_max_entries)
+    count = history_max_entries;
+
+  needed = history_length + count + 2;
+  if (needed > history_size)
+    {
+      history_size = needed;
+      the_history = (HIST_ENTRY **)
+	xrealloc (the_history, history_size * sizeof (HIST_ENTRY *));
+    }
+
+  bytes += count * (HIST_ARENA_ALIGN (sizeof (HIST_ENTRY)) + sizeof (void *));
+  hist_bulk_arena = hist_arena_new (bytes > HIST_ARENA_MIN_SIZE ? bytes : HIST_ARENA_MIN_SIZE);
+}
+
+/* Place LEN bytes of STRING at the end of the history list, like add_history()
+   but allocating from the bulk load arena.  If LEN is negative, STRING is
+   NUL terminated. */
+void
+add_history_bulk (const char *string, int len)
+{
+  HIST_ENTRY *temp;
+  HIST_ARENA *arena;
+  size_t size;
+  int new_length;
+
+  if (hist_bulk_arena == 0)
+    {
+      add_history (string);
+      return;
+    }
+
+  if (!hist_make_room (&new_length))
+    return;
+
+  if (len < 0)
+    len = strlen (string);
+
+  size = HIST_ARENA_ALIGN (sizeof (HIST_ENTRY)) + HIST_ARENA_ALIGN (len + 1);
+  arena = hist_bulk_arena;
+  if ((size_t)(arena->end - arena->ptr) < size)
+    arena = hist_bulk_arena = hist_arena_new (size > HIST_ARENA_MIN_SIZE ? size : HIST_ARENA_MIN_SIZE);
+
+  temp = (HIST_ENTRY *)arena->ptr;
+  temp->line = arena->ptr + HIST_ARENA_ALIGN (sizeof (HIST_ENTRY));
+  memcpy (temp->line, string, len);
+  temp->line[len] = '\0';
+  temp->timestamp = arena->timestamp;
+  temp->data = (histdata_t)NULL;
+  arena->ptr += size;
+  arena->live++;
 
   the_history[new_length] = (HIST_ENTRY *)NULL;
   the_history[new_length - 1] = temp;
   history_length = new_length;
 }
 
+/* Finish adding entries with add_history_bulk(). */
+void
+end_history_bulk_load (void)
+{
+  HIST_ARENA *arena;
+
+  arena = hist_bulk_arena;
+  hist_bulk_arena = (HIST_ARENA *)NULL;
+  if (arena && arena->live == 0)
+    hist_arena_release (arena);
+}
+/* end_clink_change */
+
 /* Change the time stamp of the most recent history entry to STRING. */
 void
 add_history_time (const char *string)
@@ -350,6 +530,9 @@ add_history_time (const char *string)
   if (string == 0 || history_length < 1)
     return;
   hs = the_history[history_length - 1];
+/* begin_clink_change */
+  if (!hist_arena_find (hs->timestamp))
+/* end_clink_change */
   FREE (hs->timestamp);
   hs->timestamp = savestring (string);
 }
@@ -360,9 +543,28 @@ histdata_t
 free_history_entry (HIST_ENTRY *hist)
 {
   histdata_t x;
+/* begin_clink_change */
+  HIST_ARENA *arena;
+/* end_clink_change */
 
   if (hist == 0)
     return ((histdata_t) 0);
+/* begin_clink_change */
+  arena = hist_arena_find (hist);
+  if (arena)
+    {
+      /* The line may have been reallocated by _hs_append_history_line, and
+	 the timestamp replaced by add_history_time. */
+      if (hist_arena_find (hist->line) != arena)
+	FREE (hist->line);
+      if (hist_arena_find (hist->timestamp) != arena)
+	FREE (hist->timestamp);
+      x = hist->data;
+      if (--arena->live == 0 && arena != hist_bulk_arena)
+	hist_arena_release (arena);
+      return (x);
+    }
+/* end_clink_change */
   FREE (hist->line);
   FREE (hist->timestamp);
   x = hist->data;
@@ -435,6 +637,16 @@ _hs_append_history_line (int which, const char *line)
     newlen = minlen;
   /* Assume that realloc returns the same pointer and doesn't try a new
      alloc/copy if the new size is the same as the one last passed. */
+/* begin_clink_change */
+  /* A line in an arena block can't be reallocated; copy it instead. */
+  if (hist_arena_find (hent->line))
+    {
+      newline = malloc (newlen);
+      if (newline)
+	memcpy (newline, hent->line, curlen + 1);
+    }
+  else
+/* end_clink_change */
   newline = realloc (hent->line, newlen);
   if (newline)
     {
@@ -444,6 +656,22 @@ _hs_append_history_line (int which, const char *line)
     }
 }
 
+/* begin_clink_change */
+/* Replace the line of history entry HENT with a copy of LINE.  A line in an
+   arena block can't be freed on its own; free_history_entry() releases it
+   along with the block. */
+void
+_hs_replace_history_line (HIST_ENTRY *hent, const char *line)
+{
+  char *newline;
+
+  newline = savestring (line);
+  if (hist_arena_find (hent->line) == 0)
+    FREE (hent->line);
+  hent->line = newline;
+}
+/* end_clink_change */
+
 /* Replace the DATA in the specified history entries, replacing OLD with
    NEW.  WHICH says which one(s) to replace:  WHICH == -1 means to replace
    all of the history entries where entry->data == OLD; WHICH == -2 means
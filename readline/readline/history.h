@@ -86,6 +86,16 @@ extern void add_history PARAMS((const char *));
    STRING. */
 extern void add_history_time PARAMS((const char *));
 
+/* begin_clink_change */
+/* Add many entries at once:  begin_history_bulk_load() sizes the history list
+   and an arena for about COUNT entries totalling about BYTES of text, then
+   add_history_bulk() adds each entry like add_history(), and
+   end_history_bulk_load() finishes. */
+extern void begin_history_bulk_load PARAMS((int, size_t));
+extern void add_history_bulk PARAMS((const char *, int));
+extern void end_history_bulk_load PARAMS((void));
+/* end_clink_change */
+
 /* Remove an entry from the history list.  WHICH is the magic number that
    tells us which element to delete.  The elements are numbered from 0. */
 extern HIST_ENTRY *remove_history PARAMS((int));
@@ -332,10 +332,10 @@ _rl_free_history_entry (HIST_ENTRY *entry)
   if (entry == 0)
     return;
 
-  FREE (entry->line);
-  FREE (entry->timestamp);
-
-  xfree (entry);
+/* begin_clink_change */
+  /* The entry may have been allocated by add_history_bulk(). */
+  free_history_entry (entry);
+/* end_clink_change */
 }
 
 /* Perhaps put back the current line if it has changed. */
@@ -349,9 +349,9 @@ rl_maybe_replace_line (void)
   if (temp && ((UNDO_LIST *)(temp->data) != rl_undo_list))
     {
       temp = replace_history_entry (where_history (), rl_line_buffer, (histdata_t)rl_undo_list);
-      xfree (temp->line);
-      FREE (temp->timestamp);
-      xfree (temp);
+/* begin_clink_change */
+      _rl_free_history_entry (temp);
+/* end_clink_change */
     }
   return 0;
 }
@@ -470,8 +470,10 @@ _rl_revert_previous_lines (void)
 	    rl_do_undo ();
 	  /* And copy the reverted line back to the history entry, preserving
 	     the timestamp. */
-	  FREE (entry->line);
-	  entry->line = savestring (rl_line_buffer);
+/* begin_clink_change */
+	  /* The entry may have been allocated by add_history_bulk(). */
+	  _hs_replace_history_line (entry, rl_line_buffer);
+/* end_clink_change */
 	}
       entry = previous_history ();
     }
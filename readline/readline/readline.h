@@ -870,6 +870,11 @@ extern const char *rl_special_prefixes;
    freeing a match list.  This can, for instance, allow a host to
    free any data that it had associated with the match list. */
 extern rl_vcppfunc_t *rl_free_match_list_hook;
+
+/* If non-zero, this is the address of a function to call to free a
+   string in a match list, instead of xfree.  This allows a host to
+   own the strings in the match lists it generates. */
+extern rl_vcpfunc_t *rl_free_match_hook;
 /* end_clink_change */
 
 /* If non-zero, then this is the address of a function to call when
@@ -235,9 +235,9 @@ rl_do_undo (void)
       if (cur && cur->data && (UNDO_LIST *)cur->data == release)
 	{
 	  temp = replace_history_entry (where_history (), rl_line_buffer, (histdata_t)rl_undo_list);
-	  xfree (temp->line);
-	  FREE (temp->timestamp);
-	  xfree (temp);
+/* begin_clink_change */
+	  free_history_entry (temp);
+/* end_clink_change */
 	}
 
       /* Make sure there aren't any history entries with that undo list */